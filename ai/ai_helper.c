@@ -1,4 +1,7 @@
 #include "ai_helper.h"
+#include "../db/parser.h"
+#include "../db/executor.h"
+#include "../db/stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -160,7 +163,8 @@ char* enhance_sql_statement(const char* sql, const Table* table) {
             strcpy(optimized, "Suggestion: Use specific column names instead of * to improve performance");
         }
     } else if (strstr(sql_upper, "LIKE '%") != NULL) {
-        strcpy(optimized, "Suggestion: Leading wildcard searches (LIKE '%...') cannot use indexes, try other methods");
+        strcpy(optimized, "Suggestion: Leading wildcard searches (LIKE '%...') cannot use hash or sorted indexes; "
+                          "CREATE INDEX ... USING TRIGRAM on the column lets them use a trigram index");
     } else if (strstr(sql_upper, "ORDER BY") == NULL && strstr(sql_upper, "WHERE") != NULL) {
         strcpy(optimized, "Query looks OK. Add ORDER BY if you need sorting");
     } else {
@@ -172,49 +176,62 @@ char* enhance_sql_statement(const char* sql, const Table* table) {
 
 
 
-//elucidate the execution plan of a SQL query
+//copy a fixed message into a newly allocated string
+static char* copy_message(const char* message) {
+    char* copy = malloc(strlen(message) + 1);
+    if (copy != NULL) {
+        strcpy(copy, message);
+    }
+    return copy;
+}
+
+//elucidate the execution plan of a SQL query: the same operator tree EXPLAIN prints
 char* elucidate_query_execution(const char* sql, const Table* table) {
     if (sql == NULL) {
         return NULL;
     }
 
-    char* explanation = malloc(512);
-    if (explanation == NULL) {
-        return NULL;
+    Query* query = parse_query(sql);
+    if (query == NULL || query->type == QUERY_CREATE_INDEX || query->type == QUERY_ANALYZE) {
+        free_query(query);
+        return copy_message("Cannot understand query type, check SQL syntax");
     }
-
-    char sql_upper[512];
-    strncpy(sql_upper, sql, sizeof(sql_upper) - 1);
-    sql_upper[sizeof(sql_upper) - 1] = '\0';
-    
-    for (char* p = sql_upper; *p; p++) {
-        *p = toupper(*p);
+    if (table == NULL || query->join_table[0] != '\0') {
+        free_query(query);
+        return copy_message("Query plan needs the queried table; for joins run EXPLAIN in the SQL prompt");
     }
 
+    QueryPlan plan;
+    plan_query(table, query, &plan);
+    free_query(query);
+    Table* steps = plan_table(&plan, 0);
+    if (steps == NULL) {
+        return NULL;
+    }
 
+    /* one line per operator: root first, children indented */
+    size_t size = 256;
+    for (int row = 0; row < steps->row_count; row++) {
+        size += strlen(steps->data[row][0]) + 64;
+    }
+    char* explanation = malloc(size);
+    if (explanation == NULL) {
+        free_table(steps);
+        return NULL;
+    }
 
-    /* 简单的查询计划解释 */
-    if (strstr(sql_upper, "SELECT") != NULL) {
-        strcpy(explanation, "Query plan:\n");
-        
-        if (strstr(sql_upper, "WHERE") != NULL) {
-            strcat(explanation, "1. Apply WHERE condition filter\n");
-        }
-        
-        if (strstr(sql_upper, "ORDER BY") != NULL) {
-            strcat(explanation, "2. Sort the results\n");
-        }
-        
-        strcat(explanation, "3. Return query results");
-        
-        if (table != NULL) {
-            char temp[200];
-            sprintf(temp, "\nWill process about %d rows", table->row_count);
-            strcat(explanation, temp);
-        }
+    strcpy(explanation, "Query plan:\n");
+    for (int row = 0; row < steps->row_count; row++) {
+        size_t len = strlen(explanation);
+        snprintf(explanation + len, size - len, "%s  (rows=%s, cost=%s)\n",
+                 steps->data[row][0], steps->data[row][1], steps->data[row][2]);
+    }
+    size_t len = strlen(explanation);
+    if (table_column_stats(table, 0) == NULL) {
+        snprintf(explanation + len, size - len, "Estimates are guesses; run ANALYZE %s for statistics", table->name);
     } else {
-        strcpy(explanation, "Cannot understand query type, check SQL syntax");
+        snprintf(explanation + len, size - len, "Estimates use ANALYZE statistics of %s", table->name);
     }
-
+    free_table(steps);
     return explanation;
 }
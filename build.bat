@@ -14,6 +14,23 @@ gcc -Wall -Wextra -std=c99 -g -I. -c db/csv_loader.c -o build/db/csv_loader.o
 gcc -Wall -Wextra -std=c99 -g -I. -c db/parser.c -o build/db/parser.o
 gcc -Wall -Wextra -std=c99 -g -I. -c db/executor.c -o build/db/executor.o
 gcc -Wall -Wextra -std=c99 -g -I. -c db/result.c -o build/db/result.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/column_store.c -o build/db/column_store.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/arena.c -o build/db/arena.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/view.c -o build/db/view.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/sort.c -o build/db/sort.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/csv_scan.c -o build/db/csv_scan.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/snapshot.c -o build/db/snapshot.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/predicate.c -o build/db/predicate.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/batch.c -o build/db/batch.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/value_set.c -o build/db/value_set.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/aggregate.c -o build/db/aggregate.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/catalog.c -o build/db/catalog.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/join.c -o build/db/join.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/index.c -o build/db/index.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/roaring.c -o build/db/roaring.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/like.c -o build/db/like.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/stats.c -o build/db/stats.o
+gcc -Wall -Wextra -std=c99 -g -I. -c db/explain.c -o build/db/explain.o
 gcc -Wall -Wextra -std=c99 -g -I. -c test_framework/test_loader.c -o build/test_framework/test_loader.o
 gcc -Wall -Wextra -std=c99 -g -I. -c test_framework/test_runner.c -o build/test_framework/test_runner.o
 gcc -Wall -Wextra -std=c99 -g -I. -c test_framework/test_reporter.c -o build/test_framework/test_reporter.o
@@ -27,6 +44,23 @@ gcc build/main.o ^
     build/db/parser.o ^
     build/db/executor.o ^
     build/db/result.o ^
+    build/db/column_store.o ^
+    build/db/arena.o ^
+    build/db/view.o ^
+    build/db/sort.o ^
+    build/db/csv_scan.o ^
+    build/db/snapshot.o ^
+    build/db/predicate.o ^
+    build/db/batch.o ^
+    build/db/value_set.o ^
+    build/db/aggregate.o ^
+    build/db/catalog.o ^
+    build/db/join.o ^
+    build/db/index.o ^
+    build/db/roaring.o ^
+    build/db/like.o ^
+    build/db/stats.o ^
+    build/db/explain.o ^
     build/test_framework/test_loader.o ^
     build/test_framework/test_runner.o ^
     build/test_framework/test_reporter.o ^
@@ -0,0 +1,935 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "aggregate.h"
+#include "column_store.h"
+#include "hash.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+#define AGGREGATE_BATCH 1024
+#define AGGREGATE_MORSEL (16 * AGGREGATE_BATCH)
+#define AGGREGATE_PARTITION_BITS 6
+#define AGGREGATE_PARTITIONS (1 << AGGREGATE_PARTITION_BITS)
+#define MAX_AGGREGATE_THREADS 64
+#define PARALLEL_MIN_ROWS (256 * 1024)
+#define MIN_GROUP_CAPACITY 16
+#define NULL_KEY_HASH 0x9e3779b97f4a7c15ULL
+
+// 累加器: count为参与聚合的非空值个数 (COUNT(*)为行数)，value按源列类型保存SUM/MIN/MAX的当前值
+// 浮点SUM/AVG用补偿求和 (Neumaier)，compensation是value.f中累计丢掉的低位，结果为两者之和
+// 整数SUM/AVG溢出long long时widened置1，改为在value.f中按浮点补偿求和，不返回回绕的值
+typedef struct {
+    long long count;
+    union {
+        long long i;
+        double f;
+        const char* s;
+    } value;
+    double compensation;
+    int widened;
+} Accumulator;
+
+// 分组列: 类型化数值列按数值比较，其他列按单元格字符串比较
+typedef struct {
+    int col_index;
+    const ColumnVector* column;   // NULL表示按字符串
+} GroupKey;
+
+// 解析后的聚合表达式
+typedef struct {
+    AggregateType type;
+    int col_index;                // COUNT(*)为-1
+    const ColumnVector* column;   // 数值列的类型化向量，NULL表示按单元格字符串
+    const unsigned char* nulls;   // 列式存储的空值标记，NULL表示按单元格是否为NULL判断
+} AggregateExpr;
+
+// 聚合计划: 分组列、聚合表达式以及输出列的来源
+typedef struct {
+    GroupKey keys[MAX_COLUMNS];
+    int key_count;
+    AggregateExpr aggs[MAX_COLUMNS];
+    int agg_count;
+    int outputs[MAX_COLUMNS];     // >=0 为分组列序号，<0 为 -(聚合序号+1)
+    char names[MAX_COLUMNS][MAX_COLUMN_NAME_LEN];
+    int output_count;
+} AggregatePlan;
+
+// 分组哈希表: 开放寻址 + 线性探测，槽位里存组号；每组记住第一行作为键的代表，不复制键值
+typedef struct {
+    int* slots;                        // 组号，-1表示空槽
+    int slot_capacity;                 // 2的幂，装载因子不超过1/2
+    uint64_t* hashes;                  // 每组键的哈希
+    int* first_rows;                   // 每组的代表行
+    Accumulator* states[MAX_COLUMNS];  // 每个聚合一个按组号索引的累加器数组
+    int agg_count;
+    int group_count;
+    int group_capacity;
+} GroupTable;
+
+const char* aggregate_name(AggregateType type) {
+    switch (type) {
+        case AGG_COUNT: return "COUNT";
+        case AGG_SUM: return "SUM";
+        case AGG_AVG: return "AVG";
+        case AGG_MAX: return "MAX";
+        case AGG_MIN: return "MIN";
+        default: return NULL;
+    }
+}
+
+static const ColumnVector* numeric_column(const Table* table, int col_index) {
+    if (table->store == NULL || !column_is_numeric(&table->store->columns[col_index])) {
+        return NULL;
+    }
+    return &table->store->columns[col_index];
+}
+
+static const char* cell_text(const Table* table, int row, int col) {
+    const char* cell = table->data[row][col];
+    return (cell != NULL) ? cell : "";
+}
+
+// 解析SELECT列表: 普通列必须出现在GROUP BY中
+static int build_plan(const Table* table, const Query* query, AggregatePlan* plan) {
+    memset(plan, 0, sizeof(AggregatePlan));
+    if (query->column_count == 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < query->group_by_count; i++) {
+        int col = get_column_index(table, query->group_by[i]);
+        if (col == -1) {
+            return -1;
+        }
+        plan->keys[i].col_index = col;
+        plan->keys[i].column = numeric_column(table, col);
+    }
+    plan->key_count = query->group_by_count;
+
+    for (int i = 0; i < query->column_count; i++) {
+        AggregateType type = query->aggregates[i];
+        int col = (strcmp(query->columns[i], "*") == 0) ? -1 : get_column_index(table, query->columns[i]);
+        if (col == -1 && !(type == AGG_COUNT && strcmp(query->columns[i], "*") == 0)) {
+            return -1;
+        }
+
+        if (type == AGG_NONE) {
+            int key = 0;
+            while (key < plan->key_count && plan->keys[key].col_index != col) {
+                key++;
+            }
+            if (key == plan->key_count) {
+                return -1;
+            }
+            plan->outputs[i] = key;
+            strcpy(plan->names[i], table->columns[col].name);
+            continue;
+        }
+
+        AggregateExpr* agg = &plan->aggs[plan->agg_count];
+        agg->type = type;
+        agg->col_index = col;
+        if (col >= 0) {
+            agg->column = numeric_column(table, col);
+            agg->nulls = (table->store != NULL) ? table->store->columns[col].nulls : NULL;
+        }
+        plan->outputs[i] = -(plan->agg_count + 1);
+        plan->agg_count++;
+        snprintf(plan->names[i], MAX_COLUMN_NAME_LEN, "%s(%.40s)", aggregate_name(type),
+                 (col >= 0) ? table->columns[col].name : "*");
+    }
+    plan->output_count = query->column_count;
+    return 0;
+}
+
+static int is_count_star_only(const AggregatePlan* plan) {
+    if (plan->key_count > 0) {
+        return 0;
+    }
+    for (int a = 0; a < plan->agg_count; a++) {
+        if (plan->aggs[a].type != AGG_COUNT || plan->aggs[a].col_index != -1) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int is_null_value(const AggregateExpr* agg, const Table* table, int row) {
+    if (agg->nulls != NULL) {
+        return agg->nulls[row];
+    }
+    return table->data[row][agg->col_index] == NULL;
+}
+
+// 浮点键: -0.0与0.0视为同一组，所有NaN视为同一组
+static uint64_t double_key(double value) {
+    if (value == 0.0) {
+        value = 0.0;
+    }
+    if (value != value) {
+        return 0x7ff8000000000000ULL;
+    }
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// 按批计算分组键的哈希，每个分组列一个紧凑循环
+static void hash_keys(const Table* table, const AggregatePlan* plan, const int* rows, int n, uint64_t* hashes) {
+    memset(hashes, 0, n * sizeof(uint64_t));
+
+    for (int k = 0; k < plan->key_count; k++) {
+        const GroupKey* key = &plan->keys[k];
+        const ColumnVector* column = key->column;
+
+        if (column != NULL && column->type == TYPE_INT) {
+            for (int i = 0; i < n; i++) {
+                int row = rows[i];
+                uint64_t h = column->nulls[row] ? NULL_KEY_HASH : hash_u64((uint64_t)column->ints[row]);
+                hashes[i] = hash_u64(hashes[i] + h);
+            }
+        } else if (column != NULL) {
+            for (int i = 0; i < n; i++) {
+                int row = rows[i];
+                uint64_t h = column->nulls[row] ? NULL_KEY_HASH : hash_u64(double_key(column->floats[row]));
+                hashes[i] = hash_u64(hashes[i] + h);
+            }
+        } else {
+            for (int i = 0; i < n; i++) {
+                hashes[i] = hash_u64(hashes[i] + hash_string(cell_text(table, rows[i], key->col_index)));
+            }
+        }
+    }
+}
+
+static int keys_equal(const Table* table, const AggregatePlan* plan, int a, int b) {
+    for (int k = 0; k < plan->key_count; k++) {
+        const GroupKey* key = &plan->keys[k];
+        const ColumnVector* column = key->column;
+
+        if (column == NULL) {
+            if (strcmp(cell_text(table, a, key->col_index), cell_text(table, b, key->col_index)) != 0) {
+                return 0;
+            }
+            continue;
+        }
+
+        if (column->nulls[a] || column->nulls[b]) {
+            if (column->nulls[a] != column->nulls[b]) {
+                return 0;
+            }
+        } else if (column->type == TYPE_INT) {
+            if (column->ints[a] != column->ints[b]) {
+                return 0;
+            }
+        } else if (double_key(column->floats[a]) != double_key(column->floats[b])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int group_table_init(GroupTable* groups, int agg_count) {
+    memset(groups, 0, sizeof(GroupTable));
+    groups->agg_count = agg_count;
+    groups->group_capacity = MIN_GROUP_CAPACITY;
+    groups->slot_capacity = MIN_GROUP_CAPACITY * 2;
+
+    groups->slots = malloc(groups->slot_capacity * sizeof(int));
+    groups->hashes = malloc(groups->group_capacity * sizeof(uint64_t));
+    groups->first_rows = malloc(groups->group_capacity * sizeof(int));
+    int failed = (groups->slots == NULL || groups->hashes == NULL || groups->first_rows == NULL);
+    for (int a = 0; a < agg_count; a++) {
+        groups->states[a] = malloc(groups->group_capacity * sizeof(Accumulator));
+        failed |= (groups->states[a] == NULL);
+    }
+    if (!failed) {
+        memset(groups->slots, -1, groups->slot_capacity * sizeof(int));
+    }
+    return failed ? -1 : 0;
+}
+
+static void group_table_free(GroupTable* groups) {
+    free(groups->slots);
+    free(groups->hashes);
+    free(groups->first_rows);
+    for (int a = 0; a < groups->agg_count; a++) {
+        free(groups->states[a]);
+    }
+}
+
+static int grow_groups(GroupTable* groups) {
+    int capacity = groups->group_capacity * 2;
+
+    uint64_t* hashes = realloc(groups->hashes, capacity * sizeof(uint64_t));
+    if (hashes == NULL) {
+        return -1;
+    }
+    groups->hashes = hashes;
+
+    int* first_rows = realloc(groups->first_rows, capacity * sizeof(int));
+    if (first_rows == NULL) {
+        return -1;
+    }
+    groups->first_rows = first_rows;
+
+    for (int a = 0; a < groups->agg_count; a++) {
+        Accumulator* states = realloc(groups->states[a], capacity * sizeof(Accumulator));
+        if (states == NULL) {
+            return -1;
+        }
+        groups->states[a] = states;
+    }
+    groups->group_capacity = capacity;
+    return 0;
+}
+
+// 槽位数组翻倍，用保存的哈希重新放置各组
+static int grow_slots(GroupTable* groups) {
+    int capacity = groups->slot_capacity * 2;
+    int* slots = malloc(capacity * sizeof(int));
+    if (slots == NULL) {
+        return -1;
+    }
+    memset(slots, -1, capacity * sizeof(int));
+
+    int mask = capacity - 1;
+    for (int g = 0; g < groups->group_count; g++) {
+        int slot = (int)(groups->hashes[g] & mask);
+        while (slots[slot] != -1) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = g;
+    }
+
+    free(groups->slots);
+    groups->slots = slots;
+    groups->slot_capacity = capacity;
+    return 0;
+}
+
+// 在槽位slot上登记新组，返回组号
+static int add_group(GroupTable* groups, int slot, uint64_t hash, int row) {
+    if (groups->group_count == groups->group_capacity && grow_groups(groups) != 0) {
+        return -1;
+    }
+
+    int group = groups->group_count++;
+    groups->hashes[group] = hash;
+    groups->first_rows[group] = row;
+    for (int a = 0; a < groups->agg_count; a++) {
+        memset(&groups->states[a][group], 0, sizeof(Accumulator));
+    }
+    groups->slots[slot] = group;
+
+    if (groups->group_count * 2 > groups->slot_capacity && grow_slots(groups) != 0) {
+        return -1;
+    }
+    return group;
+}
+
+static int find_or_add_group(GroupTable* groups, const Table* table, const AggregatePlan* plan,
+                             int row, uint64_t hash) {
+    int mask = groups->slot_capacity - 1;
+    int slot = (int)(hash & mask);
+    for (;;) {
+        int group = groups->slots[slot];
+        if (group == -1) {
+            return add_group(groups, slot, hash, row);
+        }
+        if (groups->hashes[group] == hash && keys_equal(table, plan, groups->first_rows[group], row)) {
+            return group;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+// 解析单元格中的数值，空值和非数字返回0
+static int text_number(const char* cell, double* out) {
+    if (cell == NULL || cell[0] == '\0') {
+        return 0;
+    }
+    char* end;
+    *out = strtod(cell, &end);
+    return *end == '\0';
+}
+
+// 补偿求和: 把value加到s->value.f，本次舍入丢掉的部分记入compensation
+static void add_compensated(Accumulator* s, double value) {
+    double sum = s->value.f + value;
+    if (fabs(s->value.f) >= fabs(value)) {
+        s->compensation += (s->value.f - sum) + value;
+    } else {
+        s->compensation += (value - sum) + s->value.f;
+    }
+    s->value.f = sum;
+}
+
+// 整数累加: 溢出时把已有的和转成double，之后按浮点累加
+static void add_int(Accumulator* s, long long value) {
+    long long sum;
+    if (s->widened) {
+        add_compensated(s, (double)value);
+    } else if (__builtin_add_overflow(s->value.i, value, &sum)) {
+        s->value.f = (double)s->value.i;
+        s->compensation = 0.0;
+        s->widened = 1;
+        add_compensated(s, (double)value);
+    } else {
+        s->value.i = sum;
+    }
+}
+
+// 一批行更新一个聚合的累加器 (targets[i]为第i行所在组的累加器)，按 (聚合类型, 列类型) 分成紧凑循环
+static void accumulate_batch(const Table* table, const AggregateExpr* agg, Accumulator* const* targets,
+                             const int* rows, int n) {
+    const ColumnVector* column = agg->column;
+
+    if (agg->type == AGG_COUNT) {
+        for (int i = 0; i < n; i++) {
+            if (agg->col_index < 0 || !is_null_value(agg, table, rows[i])) {
+                targets[i]->count++;
+            }
+        }
+        return;
+    }
+
+    if (agg->type == AGG_SUM || agg->type == AGG_AVG) {
+        if (column != NULL && column->type == TYPE_INT) {
+            for (int i = 0; i < n; i++) {
+                int row = rows[i];
+                Accumulator* s = targets[i];
+                add_int(s, column->nulls[row] ? 0 : column->ints[row]);
+                s->count += !column->nulls[row];
+            }
+        } else if (column != NULL) {
+            for (int i = 0; i < n; i++) {
+                int row = rows[i];
+                Accumulator* s = targets[i];
+                add_compensated(s, column->nulls[row] ? 0.0 : column->floats[row]);
+                s->count += !column->nulls[row];
+            }
+        } else {
+            for (int i = 0; i < n; i++) {
+                double value;
+                if (text_number(table->data[rows[i]][agg->col_index], &value)) {
+                    add_compensated(targets[i], value);
+                    targets[i]->count++;
+                }
+            }
+        }
+        return;
+    }
+
+    int want_max = (agg->type == AGG_MAX);
+    if (column != NULL && column->type == TYPE_INT) {
+        for (int i = 0; i < n; i++) {
+            int row = rows[i];
+            if (column->nulls[row]) {
+                continue;
+            }
+            Accumulator* s = targets[i];
+            long long value = column->ints[row];
+            if (s->count == 0 || (want_max ? value > s->value.i : value < s->value.i)) {
+                s->value.i = value;
+            }
+            s->count++;
+        }
+    } else if (column != NULL) {
+        for (int i = 0; i < n; i++) {
+            int row = rows[i];
+            if (column->nulls[row]) {
+                continue;
+            }
+            Accumulator* s = targets[i];
+            double value = column->floats[row];
+            if (s->count == 0 || (want_max ? value > s->value.f : value < s->value.f)) {
+                s->value.f = value;
+            }
+            s->count++;
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            const char* value = table->data[rows[i]][agg->col_index];
+            if (value == NULL) {
+                continue;
+            }
+            Accumulator* s = targets[i];
+            if (s->count == 0 || (want_max ? strcmp(value, s->value.s) > 0 : strcmp(value, s->value.s) < 0)) {
+                s->value.s = value;
+            }
+            s->count++;
+        }
+    }
+}
+
+// 按批分组: 先算整批的哈希和组号，再逐个聚合更新累加器
+// partition_bits>0 时按哈希的高位把各组分到 1<<partition_bits 个分区表中
+static int aggregate_rows(const Table* table, const AggregatePlan* plan, const int* rows, int count,
+                          GroupTable* partitions, int partition_bits) {
+    int ids[AGGREGATE_BATCH];
+    uint64_t hashes[AGGREGATE_BATCH];
+    int partition_ids[AGGREGATE_BATCH];
+    int group_ids[AGGREGATE_BATCH];
+    Accumulator* targets[AGGREGATE_BATCH];
+
+    for (int start = 0; start < count; start += AGGREGATE_BATCH) {
+        int n = (count - start < AGGREGATE_BATCH) ? count - start : AGGREGATE_BATCH;
+        const int* batch = rows + start;
+        if (rows == NULL) {
+            for (int i = 0; i < n; i++) {
+                ids[i] = start + i;
+            }
+            batch = ids;
+        }
+
+        hash_keys(table, plan, batch, n, hashes);
+        for (int i = 0; i < n; i++) {
+            partition_ids[i] = (partition_bits > 0) ? (int)(hashes[i] >> (64 - partition_bits)) : 0;
+            group_ids[i] = find_or_add_group(&partitions[partition_ids[i]], table, plan, batch[i], hashes[i]);
+            if (group_ids[i] < 0) {
+                return -1;
+            }
+        }
+        for (int a = 0; a < plan->agg_count; a++) {
+            for (int i = 0; i < n; i++) {
+                targets[i] = &partitions[partition_ids[i]].states[a][group_ids[i]];
+            }
+            accumulate_batch(table, &plan->aggs[a], targets, batch, n);
+        }
+    }
+    return 0;
+}
+
+// 把另一个分组表中同一组的累加器合并进来
+static void merge_accumulator(const AggregateExpr* agg, Accumulator* dst, const Accumulator* src) {
+    if (src->count == 0) {
+        return;
+    }
+
+    int is_int = (agg->column != NULL && agg->column->type == TYPE_INT);
+    int is_float = (agg->column != NULL && agg->column->type == TYPE_FLOAT);
+    int want_max = (agg->type == AGG_MAX);
+
+    switch (agg->type) {
+        case AGG_COUNT:
+            break;
+        case AGG_SUM:
+        case AGG_AVG:
+            if (is_int && !src->widened) {
+                add_int(dst, src->value.i);
+            } else if (is_int) {
+                // src已溢出转成double: dst也转成double再合并
+                if (!dst->widened) {
+                    dst->value.f = (double)dst->value.i;
+                    dst->compensation = 0.0;
+                    dst->widened = 1;
+                }
+                add_compensated(dst, src->value.f);
+                dst->compensation += src->compensation;
+            } else {
+                add_compensated(dst, src->value.f);
+                dst->compensation += src->compensation;
+            }
+            break;
+        default:
+            if (dst->count == 0) {
+                dst->value = src->value;
+            } else if (is_int) {
+                if (want_max ? src->value.i > dst->value.i : src->value.i < dst->value.i) {
+                    dst->value.i = src->value.i;
+                }
+            } else if (is_float) {
+                if (want_max ? src->value.f > dst->value.f : src->value.f < dst->value.f) {
+                    dst->value.f = src->value.f;
+                }
+            } else {
+                int cmp = strcmp(src->value.s, dst->value.s);
+                if (want_max ? cmp > 0 : cmp < 0) {
+                    dst->value.s = src->value.s;
+                }
+            }
+            break;
+    }
+    dst->count += src->count;
+}
+
+// 把src的各组并入dst，代表行取较小的行号，结果顺序因此与单线程一致
+static int merge_group_table(GroupTable* dst, const GroupTable* src, const Table* table, const AggregatePlan* plan) {
+    for (int g = 0; g < src->group_count; g++) {
+        int group = find_or_add_group(dst, table, plan, src->first_rows[g], src->hashes[g]);
+        if (group < 0) {
+            return -1;
+        }
+        if (src->first_rows[g] < dst->first_rows[group]) {
+            dst->first_rows[group] = src->first_rows[g];
+        }
+        for (int a = 0; a < plan->agg_count; a++) {
+            merge_accumulator(&plan->aggs[a], &dst->states[a][group], &src->states[a][g]);
+        }
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+// 第一阶段: 行按morsel轮流分给各线程 (第w个线程处理第 w, w+T, w+2T... 个morsel)，聚合进自己的分区表
+// 分配是固定的，同样的线程数下每个线程的部分和每次都相同，浮点SUM/AVG的结果可以复现
+typedef struct {
+    const Table* table;
+    const AggregatePlan* plan;
+    const int* rows;
+    int count;
+    int first_morsel;
+    int morsel_stride;
+    GroupTable* partitions;    // 本线程的 AGGREGATE_PARTITIONS 个分区表
+    int status;
+} AggregateWorker;
+
+// 第二阶段: 每个线程领取整个分区，把各线程在该分区的表按线程顺序合并到第一个线程的表中
+// 分区之间没有共同的键，不需要加锁
+typedef struct {
+    const Table* table;
+    const AggregatePlan* plan;
+    GroupTable* locals;        // [线程][分区]
+    int worker_count;
+    int* next_partition;
+    int status;
+} MergeWorker;
+
+static void* aggregate_worker(void* arg) {
+    AggregateWorker* worker = arg;
+    int ids[AGGREGATE_MORSEL];
+
+    for (int morsel = worker->first_morsel; (long long)morsel * AGGREGATE_MORSEL < worker->count;
+         morsel += worker->morsel_stride) {
+        int start = morsel * AGGREGATE_MORSEL;
+        int n = (worker->count - start < AGGREGATE_MORSEL) ? worker->count - start : AGGREGATE_MORSEL;
+
+        // rows为NULL时morsel是连续的行号区间
+        const int* rows = worker->rows + start;
+        if (worker->rows == NULL) {
+            for (int i = 0; i < n; i++) {
+                ids[i] = start + i;
+            }
+            rows = ids;
+        }
+        if (aggregate_rows(worker->table, worker->plan, rows, n, worker->partitions, AGGREGATE_PARTITION_BITS) != 0) {
+            worker->status = -1;
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void* merge_worker(void* arg) {
+    MergeWorker* worker = arg;
+
+    for (;;) {
+        int p = __sync_fetch_and_add(worker->next_partition, 1);
+        if (p >= AGGREGATE_PARTITIONS) {
+            break;
+        }
+        for (int w = 1; w < worker->worker_count; w++) {
+            if (merge_group_table(&worker->locals[p], &worker->locals[w * AGGREGATE_PARTITIONS + p],
+                                  worker->table, worker->plan) != 0) {
+                worker->status = -1;
+                return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+static int online_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) {
+        return 1;
+    }
+    return (n > MAX_AGGREGATE_THREADS) ? MAX_AGGREGATE_THREADS : (int)n;
+}
+
+// 并行分区聚合: 结果在locals的前 AGGREGATE_PARTITIONS 个表中
+static int aggregate_parallel(const Table* table, const AggregatePlan* plan, const int* rows, int count,
+                              int thread_count, GroupTable* locals) {
+    pthread_t threads[MAX_AGGREGATE_THREADS];
+    AggregateWorker workers[MAX_AGGREGATE_THREADS];
+    MergeWorker mergers[MAX_AGGREGATE_THREADS];
+    int next_partition = 0;
+
+    int started = 0;
+    for (int w = 0; w < thread_count; w++) {
+        workers[w].table = table;
+        workers[w].plan = plan;
+        workers[w].rows = rows;
+        workers[w].count = count;
+        workers[w].first_morsel = w;
+        workers[w].morsel_stride = thread_count;
+        workers[w].partitions = &locals[w * AGGREGATE_PARTITIONS];
+        workers[w].status = 0;
+        if (pthread_create(&threads[w], NULL, aggregate_worker, &workers[w]) != 0) {
+            break;
+        }
+        started++;
+    }
+    int status = (started == thread_count) ? 0 : -1;
+    for (int w = 0; w < started; w++) {
+        pthread_join(threads[w], NULL);
+        status |= workers[w].status;
+    }
+    if (status != 0) {
+        return -1;
+    }
+
+    started = 0;
+    for (int w = 0; w < thread_count; w++) {
+        mergers[w].table = table;
+        mergers[w].plan = plan;
+        mergers[w].locals = locals;
+        mergers[w].worker_count = thread_count;
+        mergers[w].next_partition = &next_partition;
+        mergers[w].status = 0;
+        if (pthread_create(&threads[w], NULL, merge_worker, &mergers[w]) != 0) {
+            break;
+        }
+        started++;
+    }
+    status = (started == thread_count) ? 0 : -1;
+    for (int w = 0; w < started; w++) {
+        pthread_join(threads[w], NULL);
+        status |= mergers[w].status;
+    }
+    return status;
+}
+#endif
+
+static DataType aggregate_type(const AggregateExpr* agg) {
+    switch (agg->type) {
+        case AGG_COUNT:
+            return TYPE_INT;
+        case AGG_SUM:
+            return (agg->column != NULL && agg->column->type == TYPE_INT) ? TYPE_INT : TYPE_FLOAT;
+        case AGG_AVG:
+            return TYPE_FLOAT;
+        default:
+            return (agg->column != NULL) ? agg->column->type : TYPE_STRING;
+    }
+}
+
+// 把累加器格式化成结果单元格，没有非空值的SUM/AVG/MIN/MAX输出空值
+static void format_aggregate(const AggregateExpr* agg, const Accumulator* s, char* out, size_t size) {
+    DataType type = aggregate_type(agg);
+
+    if (agg->type == AGG_COUNT) {
+        snprintf(out, size, "%lld", s->count);
+    } else if (s->count == 0) {
+        out[0] = '\0';
+    } else if (agg->type == AGG_AVG) {
+        double sum = (agg->column != NULL && agg->column->type == TYPE_INT && !s->widened)
+                     ? (double)s->value.i : s->value.f + s->compensation;
+        snprintf(out, size, "%.15g", sum / (double)s->count);
+    } else if (type == TYPE_INT && !s->widened) {
+        snprintf(out, size, "%lld", s->value.i);
+    } else if (type == TYPE_INT) {
+        // 整数SUM溢出: 输出浮点和，结果列的列式存储随之放宽为FLOAT
+        snprintf(out, size, "%.15g", s->value.f + s->compensation);
+    } else if (type == TYPE_FLOAT) {
+        snprintf(out, size, "%.15g", s->value.f + s->compensation);
+    } else {
+        snprintf(out, size, "%s", s->value.s);
+    }
+}
+
+// 结果按各组代表行的顺序输出
+typedef struct {
+    int first_row;
+    int partition;
+    int group;
+} GroupRef;
+
+static int compare_group_refs(const void* a, const void* b) {
+    int x = ((const GroupRef*)a)->first_row;
+    int y = ((const GroupRef*)b)->first_row;
+    return (x > y) - (x < y);
+}
+
+static Table* build_result(const Table* table, const AggregatePlan* plan,
+                           const GroupTable* partitions, int partition_count) {
+    const char* names[MAX_COLUMNS];
+    for (int i = 0; i < plan->output_count; i++) {
+        names[i] = plan->names[i];
+    }
+
+    int group_count = 0;
+    for (int p = 0; p < partition_count; p++) {
+        group_count += partitions[p].group_count;
+    }
+    GroupRef* refs = malloc((group_count > 0 ? group_count : 1) * sizeof(GroupRef));
+    if (refs == NULL) {
+        return NULL;
+    }
+    int ref_count = 0;
+    for (int p = 0; p < partition_count; p++) {
+        for (int g = 0; g < partitions[p].group_count; g++) {
+            refs[ref_count].first_row = partitions[p].first_rows[g];
+            refs[ref_count].partition = p;
+            refs[ref_count].group = g;
+            ref_count++;
+        }
+    }
+    if (partition_count > 1) {
+        qsort(refs, ref_count, sizeof(GroupRef), compare_group_refs);
+    }
+
+    Table* result = create_table("aggregate_result", plan->output_count, names);
+    if (result == NULL) {
+        free(refs);
+        return NULL;
+    }
+    for (int i = 0; i < plan->output_count; i++) {
+        int source = plan->outputs[i];
+        result->columns[i].type = (source >= 0) ? table->columns[plan->keys[source].col_index].type
+                                                : aggregate_type(&plan->aggs[-source - 1]);
+    }
+
+    char values[MAX_COLUMNS][MAX_CELL_LEN];
+    const char* row_data[MAX_COLUMNS];
+    for (int r = 0; r < ref_count; r++) {
+        const GroupTable* groups = &partitions[refs[r].partition];
+        int g = refs[r].group;
+        for (int i = 0; i < plan->output_count; i++) {
+            int source = plan->outputs[i];
+            if (source >= 0) {
+                row_data[i] = cell_text(table, groups->first_rows[g], plan->keys[source].col_index);
+            } else {
+                int a = -source - 1;
+                format_aggregate(&plan->aggs[a], &groups->states[a][g], values[i], sizeof(values[i]));
+                row_data[i] = values[i];
+            }
+        }
+        if (add_row(result, row_data) != 0) {
+            free(refs);
+            free_table(result);
+            return NULL;
+        }
+    }
+    free(refs);
+
+    // 结果带上类型化列，ORDER BY聚合列时按数值排序
+    build_column_store(result);
+    return result;
+}
+
+Table* aggregate_view(const TableView* view, const Query* query) {
+    return aggregate_view_threads(view, query, 0);
+}
+
+// 只有COUNT(*)时的唯一一组: 每个COUNT(*)都等于行数
+static int add_row_count_group(GroupTable* groups, const AggregatePlan* plan, int row_count) {
+    if (add_group(groups, 0, 0, -1) < 0) {
+        return -1;
+    }
+    for (int a = 0; a < plan->agg_count; a++) {
+        groups->states[a][0].count = row_count;
+    }
+    return 0;
+}
+
+int aggregate_is_row_count(const Table* table, const Query* query) {
+    AggregatePlan plan;
+    return table != NULL && query != NULL && build_plan(table, query, &plan) == 0 && is_count_star_only(&plan);
+}
+
+Table* aggregate_row_count(const Table* table, const Query* query, int row_count) {
+    if (table == NULL || query == NULL) {
+        return NULL;
+    }
+
+    AggregatePlan plan;
+    if (build_plan(table, query, &plan) != 0 || !is_count_star_only(&plan)) {
+        return NULL;
+    }
+
+    GroupTable groups;
+    Table* result = NULL;
+    if (group_table_init(&groups, plan.agg_count) == 0 && add_row_count_group(&groups, &plan, row_count) == 0) {
+        result = build_result(table, &plan, &groups, 1);
+    }
+    group_table_free(&groups);
+    return result;
+}
+
+// thread_count: 0 = 行数足够多时每个在线CPU一个线程, 1 = 单线程
+Table* aggregate_view_threads(const TableView* view, const Query* query, int thread_count) {
+    if (view == NULL || query == NULL) {
+        return NULL;
+    }
+
+    const Table* table = view->base;
+    AggregatePlan plan;
+    if (build_plan(table, query, &plan) != 0) {
+        return NULL;
+    }
+
+#ifndef _WIN32
+    if (thread_count == 0) {
+        thread_count = (view->row_count >= PARALLEL_MIN_ROWS) ? online_cpu_count() : 1;
+    }
+    if (thread_count > MAX_AGGREGATE_THREADS) {
+        thread_count = MAX_AGGREGATE_THREADS;
+    }
+#else
+    thread_count = 1;
+#endif
+    int count_star_only = is_count_star_only(&plan);
+    if (count_star_only || thread_count < 1) {
+        thread_count = 1;
+    }
+
+    // 单线程只有一个表，并行时每个线程 AGGREGATE_PARTITIONS 个分区表
+    int table_count = (thread_count > 1) ? thread_count * AGGREGATE_PARTITIONS : 1;
+    GroupTable* tables = calloc(table_count, sizeof(GroupTable));
+    if (tables == NULL) {
+        return NULL;
+    }
+    int status = 0;
+    for (int t = 0; t < table_count && status == 0; t++) {
+        status = group_table_init(&tables[t], plan.agg_count);
+    }
+
+    if (status == 0 && count_star_only) {
+        // 只有COUNT(*)时不扫描，选中的行数就是结果
+        status = add_row_count_group(&tables[0], &plan, view->row_count);
+    } else if (status == 0) {
+#ifndef _WIN32
+        if (thread_count > 1) {
+            status = aggregate_parallel(table, &plan, view->rows, view->row_count, thread_count, tables);
+        } else
+#endif
+        {
+            status = aggregate_rows(table, &plan, view->rows, view->row_count, tables, 0);
+        }
+
+        // 没有GROUP BY时，即使没有输入行也输出一行
+        if (status == 0 && plan.key_count == 0 && tables[0].group_count == 0) {
+            status = (add_group(&tables[0], 0, 0, -1) < 0) ? -1 : 0;
+        }
+    }
+
+    Table* result = NULL;
+    if (status == 0) {
+        result = build_result(table, &plan, tables, (thread_count > 1) ? AGGREGATE_PARTITIONS : 1);
+    }
+    for (int t = 0; t < table_count; t++) {
+        group_table_free(&tables[t]);
+    }
+    free(tables);
+    return result;
+}
@@ -0,0 +1,27 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include "table.h"
+#include "view.h"
+
+// 哈希分组聚合: 对视图选中的行按GROUP BY列分组，返回每组一行的结果表 (出错返回NULL)
+// 结果列按SELECT列表的顺序，聚合列命名为 "SUM(col)" 的形式
+Table* aggregate_view(const TableView* view, const Query* query);
+
+// 指定线程数的版本: 大输入时各线程按morsel聚合到线程本地的分区哈希表，再按分区并行合并
+// 整数列的SUM/AVG和COUNT/MIN/MAX与线程数无关；浮点SUM/AVG用补偿求和、按固定顺序合并，
+// 同样的线程数结果可以复现，不同线程数之间只可能在最后一位上不同
+// 整数SUM超出long long范围时改按浮点求和 (结果列为FLOAT)，这时同样只保证到最后一位
+Table* aggregate_view_threads(const TableView* view, const Query* query, int thread_count);
+
+// 只有COUNT(*)且没有GROUP BY的查询，在已知满足条件的行数时直接生成结果 (如位图索引求出的基数)
+// 查询不是这种形式时返回NULL
+Table* aggregate_row_count(const Table* table, const Query* query, int row_count);
+
+// 查询是否是上面这种只有COUNT(*)、没有GROUP BY的形式
+int aggregate_is_row_count(const Table* table, const Query* query);
+
+// 聚合函数名 ("COUNT"等)，AGG_NONE返回NULL
+const char* aggregate_name(AggregateType type);
+
+#endif // AGGREGATE_H
@@ -0,0 +1,118 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_MIN_CHUNK (4 * 1024)
+#define ARENA_MAX_CHUNK (1024 * 1024)
+#define ARENA_ALIGN 8
+
+Arena* arena_create(void) {
+    Arena* arena = malloc(sizeof(Arena));
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    arena->head = NULL;
+    arena->next_chunk_size = ARENA_MIN_CHUNK;
+    arena->total_bytes = 0;
+    arena->chunk_count = 0;
+    return arena;
+}
+
+// 申请新块: 块大小从4KB开始翻倍，临时小表不会占用大块内存
+static ArenaChunk* arena_new_chunk(Arena* arena, size_t min_size) {
+    size_t size = arena->next_chunk_size;
+    if (size < min_size) {
+        size = min_size;
+    }
+
+    ArenaChunk* chunk = malloc(sizeof(ArenaChunk) + size);
+    if (chunk == NULL) {
+        return NULL;
+    }
+
+    chunk->size = size;
+    chunk->used = 0;
+    chunk->next = arena->head;
+    arena->head = chunk;
+    arena->total_bytes += size;
+    arena->chunk_count++;
+
+    if (arena->next_chunk_size < ARENA_MAX_CHUNK) {
+        arena->next_chunk_size *= 2;
+    }
+    return chunk;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ArenaChunk* chunk = arena->head;
+    if (chunk == NULL || chunk->used + size > chunk->size) {
+        chunk = arena_new_chunk(arena, size);
+        if (chunk == NULL) {
+            return NULL;
+        }
+    }
+
+    void* ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+char* arena_strndup(Arena* arena, const char* str, size_t len) {
+    char* copy = arena_alloc(arena, len + 1);
+    if (copy == NULL) {
+        return NULL;
+    }
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+char* arena_strdup(Arena* arena, const char* str) {
+    return arena_strndup(arena, str, strlen(str));
+}
+
+// 把src的所有内存块移交给dst (src变为空)，用于合并并行加载的部分表
+void arena_adopt(Arena* dst, Arena* src) {
+    if (dst == NULL || src == NULL || src->head == NULL) {
+        return;
+    }
+
+    ArenaChunk* tail = src->head;
+    while (tail->next != NULL) {
+        tail = tail->next;
+    }
+
+    // 插在dst当前块之后，dst继续在自己的当前块上分配
+    if (dst->head == NULL) {
+        dst->head = src->head;
+    } else {
+        tail->next = dst->head->next;
+        dst->head->next = src->head;
+    }
+    dst->total_bytes += src->total_bytes;
+    dst->chunk_count += src->chunk_count;
+
+    src->head = NULL;
+    src->total_bytes = 0;
+    src->chunk_count = 0;
+}
+
+void arena_destroy(Arena* arena) {
+    if (arena == NULL) {
+        return;
+    }
+
+    ArenaChunk* chunk = arena->head;
+    while (chunk != NULL) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
@@ -0,0 +1,30 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// 内存块链表节点
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t size;
+    size_t used;
+    char data[];
+} ArenaChunk;
+
+// 指针递增分配器: 所有分配随arena一起释放
+typedef struct Arena {
+    ArenaChunk* head;
+    size_t next_chunk_size;
+    size_t total_bytes;   // 已向系统申请的字节数
+    int chunk_count;
+} Arena;
+
+// 竞技场分配函数
+Arena* arena_create(void);
+void* arena_alloc(Arena* arena, size_t size);
+char* arena_strdup(Arena* arena, const char* str);
+char* arena_strndup(Arena* arena, const char* str, size_t len);
+void arena_adopt(Arena* dst, Arena* src);
+void arena_destroy(Arena* arena);
+
+#endif // ARENA_H
@@ -0,0 +1,462 @@
+#include "batch.h"
+#include "column_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+// 比较一批数值并生成位图，第i位对应第i个值；rows为NULL时values已按批起点偏移
+typedef void (*CompareDoublesFn)(const double* values, const int* rows, int n, double c, Operator op, uint64_t* bits);
+typedef void (*CompareIntsFn)(const long long* values, const int* rows, int n, long long c, Operator op, uint64_t* bits);
+
+// 每64个值拼成一个字，循环体无分支
+#define COMPARE_WORDS(expr)                                            \
+    do {                                                               \
+        for (int base = 0; base < n; base += 64) {                     \
+            int limit = (n - base < 64) ? n - base : 64;               \
+            uint64_t word = 0;                                         \
+            for (int j = 0; j < limit; j++) {                          \
+                int i = base + j;                                      \
+                word |= (uint64_t)(expr) << j;                         \
+            }                                                          \
+            bits[base >> 6] = word;                                    \
+        }                                                              \
+    } while (0)
+
+#define VALUE_AT(i) (rows != NULL ? values[rows[i]] : values[i])
+
+#define COMPARE_SCALAR(c)                                              \
+    switch (op) {                                                      \
+        case OP_EQUAL:         COMPARE_WORDS(VALUE_AT(i) == c); break; \
+        case OP_NOT_EQUAL:     COMPARE_WORDS(VALUE_AT(i) != c); break; \
+        case OP_GREATER:       COMPARE_WORDS(VALUE_AT(i) > c);  break; \
+        case OP_LESS:          COMPARE_WORDS(VALUE_AT(i) < c);  break; \
+        case OP_GREATER_EQUAL: COMPARE_WORDS(VALUE_AT(i) >= c); break; \
+        case OP_LESS_EQUAL:    COMPARE_WORDS(VALUE_AT(i) <= c); break; \
+        default:               memset(bits, 0, BATCH_WORDS * sizeof(uint64_t)); break; \
+    }
+
+// 标量实现: 所有平台都可用，也用于按选择向量取值的情况
+static void compare_doubles_scalar(const double* values, const int* rows, int n, double c, Operator op, uint64_t* bits) {
+    COMPARE_SCALAR(c)
+}
+
+static void compare_ints_scalar(const long long* values, const int* rows, int n, long long c, Operator op, uint64_t* bits) {
+    COMPARE_SCALAR(c)
+}
+
+// BETWEEN: 两端检查合并在一次循环里；整数用一次无符号减法 (要求 low <= high)
+typedef void (*BetweenDoublesFn)(const double* values, const int* rows, int n, double low, double high, uint64_t* bits);
+typedef void (*BetweenIntsFn)(const long long* values, const int* rows, int n, long long low, long long high, uint64_t* bits);
+
+static void between_doubles_scalar(const double* values, const int* rows, int n, double low, double high, uint64_t* bits) {
+    COMPARE_WORDS((VALUE_AT(i) >= low) & (VALUE_AT(i) <= high));
+}
+
+static void between_ints_scalar(const long long* values, const int* rows, int n, long long low, long long high, uint64_t* bits) {
+    uint64_t span = (uint64_t)high - (uint64_t)low;
+    COMPARE_WORDS((uint64_t)VALUE_AT(i) - (uint64_t)low <= span);
+}
+
+#ifdef BATCH_X86
+// AVX2: 每次比较4个值，movemask直接得到4位结果
+#define AVX2_DOUBLE_LOOP(predicate)                                                     \
+    for (; i + 4 <= n; i += 4) {                                                        \
+        __m256d x = _mm256_loadu_pd(values + i);                                        \
+        uint64_t mask = (uint32_t)_mm256_movemask_pd(_mm256_cmp_pd(x, needle, predicate)); \
+        bits[i >> 6] |= mask << (i & 63);                                               \
+    }
+
+__attribute__((target("avx2")))
+static void compare_doubles_avx2(const double* values, const int* rows, int n, double c, Operator op, uint64_t* bits) {
+    if (rows != NULL) {
+        compare_doubles_scalar(values, rows, n, c, op, bits);
+        return;
+    }
+
+    memset(bits, 0, BATCH_WORDS * sizeof(uint64_t));
+    __m256d needle = _mm256_set1_pd(c);
+    int i = 0;
+    switch (op) {
+        case OP_EQUAL:         AVX2_DOUBLE_LOOP(_CMP_EQ_OQ);  break;
+        case OP_NOT_EQUAL:     AVX2_DOUBLE_LOOP(_CMP_NEQ_UQ); break;
+        case OP_GREATER:       AVX2_DOUBLE_LOOP(_CMP_GT_OQ);  break;
+        case OP_LESS:          AVX2_DOUBLE_LOOP(_CMP_LT_OQ);  break;
+        case OP_GREATER_EQUAL: AVX2_DOUBLE_LOOP(_CMP_GE_OQ);  break;
+        case OP_LESS_EQUAL:    AVX2_DOUBLE_LOOP(_CMP_LE_OQ);  break;
+        default:               return;
+    }
+
+    // 不足4个的尾部
+    uint64_t tail[BATCH_WORDS];
+    if (i < n) {
+        compare_doubles_scalar(values + i, NULL, n - i, c, op, tail);
+        bits[i >> 6] |= tail[0] << (i & 63);
+    }
+}
+
+// 64位整数只有 > 和 = 两种比较指令，其余由交换操作数或取反得到
+__attribute__((target("avx2")))
+static void compare_ints_avx2(const long long* values, const int* rows, int n, long long c, Operator op, uint64_t* bits) {
+    if (rows != NULL) {
+        compare_ints_scalar(values, rows, n, c, op, bits);
+        return;
+    }
+
+    memset(bits, 0, BATCH_WORDS * sizeof(uint64_t));
+    __m256i needle = _mm256_set1_epi64x(c);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        __m256i result;
+        uint64_t invert = 0;
+        switch (op) {
+            case OP_EQUAL:         result = _mm256_cmpeq_epi64(x, needle); break;
+            case OP_NOT_EQUAL:     result = _mm256_cmpeq_epi64(x, needle); invert = 0xF; break;
+            case OP_GREATER:       result = _mm256_cmpgt_epi64(x, needle); break;
+            case OP_LESS:          result = _mm256_cmpgt_epi64(needle, x); break;
+            case OP_GREATER_EQUAL: result = _mm256_cmpgt_epi64(needle, x); invert = 0xF; break;
+            case OP_LESS_EQUAL:    result = _mm256_cmpgt_epi64(x, needle); invert = 0xF; break;
+            default:               return;
+        }
+        uint64_t mask = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(result)) ^ invert;
+        bits[i >> 6] |= mask << (i & 63);
+    }
+
+    uint64_t tail[BATCH_WORDS];
+    if (i < n) {
+        compare_ints_scalar(values + i, NULL, n - i, c, op, tail);
+        bits[i >> 6] |= tail[0] << (i & 63);
+    }
+}
+
+__attribute__((target("avx2")))
+static void between_doubles_avx2(const double* values, const int* rows, int n, double low, double high, uint64_t* bits) {
+    if (rows != NULL) {
+        between_doubles_scalar(values, rows, n, low, high, bits);
+        return;
+    }
+
+    memset(bits, 0, BATCH_WORDS * sizeof(uint64_t));
+    __m256d lower = _mm256_set1_pd(low);
+    __m256d upper = _mm256_set1_pd(high);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(values + i);
+        __m256d inside = _mm256_and_pd(_mm256_cmp_pd(x, lower, _CMP_GE_OQ), _mm256_cmp_pd(x, upper, _CMP_LE_OQ));
+        uint64_t mask = (uint32_t)_mm256_movemask_pd(inside);
+        bits[i >> 6] |= mask << (i & 63);
+    }
+
+    uint64_t tail[BATCH_WORDS];
+    if (i < n) {
+        between_doubles_scalar(values + i, NULL, n - i, low, high, tail);
+        bits[i >> 6] |= tail[0] << (i & 63);
+    }
+}
+
+// x < low 或 x > high 的位取反
+__attribute__((target("avx2")))
+static void between_ints_avx2(const long long* values, const int* rows, int n, long long low, long long high, uint64_t* bits) {
+    if (rows != NULL) {
+        between_ints_scalar(values, rows, n, low, high, bits);
+        return;
+    }
+
+    memset(bits, 0, BATCH_WORDS * sizeof(uint64_t));
+    __m256i lower = _mm256_set1_epi64x(low);
+    __m256i upper = _mm256_set1_epi64x(high);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(lower, x), _mm256_cmpgt_epi64(x, upper));
+        uint64_t mask = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(outside)) ^ 0xF;
+        bits[i >> 6] |= mask << (i & 63);
+    }
+
+    uint64_t tail[BATCH_WORDS];
+    if (i < n) {
+        between_ints_scalar(values + i, NULL, n - i, low, high, tail);
+        bits[i >> 6] |= tail[0] << (i & 63);
+    }
+}
+#endif
+
+static CompareDoublesFn compare_doubles_impl = NULL;
+static CompareIntsFn compare_ints_impl = NULL;
+static BetweenDoublesFn between_doubles_impl = NULL;
+static BetweenIntsFn between_ints_impl = NULL;
+
+// 第一次使用时按CPU能力选择实现
+static void select_compare_kernels(void) {
+    CompareDoublesFn doubles = compare_doubles_scalar;
+    CompareIntsFn ints = compare_ints_scalar;
+    BetweenDoublesFn between_doubles = between_doubles_scalar;
+    BetweenIntsFn between_ints = between_ints_scalar;
+
+#ifdef BATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        doubles = compare_doubles_avx2;
+        ints = compare_ints_avx2;
+        between_doubles = between_doubles_avx2;
+        between_ints = between_ints_avx2;
+    }
+#endif
+
+    between_ints_impl = between_ints;
+    between_doubles_impl = between_doubles;
+    compare_ints_impl = ints;
+    compare_doubles_impl = doubles;
+}
+
+// 整数列与double常量比较时，把常量换算成等价的整数边界 (x > 2.5 等价于 x > 2)
+static int int_bound(const CompiledPredicate* p, long long* bound) {
+    double c = p->float_value;
+    if (!(c > -9.2e18 && c < 9.2e18)) {
+        return -1;
+    }
+
+    switch (p->op) {
+        case OP_GREATER:
+        case OP_LESS_EQUAL:
+            *bound = (long long)floor(c);
+            return 0;
+        case OP_LESS:
+        case OP_GREATER_EQUAL:
+            *bound = (long long)ceil(c);
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+// 空值在数组中存为0: 等值比较时要单独排除 (=) 或加入 (!=)
+static void apply_nulls(const CompiledPredicate* p, const int* rows, int start, int n, uint64_t* result) {
+    const unsigned char* values = (rows != NULL) ? p->column->nulls : p->column->nulls + start;
+    uint64_t bits[BATCH_WORDS];
+
+    COMPARE_WORDS(VALUE_AT(i) != 0);
+    for (int w = 0; w * 64 < n; w++) {
+        result[w] = (p->op == OP_EQUAL) ? (result[w] & ~bits[w]) : (result[w] | bits[w]);
+    }
+}
+
+static int scan_between(const CompiledPredicate* p, const int* rows, int start, int n, uint64_t* bits) {
+    const ColumnVector* column = p->column;
+
+    if (column->type == TYPE_INT) {
+        double low = ceil(p->float_value);
+        double high = floor(p->float_high);
+        if (!(low > -9.2e18 && low < 9.2e18 && high > -9.2e18 && high < 9.2e18)) {
+            return -1;
+        }
+        if (low > high) {
+            memset(bits, 0, BATCH_WORDS * sizeof(uint64_t));
+            return 0;
+        }
+        between_ints_impl(rows != NULL ? column->ints : column->ints + start, rows, n,
+                          (long long)low, (long long)high, bits);
+    } else {
+        between_doubles_impl(rows != NULL ? column->floats : column->floats + start, rows, n,
+                             p->float_value, p->float_high, bits);
+    }
+    return 0;
+}
+
+// 类型化数值列上的比较和BETWEEN走批量内核，返回-1表示只能逐行求值
+static int scan_predicate(const CompiledPredicate* p, const int* rows, int start, int n, uint64_t* bits) {
+    const ColumnVector* column = p->column;
+    if (column == NULL || !column_is_numeric(column) || p->op == OP_LIKE || p->op == OP_IN) {
+        return -1;
+    }
+
+    const int* batch_rows = (rows != NULL) ? rows + start : NULL;
+    if (p->op == OP_BETWEEN) {
+        return scan_between(p, batch_rows, start, n, bits);
+    }
+    int equality = (p->op == OP_EQUAL || p->op == OP_NOT_EQUAL);
+
+    if (column->type == TYPE_INT) {
+        long long c = p->int_value;
+        if (equality ? !p->exact_int : int_bound(p, &c) != 0) {
+            return -1;
+        }
+        compare_ints_impl(batch_rows != NULL ? column->ints : column->ints + start, batch_rows, n, c, p->op, bits);
+    } else {
+        compare_doubles_impl(batch_rows != NULL ? column->floats : column->floats + start, batch_rows, n,
+                             p->float_value, p->op, bits);
+    }
+
+    if (equality) {
+        apply_nulls(p, batch_rows, start, n, bits);
+    }
+    return 0;
+}
+
+static int selection_is_empty(const uint64_t* selection) {
+    uint64_t any = 0;
+    for (int w = 0; w < BATCH_WORDS; w++) {
+        any |= selection[w];
+    }
+    return any == 0;
+}
+
+// 对位图中仍被选中的行逐行求值
+static void refine_rowwise(const FilterNode* node, const Table* table, const int* rows, int start,
+                           uint64_t* selection) {
+    for (int w = 0; w < BATCH_WORDS; w++) {
+        uint64_t pending = selection[w];
+        while (pending != 0) {
+            int bit = bitmap_pop_lowest_bit(&pending);
+            int i = start + w * 64 + bit;
+            int row = (rows != NULL) ? rows[i] : i;
+            if (!filter_matches(node, table, row)) {
+                selection[w] &= ~(1ULL << bit);
+            }
+        }
+    }
+}
+
+// 用表达式树收窄一批行的选择位图；已被排除 (AND) 或已命中 (OR) 的行不再求值
+static void refine_selection(const FilterNode* node, const Table* table, const int* rows,
+                             int start, int n, uint64_t* selection) {
+    uint64_t bits[BATCH_WORDS];
+    uint64_t remaining[BATCH_WORDS];
+
+    if (selection_is_empty(selection)) {
+        return;
+    }
+
+    switch (node->kind) {
+        case COND_COMPARE:
+            if (scan_predicate(&node->predicate, rows, start, n, bits) == 0) {
+                for (int w = 0; w * 64 < n; w++) {
+                    selection[w] &= bits[w];
+                }
+            } else {
+                refine_rowwise(node, table, rows, start, selection);
+            }
+            return;
+        case COND_AND:
+            for (int i = 0; i < node->child_count; i++) {
+                refine_selection(node->children[i], table, rows, start, n, selection);
+            }
+            return;
+        case COND_OR:
+            memcpy(remaining, selection, sizeof(remaining));
+            memset(selection, 0, BATCH_WORDS * sizeof(uint64_t));
+            for (int i = 0; i < node->child_count && !selection_is_empty(remaining); i++) {
+                memcpy(bits, remaining, sizeof(bits));
+                refine_selection(node->children[i], table, rows, start, n, bits);
+                for (int w = 0; w < BATCH_WORDS; w++) {
+                    selection[w] |= bits[w];
+                    remaining[w] &= ~bits[w];
+                }
+            }
+            return;
+        case COND_NOT:
+            memcpy(bits, selection, sizeof(bits));
+            refine_selection(node->children[0], table, rows, start, n, bits);
+            for (int w = 0; w < BATCH_WORDS; w++) {
+                selection[w] &= ~bits[w];
+            }
+            return;
+        default:
+            memset(selection, 0, BATCH_WORDS * sizeof(uint64_t));
+            return;
+    }
+}
+
+// 区域映射: 块内的值都在 [min, max] 中，据此判断这一块有没有行可能满足谓词
+static int zone_excludes_predicate(const CompiledPredicate* p, const Table* table, int zone) {
+    if (p->column == NULL || !column_is_numeric(p->column)) {
+        return 0;
+    }
+    const ZoneMap* zones = &table->store->zones[p->col_index];
+    if (zone >= zones->count) {
+        return 0;
+    }
+
+    double min = zones->mins[zone];
+    double max = zones->maxs[zone];
+    double c = p->float_value;
+    switch (p->op) {
+        case OP_GREATER:       return !(max > c);
+        case OP_GREATER_EQUAL: return !(max >= c);
+        case OP_LESS:          return !(min < c);
+        case OP_LESS_EQUAL:    return !(min <= c);
+        case OP_EQUAL:         return c < min || c > max;
+        case OP_BETWEEN:       return p->float_high < min || c > max;
+        default:               return 0;
+    }
+}
+
+// AND有一项排除整块即可，OR要每一项都排除；NOT需要"整块都满足"，不做判断
+static int zone_excludes(const FilterNode* node, const Table* table, int zone) {
+    switch (node->kind) {
+        case COND_COMPARE:
+            return zone_excludes_predicate(&node->predicate, table, zone);
+        case COND_AND:
+            for (int i = 0; i < node->child_count; i++) {
+                if (zone_excludes(node->children[i], table, zone)) {
+                    return 1;
+                }
+            }
+            return 0;
+        case COND_OR:
+            for (int i = 0; i < node->child_count; i++) {
+                if (!zone_excludes(node->children[i], table, zone)) {
+                    return 0;
+                }
+            }
+            return node->child_count > 0;
+        default:
+            return 0;
+    }
+}
+
+int filter_row_ids(const Table* table, const FilterNode* filter, const int* rows, int count, int* out) {
+    if (table == NULL || filter == NULL || out == NULL) {
+        return -1;
+    }
+    if (compare_doubles_impl == NULL) {
+        select_compare_kernels();
+    }
+
+    uint64_t selection[BATCH_WORDS];
+    int selected = 0;
+
+    for (int start = 0; start < count; start += BATCH_SIZE) {
+        // 扫描整张表时，每块开头先查区域映射，整块都不可能满足条件就跳到下一块
+        if (rows == NULL && table->store != NULL && start % ZONE_ROWS == 0 &&
+            zone_excludes(filter, table, start / ZONE_ROWS)) {
+            start += ZONE_ROWS - BATCH_SIZE;
+            continue;
+        }
+        int n = (count - start < BATCH_SIZE) ? count - start : BATCH_SIZE;
+
+        memset(selection, 0, sizeof(selection));
+        for (int w = 0; w * 64 < n; w++) {
+            int width = (n - w * 64 < 64) ? n - w * 64 : 64;
+            selection[w] = (width == 64) ? ~0ULL : ((1ULL << width) - 1);
+        }
+
+        refine_selection(filter, table, rows, start, n, selection);
+
+        for (int w = 0; w < BATCH_WORDS; w++) {
+            uint64_t pending = selection[w];
+            while (pending != 0) {
+                int i = start + w * 64 + bitmap_pop_lowest_bit(&pending);
+                out[selected++] = (rows != NULL) ? rows[i] : i;
+            }
+        }
+    }
+
+    return selected;
+}
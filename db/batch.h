@@ -0,0 +1,28 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include "table.h"
+#include "predicate.h"
+
+#define BATCH_SIZE 1024
+#define BATCH_WORDS (BATCH_SIZE / 64)
+
+// 按批过滤: 每批1024行，类型化数值比较在紧凑循环中生成选择位图，其余比较只对位图中剩下的行逐行求值
+// rows为NULL时表示行号0..count-1 (此时按区域映射跳过不可能满足条件的整块)，满足条件的行号按原顺序写入out，
+// 返回个数 (出错返回-1)
+int filter_row_ids(const Table* table, const FilterNode* filter, const int* rows, int count, int* out);
+
+// 取出并清除最低位的1，返回其位置
+static inline int bitmap_pop_lowest_bit(uint64_t* bits) {
+#if defined(__GNUC__)
+    int pos = __builtin_ctzll(*bits);
+#else
+    int pos = 0;
+    while (((*bits >> pos) & 1) == 0) pos++;
+#endif
+    *bits &= *bits - 1;
+    return pos;
+}
+
+#endif // BATCH_H
@@ -0,0 +1,88 @@
+#include "catalog.h"
+#include "snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#endif
+
+Catalog* create_catalog(void) {
+    return calloc(1, sizeof(Catalog));
+}
+
+void free_catalog(Catalog* catalog) {
+    if (catalog == NULL) {
+        return;
+    }
+    for (int i = 0; i < catalog->count; i++) {
+        free_table(catalog->tables[i]);
+    }
+    free(catalog);
+}
+
+// 表名不区分大小写
+Table* catalog_find(const Catalog* catalog, const char* name) {
+    if (catalog == NULL || name == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < catalog->count; i++) {
+        if (strcasecmp(catalog->tables[i]->name, name) == 0) {
+            return catalog->tables[i];
+        }
+    }
+    return NULL;
+}
+
+// 加入目录并接管表的内存，同名的旧表被替换
+int catalog_add(Catalog* catalog, Table* table) {
+    if (catalog == NULL || table == NULL) {
+        return -1;
+    }
+
+    for (int i = 0; i < catalog->count; i++) {
+        if (strcasecmp(catalog->tables[i]->name, table->name) == 0) {
+            if (catalog->tables[i] != table) {
+                free_table(catalog->tables[i]);
+                catalog->tables[i] = table;
+            }
+            return 0;
+        }
+    }
+
+    if (catalog->count >= MAX_TABLES) {
+        return -1;
+    }
+    catalog->tables[catalog->count++] = table;
+    return 0;
+}
+
+// 按文件名 (去掉目录和扩展名) 查找，已加载的表不再重复加载
+Table* catalog_load_csv(Catalog* catalog, const char* path) {
+    if (catalog == NULL || path == NULL) {
+        return NULL;
+    }
+
+    const char* slash = strrchr(path, '/');
+    char name[100];
+    strncpy(name, (slash != NULL) ? slash + 1 : path, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    char* dot = strrchr(name, '.');
+    if (dot != NULL) {
+        *dot = '\0';
+    }
+
+    Table* table = catalog_find(catalog, name);
+    if (table != NULL) {
+        return table;
+    }
+
+    table = load_csv_cached(path);
+    if (table != NULL && catalog_add(catalog, table) != 0) {
+        free_table(table);
+        return NULL;
+    }
+    return table;
+}
@@ -0,0 +1,21 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "table.h"
+
+#define MAX_TABLES 32
+
+// 表目录: 按表名保存已加载的表，目录拥有这些表
+typedef struct {
+    Table* tables[MAX_TABLES];
+    int count;
+} Catalog;
+
+// 目录操作函数
+Catalog* create_catalog(void);
+void free_catalog(Catalog* catalog);
+Table* catalog_find(const Catalog* catalog, const char* name);
+int catalog_add(Catalog* catalog, Table* table);
+Table* catalog_load_csv(Catalog* catalog, const char* path);
+
+#endif // CATALOG_H
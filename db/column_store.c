@@ -0,0 +1,414 @@
+#include "column_store.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define INITIAL_HEAP_CAPACITY 4096
+
+// 解析整数单元格，整个字符串必须是合法整数；超出long long范围时返回0，该列放宽为FLOAT
+static int parse_int_cell(const char* value, long long* out) {
+    if (value == NULL || value[0] == '\0') {
+        return 0;
+    }
+    char* end;
+    errno = 0;
+    *out = strtoll(value, &end, 10);
+    return *end == '\0' && errno != ERANGE;
+}
+
+// 解析浮点单元格
+static int parse_float_cell(const char* value, double* out) {
+    if (value == NULL || value[0] == '\0') {
+        return 0;
+    }
+    char* end;
+    *out = strtod(value, &end);
+    return *end == '\0';
+}
+
+// 数值列中的空字符串按空值处理
+static int is_null_cell(const char* value, DataType type) {
+    if (value == NULL) {
+        return 1;
+    }
+    return type != TYPE_STRING && value[0] == '\0';
+}
+
+// 检查单元格能否按指定类型存储，不能时返回需要的更通用类型
+static DataType widen_type(DataType type, const char* value) {
+    long long i;
+    double f;
+
+    if (is_null_cell(value, type) || type == TYPE_STRING) {
+        return type;
+    }
+    if (type == TYPE_INT && parse_int_cell(value, &i)) {
+        return TYPE_INT;
+    }
+    if (parse_float_cell(value, &f)) {
+        return TYPE_FLOAT;
+    }
+    return TYPE_STRING;
+}
+
+static void free_column_vector(ColumnVector* column) {
+    free(column->ints);
+    free(column->floats);
+    free(column->offsets);
+    free(column->heap);
+    free(column->nulls);
+    memset(column, 0, sizeof(ColumnVector));
+}
+
+static int init_column_vector(ColumnVector* column, DataType type, int capacity) {
+    memset(column, 0, sizeof(ColumnVector));
+    column->type = type;
+    column->nulls = calloc(capacity, sizeof(unsigned char));
+    if (column->nulls == NULL) {
+        return -1;
+    }
+
+    switch (type) {
+        case TYPE_INT:
+            column->ints = malloc(capacity * sizeof(long long));
+            return column->ints != NULL ? 0 : -1;
+        case TYPE_FLOAT:
+            column->floats = malloc(capacity * sizeof(double));
+            return column->floats != NULL ? 0 : -1;
+        default:
+            column->type = TYPE_STRING;
+            column->offsets = malloc(capacity * sizeof(size_t));
+            column->heap = malloc(INITIAL_HEAP_CAPACITY);
+            column->heap_capacity = INITIAL_HEAP_CAPACITY;
+            return (column->offsets != NULL && column->heap != NULL) ? 0 : -1;
+    }
+}
+
+static int grow_column_vector(ColumnVector* column, int new_capacity) {
+    unsigned char* nulls = realloc(column->nulls, new_capacity * sizeof(unsigned char));
+    if (nulls == NULL) {
+        return -1;
+    }
+    column->nulls = nulls;
+
+    if (column->type == TYPE_INT) {
+        long long* ints = realloc(column->ints, new_capacity * sizeof(long long));
+        if (ints == NULL) {
+            return -1;
+        }
+        column->ints = ints;
+    } else if (column->type == TYPE_FLOAT) {
+        double* floats = realloc(column->floats, new_capacity * sizeof(double));
+        if (floats == NULL) {
+            return -1;
+        }
+        column->floats = floats;
+    } else {
+        size_t* offsets = realloc(column->offsets, new_capacity * sizeof(size_t));
+        if (offsets == NULL) {
+            return -1;
+        }
+        column->offsets = offsets;
+    }
+    return 0;
+}
+
+// 把一个单元格写入列向量，调用者保证类型匹配
+static int store_cell(ColumnVector* column, int row, const char* value) {
+    if (is_null_cell(value, column->type)) {
+        column->nulls[row] = 1;
+        if (column->type == TYPE_INT) {
+            column->ints[row] = 0;
+        } else if (column->type == TYPE_FLOAT) {
+            column->floats[row] = 0.0;
+        } else {
+            column->offsets[row] = 0;
+        }
+        return 0;
+    }
+
+    column->nulls[row] = 0;
+    switch (column->type) {
+        case TYPE_INT:
+            return parse_int_cell(value, &column->ints[row]) ? 0 : -1;
+        case TYPE_FLOAT:
+            return parse_float_cell(value, &column->floats[row]) ? 0 : -1;
+        default: {
+            size_t len = strlen(value) + 1;
+            if (column->heap_size + len > column->heap_capacity) {
+                size_t new_capacity = column->heap_capacity * 2;
+                while (new_capacity < column->heap_size + len) {
+                    new_capacity *= 2;
+                }
+                char* heap = realloc(column->heap, new_capacity);
+                if (heap == NULL) {
+                    return -1;
+                }
+                column->heap = heap;
+                column->heap_capacity = new_capacity;
+            }
+            memcpy(column->heap + column->heap_size, value, len);
+            column->offsets[row] = column->heap_size;
+            column->heap_size += len;
+            return 0;
+        }
+    }
+}
+
+static void free_zone_map(ZoneMap* zones) {
+    free(zones->mins);
+    free(zones->maxs);
+    free(zones->null_counts);
+    memset(zones, 0, sizeof(ZoneMap));
+}
+
+// 把一行计入所在的块 (行按顺序加入，新块从该块的第一行开始)
+static int zone_add_row(ZoneMap* zones, const ColumnVector* column, int row) {
+    int zone = row / ZONE_ROWS;
+    if (zone == zones->count) {
+        if (zones->count == zones->capacity) {
+            int capacity = (zones->capacity == 0) ? 4 : zones->capacity * 2;
+            double* mins = realloc(zones->mins, capacity * sizeof(double));
+            if (mins == NULL) {
+                return -1;
+            }
+            zones->mins = mins;
+            double* maxs = realloc(zones->maxs, capacity * sizeof(double));
+            if (maxs == NULL) {
+                return -1;
+            }
+            zones->maxs = maxs;
+            int* null_counts = realloc(zones->null_counts, capacity * sizeof(int));
+            if (null_counts == NULL) {
+                return -1;
+            }
+            zones->null_counts = null_counts;
+            zones->capacity = capacity;
+        }
+        zones->mins[zone] = INFINITY;
+        zones->maxs[zone] = -INFINITY;
+        zones->null_counts[zone] = 0;
+        zones->count++;
+    }
+
+    if (column->nulls[row]) {
+        zones->null_counts[zone]++;
+    }
+    double value = (column->type == TYPE_INT) ? (double)column->ints[row] : column->floats[row];
+    if (value < zones->mins[zone]) {
+        zones->mins[zone] = value;
+    }
+    if (value > zones->maxs[zone]) {
+        zones->maxs[zone] = value;
+    }
+    return 0;
+}
+
+// 按列的前rows行重建区域映射，字符串列没有区域映射
+static int build_zone_map(ZoneMap* zones, const ColumnVector* column, int rows) {
+    free_zone_map(zones);
+    if (!column_is_numeric(column)) {
+        return 0;
+    }
+    for (int row = 0; row < rows; row++) {
+        if (zone_add_row(zones, column, row) != 0) {
+            free_zone_map(zones);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int build_zone_maps(ColumnStore* store, int col_count) {
+    if (store == NULL) {
+        return -1;
+    }
+    for (int col = 0; col < col_count; col++) {
+        if (build_zone_map(&store->zones[col], &store->columns[col], store->row_count) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 从行视图重建一列 (行 [0, rows))
+static int fill_column(Table* table, int col, DataType type, int rows, int capacity) {
+    ColumnVector* column = &table->store->columns[col];
+
+    free_column_vector(column);
+    if (init_column_vector(column, type, capacity) != 0) {
+        free_column_vector(column);
+        return -1;
+    }
+
+    for (int row = 0; row < rows; row++) {
+        if (store_cell(column, row, table->data[row][col]) != 0) {
+            free_column_vector(column);
+            return -1;
+        }
+    }
+    table->columns[col].type = column->type;
+    return 0;
+}
+
+// 根据推断的列类型建立列式存储；推断类型在完整扫描中被证明过窄时会自动放宽
+int build_column_store(Table* table) {
+    if (table == NULL) {
+        return -1;
+    }
+
+    if (table->store != NULL) {
+        free_column_store(table->store);
+        table->store = NULL;
+    }
+
+    ColumnStore* store = calloc(1, sizeof(ColumnStore));
+    if (store == NULL) {
+        return -1;
+    }
+    store->capacity = (table->row_count > 0) ? table->row_count : INITIAL_CAPACITY;
+    table->store = store;
+
+    for (int col = 0; col < table->col_count; col++) {
+        DataType type = table->columns[col].type;
+        if (type != TYPE_INT && type != TYPE_FLOAT) {
+            type = TYPE_STRING;
+        }
+        for (int row = 0; row < table->row_count && type != TYPE_STRING; row++) {
+            type = widen_type(type, table->data[row][col]);
+        }
+
+        if (fill_column(table, col, type, table->row_count, store->capacity) != 0) {
+            free_column_store(store);
+            table->store = NULL;
+            return -1;
+        }
+    }
+
+    store->row_count = table->row_count;
+    if (build_zone_maps(store, table->col_count) != 0) {
+        free_column_store(store);
+        table->store = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// 快照映射中的数组是只读的，追加前先复制到堆上
+static int detach_column_store(ColumnStore* store, int col_count) {
+    int capacity = (store->row_count > 0) ? store->row_count * 2 : INITIAL_CAPACITY;
+
+    for (int col = 0; col < col_count; col++) {
+        ColumnVector* column = &store->columns[col];
+        ColumnVector copy;
+        if (init_column_vector(&copy, column->type, capacity) != 0) {
+            free_column_vector(&copy);
+            return -1;
+        }
+
+        memcpy(copy.nulls, column->nulls, store->row_count);
+        if (column->type == TYPE_INT) {
+            memcpy(copy.ints, column->ints, store->row_count * sizeof(long long));
+        } else if (column->type == TYPE_FLOAT) {
+            memcpy(copy.floats, column->floats, store->row_count * sizeof(double));
+        } else {
+            memcpy(copy.offsets, column->offsets, store->row_count * sizeof(size_t));
+            if (column->heap_size > copy.heap_capacity) {
+                char* heap = realloc(copy.heap, column->heap_size);
+                if (heap == NULL) {
+                    free_column_vector(&copy);
+                    return -1;
+                }
+                copy.heap = heap;
+                copy.heap_capacity = column->heap_size;
+            }
+            memcpy(copy.heap, column->heap, column->heap_size);
+            copy.heap_size = column->heap_size;
+        }
+        *column = copy;
+    }
+
+    store->capacity = capacity;
+    store->mapped = 0;
+    return 0;
+}
+
+// 把行视图中刚加入的一行追加到列式存储
+int column_store_append_row(Table* table, int row) {
+    if (table == NULL || table->store == NULL || row != table->store->row_count) {
+        return -1;
+    }
+
+    ColumnStore* store = table->store;
+    if (store->mapped && detach_column_store(store, table->col_count) != 0) {
+        return -1;
+    }
+    if (row >= store->capacity) {
+        int new_capacity = store->capacity * 2;
+        for (int col = 0; col < table->col_count; col++) {
+            if (grow_column_vector(&store->columns[col], new_capacity) != 0) {
+                return -1;
+            }
+        }
+        store->capacity = new_capacity;
+    }
+
+    for (int col = 0; col < table->col_count; col++) {
+        ColumnVector* column = &store->columns[col];
+        const char* value = table->data[row][col];
+        DataType type = widen_type(column->type, value);
+
+        if (type != column->type) {
+            // 新值不符合当前类型，整列按更通用的类型重建
+            if (fill_column(table, col, type, row + 1, store->capacity) != 0 ||
+                build_zone_map(&store->zones[col], column, row + 1) != 0) {
+                return -1;
+            }
+        } else if (store_cell(column, row, value) != 0) {
+            return -1;
+        } else if (column_is_numeric(column) && zone_add_row(&store->zones[col], column, row) != 0) {
+            return -1;
+        }
+    }
+
+    store->row_count++;
+    return 0;
+}
+
+void free_column_store(ColumnStore* store) {
+    if (store == NULL) {
+        return;
+    }
+
+    // 映射的数组属于快照文件，由free_table解除映射；区域映射总在堆上
+    for (int col = 0; col < MAX_COLUMNS; col++) {
+        if (!store->mapped) {
+            free_column_vector(&store->columns[col]);
+        }
+        free_zone_map(&store->zones[col]);
+    }
+    free(store);
+}
+
+int column_is_numeric(const ColumnVector* column) {
+    return column != NULL && (column->type == TYPE_INT || column->type == TYPE_FLOAT);
+}
+
+double column_get_double(const ColumnVector* column, int row) {
+    if (column->type == TYPE_INT) {
+        return (double)column->ints[row];
+    }
+    if (column->type == TYPE_FLOAT) {
+        return column->floats[row];
+    }
+    return atof(column_get_string(column, row) ? column_get_string(column, row) : "");
+}
+
+const char* column_get_string(const ColumnVector* column, int row) {
+    if (column->type != TYPE_STRING || column->nulls[row]) {
+        return NULL;
+    }
+    return column->heap + column->offsets[row];
+}
@@ -0,0 +1,19 @@
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#include "table.h"
+
+// 列式存储函数
+int build_column_store(Table* table);
+void free_column_store(ColumnStore* store);
+int column_store_append_row(Table* table, int row);
+
+// 重新计算前col_count列的区域映射 (用于从快照映射的列式存储)
+int build_zone_maps(ColumnStore* store, int col_count);
+
+// 列值访问
+int column_is_numeric(const ColumnVector* column);
+double column_get_double(const ColumnVector* column, int row);
+const char* column_get_string(const ColumnVector* column, int row);
+
+#endif // COLUMN_STORE_H
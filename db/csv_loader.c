@@ -1,61 +1,668 @@
+/* Activate POSIX capabilities for mmap */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "csv_loader.h"
+#include "column_store.h"
+#include "csv_scan.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#endif
+
+#define PARALLEL_MIN_BYTES (4 * 1024 * 1024)
+#define MAX_LOAD_THREADS 64
+
+// Whole CSV file, mapped read-only (or read into memory on Windows)
+typedef struct {
+    const char* data;
+    size_t size;
+    int mapped;
+} CsvFile;
+
+static int open_csv_file(const char* filename, CsvFile* file) 
+{
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) 
+    {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) 
+    {
+        close(fd);
+        return -1;
+    }
+
+    file->size = (size_t)st.st_size;
+    if (file->size > 0) 
+    {
+        void* data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) 
+        {
+            close(fd);
+            return -1;
+        }
+        posix_madvise(data, file->size, POSIX_MADV_SEQUENTIAL);
+        file->data = data;
+        file->mapped = 1;
+    }
+    close(fd);
+    return 0;
+#else
+    FILE* fp = fopen(filename, "rb");
+    if (fp == NULL) 
+    {
+        return -1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size < 0) 
+    {
+        fclose(fp);
+        return -1;
+    }
+
+    char* data = malloc(size > 0 ? size : 1);
+    if (data == NULL || fread(data, 1, size, fp) != (size_t)size) 
+    {
+        free(data);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    file->data = data;
+    file->size = (size_t)size;
+    return 0;
+#endif
+}
+
+static void close_csv_file(CsvFile* file) 
+{
+#ifndef _WIN32
+    if (file->mapped) 
+    {
+        munmap((void*)file->data, file->size);
+    }
+#else
+    free((void*)file->data);
+#endif
+    file->data = NULL;
+    file->size = 0;
+}
+
+// Next occurrence of c in [p, end) outside double quotes
+static const char* find_unquoted(const char* p, const char* end, char c) 
+{
+    int in_quotes = 0;
+    for (; p < end; p++) 
+    {
+        if (*p == '"') 
+        {
+            in_quotes = !in_quotes;
+        } 
+        else if (*p == c && !in_quotes) 
+        {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// End of the record starting at p (position of '\n' or end)
+static const char* find_record_end(const char* p, const char* end) 
+{
+    const char* newline = find_unquoted(p, end, '\n');
+    return (newline != NULL) ? newline : end;
+}
+
+// Trim spaces around [*start, *stop) and strip the enclosing quotes of a
+// quoted field. Returns 1 if the remaining content contains escaped quotes.
+static int trim_field(const char** start, const char** stop) 
+{
+    const char* a = *start;
+    const char* b = *stop;
+    while (a < b && *a == ' ') a++;
+    while (b > a && b[-1] == ' ') b--;
+
+    int escaped = 0;
+    if (b - a >= 2 && *a == '"' && b[-1] == '"') 
+    {
+        a++;
+        b--;
+        escaped = memchr(a, '"', b - a) != NULL;
+    }
+    *start = a;
+    *stop = b;
+    return escaped;
+}
+
+// Split one record [p, end) in place (used for the header line).
+// Returns the number of fields found (at most max_fields).
+static int split_record(const char* p, const char* end, const char** fields, int* lengths, int max_fields) 
+{
+    if (end > p && end[-1] == '\r') 
+    {
+        end--;
+    }
+
+    int count = 0;
+    while (count < max_fields) 
+    {
+        const char* comma = find_unquoted(p, end, ',');
+        const char* field_end = (comma != NULL) ? comma : end;
+
+        const char* start = p;
+        const char* stop = field_end;
+        trim_field(&start, &stop);
+
+        fields[count] = start;
+        lengths[count] = (int)(stop - start);
+        count++;
+
+        if (comma == NULL) 
+        {
+            break;
+        }
+        p = comma + 1;
+    }
+    return count;
+}
+
+static int is_blank_record(const char* p, const char* end) 
+{
+    while (p < end && (*p == '\r' || *p == ' ')) p++;
+    return p == end;
+}
+
+// Field splitter state, fed with structural positions by the block scanner
+typedef struct {
+    Table* table;
+    const char* record_start;
+    const char* field_start;
+    const char* fields[MAX_COLUMNS];
+    int lengths[MAX_COLUMNS];
+    int field_count;
+    int row_count;
+    uint64_t in_quotes;           // all ones if the previous block ended inside quotes
+    char* scratch;                // unescaped copies of fields containing ""
+    size_t scratch_size;
+    size_t scratch_capacity;
+    long scratch_offsets[MAX_COLUMNS];
+} RecordBuilder;
+
+// Copy a quoted field with "" escapes into the scratch buffer, unescaped.
+// Pointers are resolved in end_record because the buffer may move.
+static void unescape_field(RecordBuilder* builder, int index, const char* start, const char* stop) 
+{
+    size_t needed = builder->scratch_size + (size_t)(stop - start);
+    if (needed > builder->scratch_capacity) 
+    {
+        size_t new_capacity = (builder->scratch_capacity > 0) ? builder->scratch_capacity * 2 : 256;
+        while (new_capacity < needed) new_capacity *= 2;
+        char* scratch = realloc(builder->scratch, new_capacity);
+        if (scratch == NULL) 
+        {
+            builder->fields[index] = start;
+            builder->lengths[index] = (int)(stop - start);
+            return;
+        }
+        builder->scratch = scratch;
+        builder->scratch_capacity = new_capacity;
+    }
+
+    char* out = builder->scratch + builder->scratch_size;
+    char* begin = out;
+    for (const char* p = start; p < stop; p++) 
+    {
+        *out++ = *p;
+        if (*p == '"' && p + 1 < stop && p[1] == '"') 
+        {
+            p++;
+        }
+    }
+    builder->scratch_offsets[index] = (long)builder->scratch_size;
+    builder->lengths[index] = (int)(out - begin);
+    builder->scratch_size += (size_t)(out - begin);
+}
+
+static void end_field(RecordBuilder* builder, const char* field_end) 
+{
+    // Fields beyond the header width are ignored
+    int index = builder->field_count;
+    if (index < builder->table->col_count) 
+    {
+        const char* start = builder->field_start;
+        const char* stop = field_end;
+        builder->scratch_offsets[index] = -1;
+
+        if (trim_field(&start, &stop)) 
+        {
+            unescape_field(builder, index, start, stop);
+        } 
+        else 
+        {
+            builder->fields[index] = start;
+            builder->lengths[index] = (int)(stop - start);
+        }
+    }
+    builder->field_count++;
+}
+
+static void end_record(RecordBuilder* builder, const char* record_end) 
+{
+    if (!is_blank_record(builder->record_start, record_end)) 
+    {
+        if (builder->field_count >= builder->table->col_count) 
+        {
+            for (int i = 0; i < builder->table->col_count; i++) 
+            {
+                if (builder->scratch_offsets[i] >= 0) 
+                {
+                    builder->fields[i] = builder->scratch + builder->scratch_offsets[i];
+                }
+            }
+
+            if (add_row_len(builder->table, builder->fields, builder->lengths) != 0) 
+            {
+                printf("Failed to add row\n");
+            } 
+            else 
+            {
+                builder->row_count++;
+            }
+        } 
+        else 
+        {
+            printf("Skipping incomplete data row: %.*s\n",
+                   (int)(record_end - builder->record_start), builder->record_start);
+        }
+    }
+    builder->field_count = 0;
+    builder->scratch_size = 0;
+}
+
+// Handle one delimiter or newline found by the scanner
+static void on_structural(RecordBuilder* builder, const char* c) 
+{
+    if (*c == ',') 
+    {
+        end_field(builder, c);
+    } 
+    else 
+    {
+        const char* field_end = c;
+        if (field_end > builder->field_start && field_end[-1] == '\r') 
+        {
+            field_end--;
+        }
+        end_field(builder, field_end);
+        end_record(builder, c);
+        builder->record_start = c + 1;
+    }
+    builder->field_start = c + 1;
+}
+
+// Positions inside quotes: prefix XOR of the quote bits, so a bit is set
+// after an odd number of quotes. "" escapes toggle twice and cancel out.
+static uint64_t quoted_region_mask(uint64_t quotes, uint64_t carry) 
+{
+    uint64_t mask = quotes;
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+    return mask ^ carry;
+}
+
+// Parse every record in [p, end) and add it to the table.
+// The file is scanned 64 bytes at a time; only the set bits of the
+// delimiter/newline masks outside quoted regions are visited.
+static int parse_records(Table* table, const char* p, const char* end) 
+{
+    RecordBuilder builder;
+    builder.table = table;
+    builder.record_start = p;
+    builder.field_start = p;
+    builder.field_count = 0;
+    builder.row_count = 0;
+    builder.in_quotes = 0;
+    builder.scratch = NULL;
+    builder.scratch_size = 0;
+    builder.scratch_capacity = 0;
+
+    char tail[CSV_SCAN_BLOCK];
+    for (; p < end; p += CSV_SCAN_BLOCK) 
+    {
+        size_t remaining = (size_t)(end - p);
+        const char* block = p;
+        CsvBlockMasks masks;
+
+        // Pad the last partial block with zeros
+        if (remaining < CSV_SCAN_BLOCK) 
+        {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, p, remaining);
+            block = tail;
+        }
+        csv_scan_block(block, &masks);
+
+        uint64_t quoted = quoted_region_mask(masks.quotes, builder.in_quotes);
+        builder.in_quotes = (uint64_t)0 - (quoted >> 63);
+
+        uint64_t bits = (masks.delimiters | masks.newlines) & ~quoted;
+        while (bits != 0) 
+        {
+            on_structural(&builder, p + csv_pop_lowest_bit(&bits));
+        }
+    }
+
+    // Last record without a trailing newline
+    if (builder.record_start < end) 
+    {
+        const char* field_end = end;
+        if (field_end > builder.field_start && field_end[-1] == '\r') 
+        {
+            field_end--;
+        }
+        end_field(&builder, field_end);
+        end_record(&builder, end);
+    }
+
+    free(builder.scratch);
+    return builder.row_count;
+}
+
+#ifndef _WIN32
+// One byte range of the file, parsed on its own thread into a partial table
+typedef struct {
+    const char* begin;
+    const char* end;
+    size_t quote_count;
+    Table* table;
+    int row_count;
+    DataType types[MAX_COLUMNS];
+} CsvChunk;
+
+static void* count_quotes_worker(void* arg) 
+{
+    CsvChunk* chunk = arg;
+    size_t count = 0;
+    char tail[CSV_SCAN_BLOCK];
+
+    for (const char* p = chunk->begin; p < chunk->end; p += CSV_SCAN_BLOCK) 
+    {
+        size_t remaining = (size_t)(chunk->end - p);
+        const char* block = p;
+        CsvBlockMasks masks;
+
+        if (remaining < CSV_SCAN_BLOCK) 
+        {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, p, remaining);
+            block = tail;
+        }
+        csv_scan_block(block, &masks);
+        count += csv_popcount(masks.quotes);
+    }
+    chunk->quote_count = count;
+    return NULL;
+}
+
+static void* parse_chunk_worker(void* arg) 
+{
+    CsvChunk* chunk = arg;
 
-#define BUFFER_SIZE 1024
-#define INITIAL_CAPACITY 100
+    chunk->row_count = parse_records(chunk->table, chunk->begin, chunk->end);
+    for (int col = 0; col < chunk->table->col_count; col++) 
+    {
+        chunk->types[col] = TYPE_UNKNOWN;
+    }
+    observe_column_types(chunk->table, 0, chunk->table->row_count, chunk->types);
+    return NULL;
+}
 
+// Run a worker on its own thread, or on the calling thread when no thread can be
+// created (EAGAIN under process or container limits). Returns 1 when a thread was
+// started and has to be joined.
+static int start_worker(pthread_t* thread, void* (*worker)(void*), CsvChunk* chunk) 
+{
+    if (pthread_create(thread, NULL, worker, chunk) == 0) 
+    {
+        return 1;
+    }
+    worker(chunk);
+    return 0;
+}
+
+// First record start at or after p, given the quote parity before p:
+// a newline only ends a record when it is outside quotes
+static const char* next_record_start(const char* p, const char* end, int in_quotes) 
+{
+    for (; p < end; p++) 
+    {
+        if (*p == '"') 
+        {
+            in_quotes = !in_quotes;
+        } 
+        else if (*p == '\n' && !in_quotes) 
+        {
+            return p + 1;
+        }
+    }
+    return end;
+}
+
+static int online_cpu_count(void) 
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) 
+    {
+        return 1;
+    }
+    return (n > MAX_LOAD_THREADS) ? MAX_LOAD_THREADS : (int)n;
+}
+
+// Split [begin, end) into record-aligned chunks, parse them in parallel and
+// concatenate the partial tables in file order. Returns rows loaded or -1.
+static int parse_records_parallel(Table* table, const char* begin, const char* end, int thread_count) 
+{
+    CsvChunk chunks[MAX_LOAD_THREADS];
+    pthread_t threads[MAX_LOAD_THREADS];
+    int joinable[MAX_LOAD_THREADS];
+    size_t span = (size_t)(end - begin) / thread_count;
+
+    // Pick the scanner implementation before the workers start using it
+    csv_scanner_name();
+
+    // Pass 1: count quotes per raw byte range to know the quote state at each split point
+    for (int i = 0; i < thread_count; i++) 
+    {
+        chunks[i].begin = begin + i * span;
+        chunks[i].end = (i == thread_count - 1) ? end : begin + (i + 1) * span;
+        chunks[i].table = NULL;
+        joinable[i] = start_worker(&threads[i], count_quotes_worker, &chunks[i]);
+    }
+    for (int i = 0; i < thread_count; i++) 
+    {
+        if (joinable[i]) 
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    // Move every split point forward to the next record boundary
+    const char* starts[MAX_LOAD_THREADS + 1];
+    size_t quotes_before = 0;
+    starts[0] = begin;
+    for (int i = 1; i < thread_count; i++) 
+    {
+        quotes_before += chunks[i - 1].quote_count;
+        starts[i] = next_record_start(chunks[i].begin, end, (int)(quotes_before & 1));
+        if (starts[i] < starts[i - 1]) 
+        {
+            starts[i] = starts[i - 1];
+        }
+    }
+    starts[thread_count] = end;
+
+    // Pass 2: parse each chunk into a thread-local partial table
+    const char* col_names[MAX_COLUMNS];
+    for (int col = 0; col < table->col_count; col++) 
+    {
+        col_names[col] = table->columns[col].name;
+    }
+
+    int started = 0;
+    for (int i = 0; i < thread_count; i++) 
+    {
+        chunks[i].begin = starts[i];
+        chunks[i].end = starts[i + 1];
+        chunks[i].table = create_table(table->name, table->col_count, col_names);
+        if (chunks[i].table == NULL) 
+        {
+            break;
+        }
+        joinable[i] = start_worker(&threads[i], parse_chunk_worker, &chunks[i]);
+        started++;
+    }
+    for (int i = 0; i < started; i++) 
+    {
+        if (joinable[i]) 
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    if (started < thread_count) 
+    {
+        for (int i = 0; i < started; i++) 
+        {
+            free_table(chunks[i].table);
+        }
+        return -1;
+    }
+
+    // Concatenate: copy row pointers in order and take over the chunk arenas
+    int total_rows = 0;
+    for (int i = 0; i < thread_count; i++) 
+    {
+        total_rows += chunks[i].table->row_count;
+    }
+
+    table->data = malloc((total_rows > 0 ? total_rows : 1) * sizeof(char**));
+    if (table->data == NULL) 
+    {
+        for (int i = 0; i < thread_count; i++) 
+        {
+            free_table(chunks[i].table);
+        }
+        return -1;
+    }
+    table->capacity = (total_rows > 0) ? total_rows : 1;
+
+    DataType types[MAX_COLUMNS];
+    for (int col = 0; col < table->col_count; col++) 
+    {
+        types[col] = TYPE_UNKNOWN;
+    }
+
+    int row_count = 0;
+    for (int i = 0; i < thread_count; i++) 
+    {
+        Table* part = chunks[i].table;
+        memcpy(table->data + table->row_count, part->data, part->row_count * sizeof(char**));
+        table->row_count += part->row_count;
+        arena_adopt(table->arena, part->arena);
+        row_count += chunks[i].row_count;
+
+        for (int col = 0; col < table->col_count; col++) 
+        {
+            types[col] = merge_data_type(types[col], chunks[i].types[col]);
+        }
+        free_table(part);
+    }
+
+    // Column types come from the merged per-chunk observations
+    for (int col = 0; col < table->col_count; col++) 
+    {
+        table->columns[col].type = (types[col] == TYPE_UNKNOWN) ? TYPE_STRING : types[col];
+    }
+    return row_count;
+}
+#endif
+
+// Single pass over the mapped file: fields are copied straight from the
+// mapping into the table's arena, no line buffer and no strtok
 Table* load_csv(const char* filename) 
 {
-    FILE* file = fopen(filename, "r");
-    if (file == NULL) 
+    return load_csv_threads(filename, 0);
+}
+
+// thread_count: 0 = one thread per online CPU for large files, 1 = sequential
+Table* load_csv_threads(const char* filename, int thread_count) 
+{
+    CsvFile file;
+    if (open_csv_file(filename, &file) != 0) 
     {
         printf("Cannot open file: %s\n", filename);
         return NULL;
     }
 
-    char buffer[BUFFER_SIZE];
-    
-    // Read header
-    if (fgets(buffer, sizeof(buffer), file) == NULL) 
+    const char* p = file.data;
+    const char* end = file.data + file.size;
+
+    // Skip UTF-8 BOM
+    if (file.size >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) 
     {
-        fclose(file);
+        p += 3;
+    }
+
+    if (p >= end) 
+    {
+        close_csv_file(&file);
         printf("no header\n");
         printf("File is empty or read failed\n");
         return NULL;
     }
 
     // Parse column names
-    char* token;
-    char* col_names[MAX_COLUMNS];
-    int col_count = 0;
-    
-    // Remove newline characters
-    buffer[strcspn(buffer, "\r\n")] = 0;
-    
-    token = strtok(buffer, ",");
-    while (token != NULL && col_count < MAX_COLUMNS) 
+    const char* header_end = find_record_end(p, end);
+    const char* header_fields[MAX_COLUMNS];
+    int header_lengths[MAX_COLUMNS];
+    int col_count = split_record(p, header_end, header_fields, header_lengths, MAX_COLUMNS);
+
+    char col_name_buf[MAX_COLUMNS][MAX_COLUMN_NAME_LEN];
+    const char* col_names[MAX_COLUMNS];
+    for (int i = 0; i < col_count; i++) 
     {
-        // Remove leading and trailing spaces
-        while (*token == ' ') 
-        {
-            token++;
-        }
-        char* end = token + strlen(token) - 1;
-        while (end > token && *end == ' ') 
+        int len = header_lengths[i];
+        if (len > MAX_COLUMN_NAME_LEN - 1) 
         {
-            end--;
+            len = MAX_COLUMN_NAME_LEN - 1;
         }
-
-        *(end + 1) = '\0';
-        
-        col_names[col_count] = malloc(strlen(token) + 1);
-        strcpy(col_names[col_count], token);
-        col_count++;
-        
-        token = strtok(NULL, ",");
+        memcpy(col_name_buf[i], header_fields[i], len);
+        col_name_buf[i][len] = '\0';
+        col_names[i] = col_name_buf[i];
     }
 
     // Create table
@@ -67,71 +674,64 @@ Table* load_csv(const char* filename)
 
 
     strncpy(table_name, table_name_start, sizeof(table_name) - 1);
+    table_name[sizeof(table_name) - 1] = '\0';
     char* dot = strrchr(table_name, '.');
     if (dot != NULL) *dot = '\0';
     
-    Table* table = create_table(table_name, col_count, (const char**)col_names);
-    
-    // Free column names memory
-    for (int i = 0; i < col_count; i++) 
-    {
-        free(col_names[i]);
-    }
-
+    Table* table = create_table(table_name, col_count, col_names);
     if (table == NULL) 
     {
-        fclose(file);
+        close_csv_file(&file);
         return NULL;
     }
 
     // Read data rows
-    int row_count = 0;
-    while (fgets(buffer, sizeof(buffer), file) != NULL) {
-        // Remove newline characters
-        buffer[strcspn(buffer, "\r\n")] = 0;
-        
-        if (strlen(buffer) == 0) 
-        {
-            continue;
-        }
-        
-        char* row_data[MAX_COLUMNS];
-        int data_count = 0;
-        
-        token = strtok(buffer, ",");
-        while (token != NULL && data_count < col_count) {
-            // Remove leading and trailing spaces
-            while (*token == ' ') token++;
-            char* end = token + strlen(token) - 1;
-            while (end > token && *end == ' ') end--;
-            *(end + 1) = '\0';
-            
-            row_data[data_count] = token;
-            data_count++;
-            
-            token = strtok(NULL, ",");
-        }
-        
-        if (data_count == col_count) {
-            if (add_row(table, (const char**)row_data) != 0) 
-            {
-                printf("Failed to add row\n");
-            } 
-            else
-             {
-                row_count++;
-            }
-        } 
-        else
-         {
-            printf("Skipping incomplete data row: %s\n", buffer);
+    const char* data_begin = (header_end < end) ? header_end + 1 : end;
+    int row_count;
+    int types_known = 0;
+
+#ifndef _WIN32
+    if (thread_count == 0) 
+    {
+        thread_count = ((size_t)(end - data_begin) >= PARALLEL_MIN_BYTES) ? online_cpu_count() : 1;
+    }
+    if (thread_count > MAX_LOAD_THREADS) 
+    {
+        thread_count = MAX_LOAD_THREADS;
+    }
+
+    if (thread_count > 1) 
+    {
+        row_count = parse_records_parallel(table, data_begin, end, thread_count);
+        if (row_count < 0) 
+        {
+            close_csv_file(&file);
+            free_table(table);
+            printf("Parallel load failed\n");
+            return NULL;
         }
+        types_known = 1;
+    } 
+    else
+#endif
+    {
+        (void)thread_count;
+        row_count = parse_records(table, data_begin, end);
     }
 
-    fclose(file);
+    close_csv_file(&file);
     
     // Infer column types
-    infer_column_types(table);
+    if (!types_known) 
+    {
+        infer_column_types(table);
+    }
+
+    // Build typed column storage
+    if (build_column_store(table) != 0) 
+    {
+        printf("Column store build failed, using row storage only\n");
+    }
     
     printf("Successfully loaded %d rows of data\n", row_count);
     return table;
@@ -144,10 +744,11 @@ int detect_data_type(const char* value)
         return TYPE_UNKNOWN;
     }
     
-    // Check if it's an integer
+    // Check if it's an integer (out of long long range counts as float, same as the column store)
     char* end;
-    strtol(value, &end, 10);
-    if (*end == '\0') 
+    errno = 0;
+    strtoll(value, &end, 10);
+    if (*end == '\0' && errno != ERANGE) 
     {
         return TYPE_INT;
     }
@@ -163,40 +764,53 @@ int detect_data_type(const char* value)
     return TYPE_STRING;
 }
 
+// Combine two type observations into the most specific type covering both
+DataType merge_data_type(DataType a, DataType b) 
+{
+    if (a == TYPE_UNKNOWN) return b;
+    if (b == TYPE_UNKNOWN) return a;
+    if (a == b) return a;
+    if ((a == TYPE_INT && b == TYPE_FLOAT) || (a == TYPE_FLOAT && b == TYPE_INT)) 
+    {
+        return TYPE_FLOAT;
+    }
+    return TYPE_STRING;
+}
+
+// Fold the types of rows [start_row, end_row) into types[]
+void observe_column_types(const Table* table, int start_row, int end_row, DataType* types) 
+{
+    for (int col = 0; col < table->col_count; col++) 
+    {
+        DataType detected_type = types[col];
+        for (int row = start_row; row < end_row && detected_type != TYPE_STRING; row++) 
+        {
+            if (table->data[row][col] != NULL) 
+            {
+                detected_type = merge_data_type(detected_type, detect_data_type(table->data[row][col]));
+            }
+        }
+        types[col] = detected_type;
+    }
+}
+
 void infer_column_types(Table* table) 
 {
     if (table == NULL || table->row_count == 0) 
     {
         return;
     }
-    
-    for (int col = 0; col < table->col_count; col++)
-     {
-        DataType detected_type = TYPE_UNKNOWN;
-        
-        // Check first few rows to infer type
-        for (int row = 0; row < table->row_count && row < 10; row++) {
-            if (table->data[row][col] != NULL) {
-                DataType current_type = detect_data_type(table->data[row][col]);
-                
-                if (detected_type == TYPE_UNKNOWN) {
-                    detected_type = current_type;
-                } else if (detected_type != current_type) {
-                    // If types are inconsistent, use more general type
-                    if (detected_type == TYPE_INT && current_type == TYPE_FLOAT) {
-                        detected_type = TYPE_FLOAT;
-                    } else if (detected_type != TYPE_STRING) {
-                        detected_type = TYPE_STRING;
-                    }
-                }
-            }
-        }
-        
+
+    DataType types[MAX_COLUMNS];
+    for (int col = 0; col < table->col_count; col++) 
+    {
+        types[col] = TYPE_UNKNOWN;
+    }
+    observe_column_types(table, 0, table->row_count, types);
+
+    for (int col = 0; col < table->col_count; col++) 
+    {
         // If no type detected, default to string
-        if (detected_type == TYPE_UNKNOWN) {
-            detected_type = TYPE_STRING;
-        }
-        
-        table->columns[col].type = detected_type;
+        table->columns[col].type = (types[col] == TYPE_UNKNOWN) ? TYPE_STRING : types[col];
     }
 }
@@ -5,7 +5,10 @@
 
 // CSV加载函数
 Table* load_csv(const char* filename);
+Table* load_csv_threads(const char* filename, int thread_count);
 int detect_data_type(const char* value);
+DataType merge_data_type(DataType a, DataType b);
+void observe_column_types(const Table* table, int start_row, int end_row, DataType* types);
 void infer_column_types(Table* table);
 
 #endif // CSV_LOADER_H
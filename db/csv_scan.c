@@ -0,0 +1,103 @@
+#include "csv_scan.h"
+#include <stddef.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CSV_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*CsvScanFn)(const char* block, CsvBlockMasks* masks);
+
+// 标量实现: 所有平台都可用
+static void scan_block_scalar(const char* block, CsvBlockMasks* masks) {
+    uint64_t delimiters = 0, quotes = 0, newlines = 0;
+    for (int i = 0; i < CSV_SCAN_BLOCK; i++) {
+        uint64_t bit = (uint64_t)1 << i;
+        char c = block[i];
+        if (c == ',') delimiters |= bit;
+        else if (c == '"') quotes |= bit;
+        else if (c == '\n') newlines |= bit;
+    }
+    masks->delimiters = delimiters;
+    masks->quotes = quotes;
+    masks->newlines = newlines;
+}
+
+#ifdef CSV_SCAN_X86
+// SSE2: 每次比较16字节
+__attribute__((target("sse2")))
+static uint64_t match_sse2(const char* block, char c) {
+    __m128i needle = _mm_set1_epi8(c);
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+        uint64_t bits = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        mask |= bits << (16 * i);
+    }
+    return mask;
+}
+
+__attribute__((target("sse2")))
+static void scan_block_sse2(const char* block, CsvBlockMasks* masks) {
+    masks->delimiters = match_sse2(block, ',');
+    masks->quotes = match_sse2(block, '"');
+    masks->newlines = match_sse2(block, '\n');
+}
+
+// AVX2: 每次比较32字节
+__attribute__((target("avx2")))
+static uint64_t match_avx2(__m256i lo, __m256i hi, char c) {
+    __m256i needle = _mm256_set1_epi8(c);
+    uint64_t low = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, needle));
+    uint64_t high = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, needle));
+    return low | (high << 32);
+}
+
+__attribute__((target("avx2")))
+static void scan_block_avx2(const char* block, CsvBlockMasks* masks) {
+    __m256i lo = _mm256_loadu_si256((const __m256i*)block);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(block + 32));
+    masks->delimiters = match_avx2(lo, hi, ',');
+    masks->quotes = match_avx2(lo, hi, '"');
+    masks->newlines = match_avx2(lo, hi, '\n');
+}
+#endif
+
+static CsvScanFn scan_impl = NULL;
+static const char* scan_impl_name = "scalar";
+
+// 第一次使用时按CPU能力选择实现 (结果与线程无关，重复选择也没有副作用)
+static CsvScanFn select_scanner(void) {
+    CsvScanFn impl = scan_block_scalar;
+    const char* name = "scalar";
+
+#ifdef CSV_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        impl = scan_block_avx2;
+        name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        impl = scan_block_sse2;
+        name = "sse2";
+    }
+#endif
+
+    scan_impl_name = name;
+    scan_impl = impl;
+    return impl;
+}
+
+void csv_scan_block(const char* block, CsvBlockMasks* masks) {
+    CsvScanFn impl = scan_impl;
+    if (impl == NULL) {
+        impl = select_scanner();
+    }
+    impl(block, masks);
+}
+
+const char* csv_scanner_name(void) {
+    if (scan_impl == NULL) {
+        select_scanner();
+    }
+    return scan_impl_name;
+}
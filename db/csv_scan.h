@@ -0,0 +1,44 @@
+#ifndef CSV_SCAN_H
+#define CSV_SCAN_H
+
+#include <stdint.h>
+
+#define CSV_SCAN_BLOCK 64
+
+// 一个64字节块中结构字符的位图，第i位对应块中第i个字节
+typedef struct {
+    uint64_t delimiters;
+    uint64_t quotes;
+    uint64_t newlines;
+} CsvBlockMasks;
+
+// 结构字符扫描函数 (运行时选择AVX2/SSE2/标量实现)
+void csv_scan_block(const char* block, CsvBlockMasks* masks);
+const char* csv_scanner_name(void);
+
+// 取出并清除最低位的1，返回其位置
+static inline int csv_pop_lowest_bit(uint64_t* bits) {
+#if defined(__GNUC__)
+    int pos = __builtin_ctzll(*bits);
+#else
+    int pos = 0;
+    while (((*bits >> pos) & 1) == 0) pos++;
+#endif
+    *bits &= *bits - 1;
+    return pos;
+}
+
+static inline int csv_popcount(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    while (bits) {
+        bits &= bits - 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+#endif // CSV_SCAN_H
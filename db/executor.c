@@ -1,375 +1,854 @@
 #include "executor.h"
+#include "column_store.h"
+#include "sort.h"
+#include "predicate.h"
+#include "batch.h"
+#include "aggregate.h"
+#include "join.h"
+#include "index.h"
+#include "stats.h"
+#include "explain.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
 
+#define INDEX_ORDER_DIVISOR 8   // 视图行数不少于表的1/8时才沿有序索引取行
 
 
-// 执行查询并返回结果
-QueryResult* execute_query(Table* table, Query* query) {
-    if (table == NULL || query == NULL) {
+
+// USING后的方法名对应的索引种类 (空表示默认的哈希索引)，未知方法返回-1
+static int parse_index_kind(const char* method, IndexKind* kind) {
+    if (method[0] == '\0' || strcmp(method, "HASH") == 0) {
+        *kind = INDEX_HASH;
+    } else if (strcmp(method, "SORTED") == 0 || strcmp(method, "BTREE") == 0) {
+        *kind = INDEX_SORTED;
+    } else if (strcmp(method, "BITMAP") == 0) {
+        *kind = INDEX_BITMAP;
+    } else if (strcmp(method, "TRIGRAM") == 0) {
+        *kind = INDEX_TRIGRAM;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static void execute_create_index(Table* table, const Query* query, QueryResult* result) {
+    IndexKind kind;
+    int col_index = get_column_index(table, query->columns[0]);
+    result->success = 0;
+
+    if (parse_index_kind(query->index_method, &kind) != 0) {
+        snprintf(result->message, sizeof(result->message), "Unknown index method: %s", query->index_method);
+    } else if (col_index == -1) {
+        snprintf(result->message, sizeof(result->message), "Column not found: %s", query->columns[0]);
+    } else if (kind == INDEX_SORTED && (table->store == NULL || !column_is_numeric(&table->store->columns[col_index]))) {
+        snprintf(result->message, sizeof(result->message), "Sorted index requires a numeric column: %s",
+                 query->columns[0]);
+    } else if (create_table_index(table, query->index_name, query->columns[0], kind) != 0) {
+        if (kind == INDEX_BITMAP) {
+            snprintf(result->message, sizeof(result->message),
+                     "Index creation failed: bitmap index allows at most %d distinct values", BITMAP_MAX_VALUES);
+        } else {
+            strcpy(result->message, "Index creation failed");
+        }
+    } else {
+        snprintf(result->message, sizeof(result->message), "Index %s created on %s(%s)",
+                 query->index_name, table->name, query->columns[0]);
+        result->success = 1;
+    }
+}
+
+// ANALYZE: 收集统计信息，结果表每列一行
+static void execute_analyze(Table* table, QueryResult* result) {
+    static const char* names[] = { "column", "type", "rows", "nulls", "distinct", "min", "max" };
+    result->success = 0;
+    if (analyze_table(table) != 0) {
+        strcpy(result->message, "Analyze failed");
+        return;
+    }
+
+    Table* summary = create_table("analyze_result", 7, names);
+    if (summary == NULL) {
+        strcpy(result->message, "Out of memory");
+        return;
+    }
+    for (int col = 0; col < table->col_count; col++) {
+        const ColumnStats* stats = &table->stats->columns[col];
+        char rows[32], nulls[32], distinct[32], min[MAX_CELL_LEN], max[MAX_CELL_LEN];
+        snprintf(rows, sizeof(rows), "%d", table->stats->row_count);
+        snprintf(nulls, sizeof(nulls), "%d", stats->null_count);
+        snprintf(distinct, sizeof(distinct), "%.0f", stats->distinct);
+        if (stats->numeric && stats->bucket_count == 0) {
+            min[0] = '\0';
+            max[0] = '\0';
+        } else if (stats->numeric) {
+            snprintf(min, sizeof(min), "%.15g", stats->min);
+            snprintf(max, sizeof(max), "%.15g", stats->max);
+        } else {
+            strcpy(min, stats->min_text);
+            strcpy(max, stats->max_text);
+        }
+        const char* row[] = { table->columns[col].name, stats->numeric ? "numeric" : "string",
+                              rows, nulls, distinct, min, max };
+        if (add_row(summary, row) != 0) {
+            free_table(summary);
+            strcpy(result->message, "Out of memory");
+            return;
+        }
+    }
+
+    result->result_table = summary;
+    result->affected_rows = summary->row_count;
+    result->success = 1;
+    snprintf(result->message, sizeof(result->message), "Table %s analyzed: %d rows, %d columns",
+             table->name, table->row_count, table->col_count);
+}
+
+// 只有COUNT(*)且WHERE完全由位图索引回答时，结果就是位图的基数，不必生成行号
+// 不能这样计算时返回NULL
+static Table* count_with_bitmaps(const Table* table, const Query* query) {
+    if (query->type != QUERY_AGGREGATE || query->where_conditions == NULL || table->indexes == NULL) {
         return NULL;
     }
 
+    FilterNode* filter = compile_filter(table, query->where_conditions);
+    if (filter == NULL) {
+        return NULL;
+    }
+    int count = index_count_rows(table, filter);
+    free_filter(filter);
+    return (count >= 0) ? aggregate_row_count(table, query, count) : NULL;
+}
+
+static int filter_view(TableView* view, const Condition* conditions, PlanStep* step);
+
+// 分组数: 各分组列的不同值个数之积 (空值算一组)，没有统计信息时取输入的1/10
+static double estimate_groups(const Table* table, const Query* query, double rows) {
+    if (query->group_by_count == 0) {
+        return 1.0;
+    }
+    double groups = 1.0;
+    int known = 0;
+    for (int i = 0; i < query->group_by_count; i++) {
+        const ColumnStats* stats = table_column_stats(table, get_column_index(table, query->group_by[i]));
+        if (stats != NULL) {
+            groups *= stats->distinct + (stats->null_count > 0 ? 1 : 0);
+            known = 1;
+        }
+    }
+    if (!known) {
+        groups = rows / 10.0;
+    }
+    if (groups > rows) {
+        groups = rows;
+    }
+    return (groups > 1.0) ? groups : 1.0;
+}
+
+// SELECT列表写成文本，用于投影和聚合算子的说明
+static void format_columns(const Query* query, char* out, size_t size) {
+    out[0] = '\0';
+    for (int i = 0; i < query->column_count; i++) {
+        size_t len = strlen(out);
+        const char* name = aggregate_name(query->aggregates[i]);
+        if (name != NULL) {
+            snprintf(out + len, size - len, "%s%s(%s)", (i > 0) ? ", " : "", name, query->columns[i]);
+        } else {
+            snprintf(out + len, size - len, "%s%s", (i > 0) ? ", " : "", query->columns[i]);
+        }
+    }
+    for (int i = 0; i < query->group_by_count; i++) {
+        size_t len = strlen(out);
+        snprintf(out + len, size - len, "%s%s", (i > 0) ? ", " : " GROUP BY ", query->group_by[i]);
+    }
+    if (out[0] == '\0') {
+        snprintf(out, size, "*");
+    }
+}
+
+// ORDER BY列表写成文本，用于排序算子的说明
+static void format_order(const Query* query, char* out, size_t size) {
+    out[0] = '\0';
+    for (int i = 0; i < query->order_by_count; i++) {
+        size_t len = strlen(out);
+        snprintf(out + len, size - len, "%s%s %s", (i > 0) ? ", " : "", query->order_by[i].column,
+                 (query->order_by[i].direction == SORT_DESC) ? "DESC" : "ASC");
+    }
+}
+
+// 按run_query的判断顺序生成计划 (只估计，不执行)，rows为输入表的 (估计) 行数
+// 代价单位约为每行一次类型化比较: 过滤用条件树估计的每行代价，排序按 n log n
+static void plan_select(const Table* table, const Query* query, double rows, QueryPlan* plan) {
+    double table_rows = rows;
+    FilterNode* filter = (query->where_conditions != NULL) ? compile_filter(table, query->where_conditions) : NULL;
+    const TableIndex* index = NULL;
+    IndexAccess access = index_filter_access(table, filter, &index);
+    char condition[120];
+    char columns[120];
+    int grouped = 0;
+
+    format_condition(query->where_conditions, condition, sizeof(condition));
+    format_columns(query, columns, sizeof(columns));
+
+    if (query->type == QUERY_AGGREGATE && filter != NULL && access == INDEX_ACCESS_EXACT &&
+        aggregate_is_row_count(table, query)) {
+        plan_add_step(plan, PLAN_INDEX_COUNT, 1.0, rows / 64.0, "%s on %s WHERE %s", columns, table->name, condition);
+        rows = 1.0;
+        grouped = 1;
+    } else {
+        plan_add_step(plan, PLAN_SCAN, rows, 0.0, "%s", table->name);
+        if (query->where_conditions != NULL) {
+            double selectivity = (filter != NULL) ? filter->selectivity : 1.0;
+            double row_cost = (filter != NULL) ? filter->cost : 1.0;
+            if (access == INDEX_ACCESS_EXACT) {
+                plan_add_step(plan, PLAN_FILTER, rows * selectivity, rows / 64.0, "%s using bitmap index", condition);
+            } else if (access == INDEX_ACCESS_CANDIDATES && index != NULL) {
+                plan_add_step(plan, PLAN_FILTER, rows * selectivity, rows * selectivity * (row_cost + 1.0),
+                              "%s using index %s", condition, index->name);
+            } else if (access == INDEX_ACCESS_CANDIDATES) {
+                plan_add_step(plan, PLAN_FILTER, rows * selectivity, rows * selectivity * (row_cost + 1.0),
+                              "%s using bitmap index candidates", condition);
+            } else {
+                plan_add_step(plan, PLAN_FILTER, rows * selectivity, rows * row_cost, "%s", condition);
+            }
+            rows *= selectivity;
+        }
+
+        if (query->type == QUERY_AGGREGATE) {
+            double groups = estimate_groups(table, query, rows);
+            plan_add_step(plan, PLAN_AGGREGATE, groups, rows * (query->column_count + query->group_by_count),
+                          "%s", columns);
+            rows = groups;
+            grouped = 1;
+        } else {
+            plan_add_step(plan, PLAN_PROJECT, rows, 0.0, "%s", columns);
+        }
+    }
+
+    double out = (query->limit >= 0 && query->limit < rows) ? query->limit : rows;
+    if (query->order_by_count > 0) {
+        char order[120];
+        format_order(query, order, sizeof(order));
+        int col = get_column_index(table, query->order_by[0].column);
+        const TableIndex* sorted = (!grouped && col != -1 && query->order_by_count == 1)
+                                   ? find_table_index(table, col, INDEX_SORTED) : NULL;
+        if (sorted != NULL && (query->where_conditions == NULL || rows >= table_rows / INDEX_ORDER_DIVISOR)) {
+            plan_add_step(plan, PLAN_SORT, out, (query->where_conditions != NULL) ? table_rows : out,
+                          "%s using index %s", order, sorted->name);
+        } else if (query->limit >= 0) {
+            plan_add_step(plan, PLAN_SORT, out, rows * log2(out + 2.0) * query->order_by_count, "%s, top %d",
+                          order, query->limit);
+        } else {
+            plan_add_step(plan, PLAN_SORT, out, rows * log2(rows + 2.0) * query->order_by_count, "%s", order);
+        }
+    } else if (query->limit >= 0) {
+        plan_add_step(plan, PLAN_LIMIT, out, 0.0, "%d", query->limit);
+    }
+
+    int col_count = (grouped || query->column_count > 0) ? query->column_count : table->col_count;
+    plan_add_step(plan, PLAN_MATERIALIZE, out, out * (col_count > 0 ? col_count : 1), "");
+    free_filter(filter);
+}
+
+// 连接的估计行数: 有统计信息时为 |L|*|R| / max(两侧不同值个数)，否则按外键连接取较大一侧的行数
+// ON中的列无法解析时返回-1
+static double plan_join(const Table* left, const char* left_name, const Table* right, const char* right_name,
+                        const Query* query, QueryPlan* plan) {
+    int left_col, right_col, build_is_left;
+    if (plan_hash_join(left, left_name, right, right_name, query->join_left, query->join_right,
+                       &left_col, &right_col, &build_is_left) != 0) {
+        return -1.0;
+    }
+
+    double left_keys = stats_key_rows(left, left_col);
+    double right_keys = stats_key_rows(right, right_col);
+    const ColumnStats* left_stats = table_column_stats(left, left_col);
+    const ColumnStats* right_stats = table_column_stats(right, right_col);
+    double distinct = 0.0;
+    if (left_stats != NULL) {
+        distinct = left_stats->distinct;
+    }
+    if (right_stats != NULL && right_stats->distinct > distinct) {
+        distinct = right_stats->distinct;
+    }
+    double rows = (distinct >= 1.0) ? left_keys * right_keys / distinct
+                                    : (left_keys > right_keys ? left_keys : right_keys);
+
+    double build = build_is_left ? left_keys : right_keys;
+    double probe = build_is_left ? right->row_count : left->row_count;
+    plan_add_step(plan, PLAN_JOIN, rows, 2.0 * build + probe + rows, "%s.%s = %s.%s, hash table on %s",
+                  left_name, left->columns[left_col].name, right_name, right->columns[right_col].name,
+                  build_is_left ? left_name : right_name);
+    return rows;
+}
+
+void plan_query(const Table* table, const Query* query, QueryPlan* plan) {
+    plan->count = 0;
+    if (table != NULL && query != NULL) {
+        plan_select(table, query, table->row_count, plan);
+    }
+}
+
+// 执行查询: 各算子只在视图上操作行号和列映射，最后才物化一次结果表
+// plan不为NULL时 (EXPLAIN ANALYZE) 记录每个算子的耗时、输入/输出行数和分配的内存
+static QueryResult* run_query(Table* table, Query* query, QueryPlan* plan) {
     QueryResult* result = create_query_result();
     if (result == NULL) {
         return NULL;
     }
 
-    Table* temp_table = table;
+    // COUNT(*) answered by bitmap indexes: the grouped table is already the result
+    PlanStep* step = plan_begin(plan, PLAN_INDEX_COUNT, table->row_count);
+    Table* grouped = count_with_bitmaps(table, query);
+    plan_end(step, (grouped != NULL) ? grouped->row_count : 0, table_memory(grouped));
+
+    step = plan_begin(plan, PLAN_SCAN, table->row_count);
+    TableView* view = create_table_view((grouped != NULL) ? grouped : table);
+    plan_end(step, (view != NULL) ? view->row_count : 0, sizeof(TableView));
+    if (view == NULL) {
+        strcpy(result->message, "Out of memory");
+        result->success = 0;
+        free_table(grouped);
+        return result;
+    }
 
     // Execute WHERE condition filtering
-    if (query->where_conditions != NULL) {
-        temp_table = filter_rows(temp_table, query->where_conditions);
-        if (temp_table == NULL) {
+    if (grouped == NULL && query->where_conditions != NULL) {
+        step = plan_begin(plan, PLAN_FILTER, view->row_count);
+        if (filter_view(view, query->where_conditions, step) != 0) {
             strcpy(result->message, "Filter condition execution failed");
             result->success = 0;
+            free_table_view(view);
             return result;
         }
+        plan_end(step, view->row_count, view->row_count * sizeof(int));
     }
 
-    // Execute column selection
-    // column_count=0 means SELECT *
-    if (query->column_count > 0 || query->column_count == 0) { 
-        temp_table = select_columns(temp_table, query);
-        if (temp_table == NULL) {
+    // Execute grouping/aggregation (later operators work on the grouped table),
+    // otherwise column selection: column_count=0 means SELECT *
+    if (grouped == NULL && query->type == QUERY_AGGREGATE) {
+        step = plan_begin(plan, PLAN_AGGREGATE, view->row_count);
+        grouped = aggregate_view(view, query);
+        plan_end(step, (grouped != NULL) ? grouped->row_count : 0, table_memory(grouped));
+        free_table_view(view);
+        view = (grouped != NULL) ? create_table_view(grouped) : NULL;
+        if (view == NULL) {
+            strcpy(result->message, "Aggregation execution failed");
+            result->success = 0;
+            free_table(grouped);
+            return result;
+        }
+    } else if (grouped == NULL) {
+        step = plan_begin(plan, PLAN_PROJECT, view->row_count);
+        if (view_project(view, query) != 0) {
             strcpy(result->message, "Column selection execution failed");
             result->success = 0;
+            free_table_view(view);
             return result;
         }
+        plan_end(step, view->row_count, 0);
     }
 
-    // Execute sorting
-    if (strlen(query->order_by) > 0) {
-        temp_table = sort_table(temp_table, query->order_by, query->sort_dir);
-        if (temp_table == NULL) {
+    // Execute sorting (with LIMIT only the top rows are kept)
+    if (query->order_by_count > 0) {
+        step = plan_begin(plan, PLAN_SORT, view->row_count);
+        int status = (query->limit >= 0) ? view_top_n(view, query->order_by, query->order_by_count, query->limit)
+                                         : view_sort_keys(view, query->order_by, query->order_by_count);
+        if (status != 0) {
             strcpy(result->message, "Sort execution failed");
             result->success = 0;
+            free_table_view(view);
+            free_table(grouped);
             return result;
         }
+        plan_end(step, view->row_count, (view->rows != NULL) ? view->row_count * sizeof(int) : 0);
+    }
+
+    // LIMIT without ORDER BY keeps the first rows
+    if (query->limit >= 0) {
+        step = plan_begin(plan, PLAN_LIMIT, view->row_count);
+        if (view->row_count > query->limit) {
+            view->row_count = query->limit;
+        }
+        plan_end(step, view->row_count, 0);
+    }
+
+    step = plan_begin(plan, PLAN_MATERIALIZE, view->row_count);
+    result->result_table = materialize_view(view, "query_result");
+    free_table_view(view);
+    free_table(grouped);
+    if (result->result_table == NULL) {
+        strcpy(result->message, "Result materialization failed");
+        result->success = 0;
+        return result;
     }
+    plan_end(step, result->result_table->row_count, table_memory(result->result_table));
 
-    result->result_table = temp_table;
-    result->affected_rows = temp_table->row_count;
+    result->affected_rows = result->result_table->row_count;
     result->success = 1;
     sprintf(result->message, "Query successful, returned %d rows", result->affected_rows);
 
     return result;
 }
 
+// EXPLAIN: 按执行器的判断生成计划；EXPLAIN ANALYZE 还执行查询，记录每个算子的实测
+// 结果表是计划本身，查询的结果行被丢弃
+static QueryResult* explain_query(Table* table, const Table* join_table, Query* query) {
+    QueryPlan plan;
+    plan.count = 0;
+    int analyze = (query->explain == EXPLAIN_ANALYZE);
+    double rows = table->row_count;
+    Table* input = table;
+    Table* joined = NULL;
+
+    if (join_table != NULL) {
+        const char* left_name = (query->table_alias[0] != '\0') ? query->table_alias : table->name;
+        const char* right_name = (query->join_alias[0] != '\0') ? query->join_alias : join_table->name;
+        rows = plan_join(table, left_name, join_table, right_name, query, &plan);
+        if (rows >= 0.0 && analyze) {
+            PlanStep* step = plan_begin(&plan, PLAN_JOIN, table->row_count + join_table->row_count);
+            joined = hash_join(table, left_name, join_table, right_name, query->join_left, query->join_right);
+            plan_end(step, (joined != NULL) ? joined->row_count : 0, table_memory(joined));
+        } else if (rows >= 0.0) {
+            joined = join_schema(table, left_name, join_table, right_name);
+        }
+        if (joined == NULL) {
+            QueryResult* result = create_query_result();
+            if (result != NULL) {
+                strcpy(result->message, "Join execution failed");
+                result->success = 0;
+            }
+            return result;
+        }
+        input = joined;
+    }
 
+    plan_select(input, query, rows, &plan);
 
-// 执行条件并返回过滤后的表
-int evaluate_condition(const Table* table, int row, const Condition* condition) {
-    if (table == NULL || condition == NULL || row < 0 || row >= table->row_count) {
-        return 0;
+    QueryResult* result = analyze ? run_query(input, query, &plan) : create_query_result();
+    free_table(joined);
+    if (result == NULL || (analyze && !result->success)) {
+        return result;
     }
 
-    int col_index = get_column_index(table, condition->column);
-    if (col_index == -1) {
-        return 0;
+    int returned = result->affected_rows;
+    free_table(result->result_table);
+    result->result_table = plan_table(&plan, analyze);
+    if (result->result_table == NULL) {
+        strcpy(result->message, "Out of memory");
+        result->success = 0;
+        return result;
     }
 
-    const char* cell_value = table->data[row][col_index];
-    if (cell_value == NULL) {
-        return 0;
+    double total_ms = 0.0;
+    double total_cost = 0.0;
+    for (int i = 0; i < plan.count; i++) {
+        total_ms += plan.steps[i].time_ms;
+        total_cost += plan.steps[i].est_cost;
     }
-
-    switch (condition->op) {
-        case OP_EQUAL:
-            return strcmp(cell_value, condition->value) == 0;
-        case OP_NOT_EQUAL:
-            return strcmp(cell_value, condition->value) != 0;
-        case OP_GREATER:
-            // 数值比较
-            if (table->columns[col_index].type == TYPE_INT || table->columns[col_index].type == TYPE_FLOAT) {
-                double cell_num = atof(cell_value);
-                double cond_num = atof(condition->value);
-                return cell_num > cond_num;
-            } else {
-                // 字符串比较
-                return strcmp(cell_value, condition->value) > 0;
-            }
-        case OP_LESS:
-            if (table->columns[col_index].type == TYPE_INT || table->columns[col_index].type == TYPE_FLOAT) {
-                double cell_num = atof(cell_value);
-                double cond_num = atof(condition->value);
-                return cell_num < cond_num;
-            } else {
-                return strcmp(cell_value, condition->value) < 0;
-            }
-        case OP_GREATER_EQUAL:
-            if (table->columns[col_index].type == TYPE_INT || table->columns[col_index].type == TYPE_FLOAT) {
-                double cell_num = atof(cell_value);
-                double cond_num = atof(condition->value);
-                return cell_num >= cond_num;
-            } else {
-                return strcmp(cell_value, condition->value) >= 0;
-            }
-        case OP_LESS_EQUAL:
-            if (table->columns[col_index].type == TYPE_INT || table->columns[col_index].type == TYPE_FLOAT) {
-                double cell_num = atof(cell_value);
-                double cond_num = atof(condition->value);
-                return cell_num <= cond_num;
-            } else {
-                return strcmp(cell_value, condition->value) <= 0;
-            }
-        case OP_LIKE:
-            // 简单的LIKE模式匹配
-            return strstr(cell_value, condition->value) != NULL;
-        default:
-            return 0;
+    if (analyze) {
+        snprintf(result->message, sizeof(result->message), "Query executed in %.3f ms, returned %d rows",
+                 total_ms, returned);
+    } else {
+        snprintf(result->message, sizeof(result->message), "Query plan: %d operators, estimated cost %.1f",
+                 plan.count, total_cost);
     }
+    result->affected_rows = result->result_table->row_count;
+    result->success = 1;
+    return result;
 }
 
-
-
-
-// NULL
-Table* select_columns(const Table* table, const Query* query) {
+// 执行查询并返回结果
+QueryResult* execute_query(Table* table, Query* query) {
     if (table == NULL || query == NULL) {
         return NULL;
     }
 
-    // 如果column_count为0，表示SELECT *，选择所有列
-    int selected_col_count = (query->column_count == 0) ? table->col_count : query->column_count;
-    const char** selected_cols = malloc(selected_col_count * sizeof(char*));
-    
-    if (selected_cols == NULL) {
+    // CREATE INDEX: 在表上建立索引，之后的过滤和排序自动使用
+    // ANALYZE: 收集的统计信息供过滤顺序、连接建表侧和索引选择使用
+    if (query->type == QUERY_CREATE_INDEX || query->type == QUERY_ANALYZE) {
+        QueryResult* result = create_query_result();
+        if (result == NULL) {
+            return NULL;
+        }
+        if (query->type == QUERY_CREATE_INDEX) {
+            execute_create_index(table, query, result);
+        } else {
+            execute_analyze(table, result);
+        }
+        return result;
+    }
+
+    if (query->explain != EXPLAIN_NONE) {
+        return explain_query(table, NULL, query);
+    }
+    return run_query(table, query, NULL);
+}
+
+
+
+// 从目录中解析FROM/JOIN引用的表后执行查询，连接结果作为后续算子的输入表
+QueryResult* execute_catalog_query(const Catalog* catalog, Query* query) {
+    if (catalog == NULL || query == NULL) {
         return NULL;
     }
 
-    if (query->column_count == 0) {
-        // SELECT * 的情况
-        for (int i = 0; i < table->col_count; i++) {
-            selected_cols[i] = table->columns[i].name;
+    Table* table = catalog_find(catalog, query->table_name);
+    Table* join_table = (query->join_table[0] != '\0') ? catalog_find(catalog, query->join_table) : NULL;
+    if (table == NULL || (query->join_table[0] != '\0' && join_table == NULL)) {
+        QueryResult* result = create_query_result();
+        if (result != NULL) {
+            snprintf(result->message, sizeof(result->message), "Table not found: %s",
+                     (table == NULL) ? query->table_name : query->join_table);
+            result->success = 0;
         }
-    } else {
-        // 选择特定列
-        for (int i = 0; i < query->column_count; i++) {
-            selected_cols[i] = query->columns[i];
+        return result;
+    }
+
+    if (join_table == NULL) {
+        return execute_query(table, query);
+    }
+    if (query->explain != EXPLAIN_NONE) {
+        return explain_query(table, join_table, query);
+    }
+
+    const char* left_name = (query->table_alias[0] != '\0') ? query->table_alias : table->name;
+    const char* right_name = (query->join_alias[0] != '\0') ? query->join_alias : join_table->name;
+    Table* joined = hash_join(table, left_name, join_table, right_name, query->join_left, query->join_right);
+    if (joined == NULL) {
+        QueryResult* result = create_query_result();
+        if (result != NULL) {
+            strcpy(result->message, "Join execution failed");
+            result->success = 0;
         }
+        return result;
     }
 
+    QueryResult* result = execute_query(joined, query);
+    free_table(joined);
+    return result;
+}
 
 
 
+// 对单行求值一个条件 (逐行调用时请改用compile_filter，只编译一次)
+int evaluate_condition(const Table* table, int row, const Condition* condition) {
+    if (table == NULL || condition == NULL || row < 0 || row >= table->row_count) {
+        return 0;
+    }
 
-    // 创建新表
-    Table* result_table = create_table("query_result", selected_col_count, selected_cols);
-    free(selected_cols);
+    switch (condition->kind) {
+        case COND_AND:
+            return evaluate_condition(table, row, condition->left) &&
+                   evaluate_condition(table, row, condition->right);
+        case COND_OR:
+            return evaluate_condition(table, row, condition->left) ||
+                   evaluate_condition(table, row, condition->right);
+        case COND_NOT:
+            return !evaluate_condition(table, row, condition->left);
+        default:
+            break;
+    }
 
-    if (result_table == NULL) {
-        return NULL;
+    CompiledPredicate predicate;
+    if (compile_predicate(table, condition, &predicate) != 0) {
+        free_predicate(&predicate);
+        return 0;
     }
+    int match = predicate_matches(&predicate, table, row);
+    free_predicate(&predicate);
+    return match;
+}
 
-    // 复制数据
-    for (int row = 0; row < table->row_count; row++) {
-        const char** row_data = malloc(selected_col_count * sizeof(char*));
-        if (row_data == NULL) {
-            free_table(result_table);
-            return NULL;
-        }
 
-        for (int col = 0; col < selected_col_count; col++) {
-            int src_col_index;
-            if (query->column_count == 0) 
-            {
-                // SELECT * 的情况
-                src_col_index = col; 
-            } 
-            else 
-            {
-                src_col_index = get_column_index(table, query->columns[col]);
-            }
-            
-            if (src_col_index != -1 && table->data[row][src_col_index] != NULL) 
-            {
-                row_data[col] = table->data[row][src_col_index];
-            } 
-            else 
-            {
-                row_data[col] = "";
-            }
-        }
 
-        if (add_row(result_table, row_data) != 0) 
-        {
-            free(row_data);
-            free_table(result_table);
-            return NULL;
+
+// 投影: 只修改视图的列映射
+int view_project(TableView* view, const Query* query) {
+    if (view == NULL || query == NULL) {
+        return -1;
+    }
+
+    // 如果column_count为0，表示SELECT *，保持当前列映射
+    if (query->column_count == 0) {
+        return 0;
+    }
+
+    int base_cols[MAX_COLUMNS];
+    for (int i = 0; i < query->column_count; i++) {
+        base_cols[i] = get_column_index(view->base, query->columns[i]);
+    }
+
+    for (int i = 0; i < query->column_count; i++) {
+        view->col_map[i] = base_cols[i];
+        if (base_cols[i] != -1) {
+            strcpy(view->col_names[i], view->base->columns[base_cols[i]].name);
+        } else {
+            strcpy(view->col_names[i], query->columns[i]);
         }
-        free(row_data);
     }
+    view->col_count = query->column_count;
 
-    return result_table;
+    return 0;
 }
 
 
 
 
-// 过滤表的行
-Table* filter_rows(const Table* table, const Condition* conditions) 
+// 过滤: 只保留满足条件的行号，step不为NULL时记下实际走的路径 (EXPLAIN ANALYZE)
+static int filter_view(TableView* view, const Condition* conditions, PlanStep* step) 
 {
-    if (table == NULL || conditions == NULL) 
+    if (view == NULL || conditions == NULL) 
     {
-        return NULL;
+        return -1;
     }
 
-    // 创建新表
-    Table* result_table = create_table("filtered_result", table->col_count, NULL);
-    if (result_table == NULL) 
+    // 条件只编译一次，逐行循环中不再查找列名或解析常量
+    FilterNode* filter = compile_filter(view->base, conditions);
+    if (filter == NULL) 
     {
-        return NULL;
+        return -1;
     }
 
-    // 复制列信息
-    for (int i = 0; i < table->col_count; i++) 
+    // 视图还是整张表时先查索引: 位图索引能完整回答时直接得到结果，
+    // 否则只在索引给出的候选行上检查完整的条件
+    int* candidates = NULL;
+    int exact = 0;
+    int candidate_count = (view->rows == NULL) ? index_filter_rows(view->base, filter, &candidates, &exact) : -1;
+    if (step != NULL) 
     {
-        strcpy(result_table->columns[i].name, table->columns[i].name);
-        result_table->columns[i].type = table->columns[i].type;
+        if (candidate_count >= 0) 
+        {
+            snprintf(step->actual, sizeof(step->actual), exact ? "bitmap index, %d rows" : "index, %d candidates",
+                     candidate_count);
+        } 
+        else 
+        {
+            strcpy(step->actual, "scan");
+        }
     }
-    result_table->col_count = table->col_count;
 
-    // 应用过滤条件
-    for (int row = 0; row < table->row_count; row++) 
+    int* selected;
+    int selected_count;
+    if (candidate_count >= 0 && exact) 
+    {
+        selected = candidates;
+        selected_count = candidate_count;
+    } 
+    else 
     {
-        int match = 1;
-        const Condition* current_condition = conditions;
-        
-        // 检查所有AND条件
-        while (current_condition != NULL && match) 
+        // 按批求值，输出的行号不会多于输入
+        int input_count = (candidate_count >= 0) ? candidate_count : view->row_count;
+        selected = malloc((input_count > 0 ? input_count : 1) * sizeof(int));
+        if (selected == NULL) 
         {
-            if (!evaluate_condition(table, row, current_condition)) 
-            {
-                match = 0;
-            }
-            current_condition = current_condition->next;
+            free(candidates);
+            free_filter(filter);
+            return -1;
         }
 
-        if (match) 
+        selected_count = filter_row_ids(view->base, filter, (candidate_count >= 0) ? candidates : view->rows,
+                                        input_count, selected);
+        free(candidates);
+        if (selected_count < 0) 
         {
-            // 复制匹配的行
-            const char** row_data = malloc(table->col_count * sizeof(char*));
-            if (row_data == NULL) 
-            {
-                free_table(result_table);
-                return NULL;
-            }
+            free(selected);
+            free_filter(filter);
+            return -1;
+        }
+    }
 
-            for (int col = 0; col < table->col_count; col++) 
-            {
-                if (table->data[row][col] != NULL) 
-                {
-                    row_data[col] = table->data[row][col];
-                } else {
-                    row_data[col] = "";
-                }
-            }
+    // 选择率低时收缩行号数组
+    if (selected_count < view->row_count / 2) 
+    {
+        int* shrunk = realloc(selected, (selected_count > 0 ? selected_count : 1) * sizeof(int));
+        if (shrunk != NULL) 
+        {
+            selected = shrunk;
+        }
+    }
 
-            if (add_row(result_table, row_data) != 0)
-             {
-                free(row_data);
-                free_table(result_table);
-                return NULL;
-            }
-            free(row_data);
+    free_filter(filter);
+    free(view->rows);
+    view->rows = selected;
+    view->row_count = selected_count;
+    return 0;
+}
+
+int view_filter(TableView* view, const Condition* conditions) 
+{
+    return filter_view(view, conditions, NULL);
+}
+
+
+
+
+// 视图行号升序且占表的比例不太小时，沿有序索引取行比排序这些行更快
+// (选中的行很少时，只排序这些行更省事)
+static int use_index_order(const TableView* view) {
+    if (view->rows == NULL) {
+        return 1;
+    }
+    if (view->row_count < view->base->row_count / INDEX_ORDER_DIVISOR) {
+        return 0;
+    }
+    for (int i = 1; i < view->row_count; i++) {
+        if (view->rows[i] <= view->rows[i - 1]) {
+            return 0;
         }
     }
+    return 1;
+}
+
+// 按有序索引的顺序重排视图中的行，最多保留limit行
+static int view_index_order(TableView* view, const TableIndex* index, SortDirection direction, int limit) {
+    int capacity = (limit < view->row_count) ? limit : view->row_count;
+    int* ordered = malloc((capacity > 0 ? capacity : 1) * sizeof(int));
+    if (ordered == NULL) {
+        return -1;
+    }
 
-    return result_table;
+    int count = sorted_index_order(view->base, index, direction, view->rows, view->row_count, capacity, ordered);
+    if (count < 0) {
+        free(ordered);
+        return -1;
+    }
+    free(view->rows);
+    view->rows = ordered;
+    view->row_count = count;
+    return 0;
 }
 
+// ORDER BY的列名解析成基表的列下标，有列找不到时返回-1
+static int resolve_order_keys(const Table* table, const OrderKey* keys, int key_count, SortColumn* columns) {
+    if (keys == NULL || key_count < 1 || key_count > MAX_COLUMNS) {
+        return -1;
+    }
+    for (int k = 0; k < key_count; k++) {
+        columns[k].col_index = get_column_index(table, keys[k].column);
+        columns[k].direction = keys[k].direction;
+        if (columns[k].col_index == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
 
+// 排序: 重排视图中的行号，排序列按基表列名查找，前面的列优先
+int view_sort_keys(TableView* view, const OrderKey* keys, int key_count) {
+    if (view == NULL) {
+        return -1;
+    }
 
+    const Table* table = view->base;
+    SortColumn columns[MAX_COLUMNS];
+    if (resolve_order_keys(table, keys, key_count, columns) != 0) {
+        return -1;
+    }
 
-// 对表进行排序
-Table* sort_table(const Table* table, const char* column, SortDirection direction) {
-    if (table == NULL || column == NULL) {
-        return NULL;
+    // 只按一列排序且该列上有有序索引时按索引顺序取行，不再排序
+    const TableIndex* index = (key_count == 1) ? find_table_index(table, columns[0].col_index, INDEX_SORTED) : NULL;
+    if (index != NULL && use_index_order(view)) {
+        return view_index_order(view, index, columns[0].direction, view->row_count);
     }
 
-    int col_index = get_column_index(table, column);
-    if (col_index == -1) {
-        return NULL;
+    if (view_select_all_rows(view) != 0) {
+        return -1;
     }
 
-    // 创建新表（复制原表）
-    Table* result_table = create_table("sorted_result", table->col_count, NULL);
-    if (result_table == NULL) {
-        return NULL;
+    // 预计算排序键后做O(n log n)稳定排序 (数值列为基数排序)
+    return sort_row_ids_by(table, columns, key_count, view->rows, view->row_count);
+}
+
+int view_sort(TableView* view, const char* column, SortDirection direction) {
+    if (column == NULL) {
+        return -1;
     }
+    OrderKey key;
+    strncpy(key.column, column, MAX_COLUMN_NAME_LEN - 1);
+    key.column[MAX_COLUMN_NAME_LEN - 1] = '\0';
+    key.direction = direction;
+    return view_sort_keys(view, &key, 1);
+}
+
+
 
-    // 复制列信息
-    for (int i = 0; i < table->col_count; i++) {
-        strcpy(result_table->columns[i].name, table->columns[i].name);
-        result_table->columns[i].type = table->columns[i].type;
+
+// ORDER BY ... LIMIT: 用有界堆取前limit行，不对整个视图排序
+int view_top_n(TableView* view, const OrderKey* keys, int key_count, int limit) {
+    if (view == NULL || limit < 0) {
+        return -1;
     }
-    result_table->col_count = table->col_count;
 
-    // 复制所有数据
-    for (int row = 0; row < table->row_count; row++) {
-        const char** row_data = malloc(table->col_count * sizeof(char*));
-        if (row_data == NULL) {
-            free_table(result_table);
-            return NULL;
-        }
+    SortColumn columns[MAX_COLUMNS];
+    if (resolve_order_keys(view->base, keys, key_count, columns) != 0) {
+        return -1;
+    }
 
-        for (int col = 0; col < table->col_count; col++) {
-            if (table->data[row][col] != NULL) {
-                row_data[col] = table->data[row][col];
-            } else {
-                row_data[col] = "";
-            }
-        }
+    // 有序索引: 沿索引顺序取到limit行即可停止
+    const TableIndex* index = (key_count == 1) ? find_table_index(view->base, columns[0].col_index, INDEX_SORTED)
+                                               : NULL;
+    if (index != NULL && use_index_order(view)) {
+        return view_index_order(view, index, columns[0].direction, limit);
+    }
 
-        if (add_row(result_table, row_data) != 0) {
-            free(row_data);
-            free_table(result_table);
-            return NULL;
-        }
-        free(row_data);
-    }
-
-
-    // 简单的冒泡排序
-    for (int i = 0; i < result_table->row_count - 1; i++) {
-        for (int j = 0; j < result_table->row_count - i - 1; j++) {
-            const char* value1 = result_table->data[j][col_index];
-            const char* value2 = result_table->data[j + 1][col_index];
-            
-            int should_swap = 0;
-            
-            if (table->columns[col_index].type == TYPE_INT || table->columns[col_index].type == TYPE_FLOAT) {
-                double num1 = atof(value1);
-                double num2 = atof(value2);
-                if (direction == SORT_ASC) {
-                    should_swap = num1 > num2;
-                } else {
-                    should_swap = num1 < num2;
-                }
-            } 
-            else 
-            {
-                // 字符串比较
-                if (direction == SORT_ASC) {
-                    should_swap = strcmp(value1, value2) > 0;
-                } 
-                else 
-                {
-                    should_swap = strcmp(value1, value2) < 0;
-                }
-            }
+    int capacity = (limit < view->row_count) ? limit : view->row_count;
+    int* top_rows = malloc((capacity > 0 ? capacity : 1) * sizeof(int));
+    if (top_rows == NULL) {
+        return -1;
+    }
 
-            if (should_swap) {
-                // 交换行数据
-                char** temp = result_table->data[j];
-                result_table->data[j] = result_table->data[j + 1];
-                result_table->data[j + 1] = temp;
-            }
-        }
+    int top_count = 0;
+    if (top_n_row_ids(view->base, columns, key_count, view->rows, view->row_count,
+                      limit, top_rows, &top_count) != 0) {
+        free(top_rows);
+        return -1;
+    }
+
+    free(view->rows);
+    view->rows = top_rows;
+    view->row_count = top_count;
+    return 0;
+}
+
+
+
+
+// 以下函数保留原有的"返回新表"接口，内部基于视图实现
+Table* select_columns(const Table* table, const Query* query) {
+    TableView* view = create_table_view(table);
+    if (view == NULL || view_project(view, query) != 0) {
+        free_table_view(view);
+        return NULL;
+    }
+
+    Table* result_table = materialize_view(view, "query_result");
+    free_table_view(view);
+    return result_table;
+}
+
+Table* filter_rows(const Table* table, const Condition* conditions) {
+    TableView* view = create_table_view(table);
+    if (view == NULL || view_filter(view, conditions) != 0) {
+        free_table_view(view);
+        return NULL;
+    }
+
+    Table* result_table = materialize_view(view, "filtered_result");
+    free_table_view(view);
+    return result_table;
+}
+
+Table* sort_table(const Table* table, const char* column, SortDirection direction) {
+    TableView* view = create_table_view(table);
+    if (view == NULL || view_sort(view, column, direction) != 0) {
+        free_table_view(view);
+        return NULL;
     }
 
+    Table* result_table = materialize_view(view, "sorted_result");
+    free_table_view(view);
     return result_table;
 }
@@ -2,12 +2,25 @@
 #define EXECUTOR_H
 
 #include "table.h"
+#include "view.h"
+#include "catalog.h"
+#include "explain.h"
 
 // 查询执行函数
 QueryResult* execute_query(Table* table, Query* query);
+QueryResult* execute_catalog_query(const Catalog* catalog, Query* query);
+// 查询在table上的执行计划 (与EXPLAIN相同，只估计不执行)，不包括连接
+void plan_query(const Table* table, const Query* query, QueryPlan* plan);
 int evaluate_condition(const Table* table, int row, const Condition* condition);
 Table* select_columns(const Table* table, const Query* query);
 Table* filter_rows(const Table* table, const Condition* conditions);
 Table* sort_table(const Table* table, const char* column, SortDirection direction);
 
+// 基于视图的算子 (不复制数据)
+int view_filter(TableView* view, const Condition* conditions);
+int view_project(TableView* view, const Query* query);
+int view_sort(TableView* view, const char* column, SortDirection direction);
+int view_sort_keys(TableView* view, const OrderKey* keys, int key_count);
+int view_top_n(TableView* view, const OrderKey* keys, int key_count, int limit);
+
 #endif // EXECUTOR_H
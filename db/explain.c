@@ -0,0 +1,246 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "explain.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// 单调时钟的毫秒数
+static double now_ms(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+PlanStep* plan_add_step(QueryPlan* plan, PlanOp op, double est_rows, double est_cost, const char* format, ...) {
+    if (plan->count == MAX_PLAN_STEPS) {
+        return NULL;
+    }
+    PlanStep* step = &plan->steps[plan->count++];
+    memset(step, 0, sizeof(PlanStep));
+    step->op = op;
+    step->est_rows = est_rows;
+    step->est_cost = est_cost;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(step->detail, sizeof(step->detail), format, args);
+    va_end(args);
+    return step;
+}
+
+PlanStep* plan_begin(QueryPlan* plan, PlanOp op, int rows_in) {
+    if (plan == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < plan->count; i++) {
+        PlanStep* step = &plan->steps[i];
+        if (step->op == op) {
+            step->rows_in = rows_in;
+            step->start_ms = now_ms();
+            return step;
+        }
+    }
+    return NULL;
+}
+
+void plan_end(PlanStep* step, int rows_out, size_t bytes) {
+    if (step == NULL) {
+        return;
+    }
+    step->time_ms = now_ms() - step->start_ms;
+    step->rows_out = rows_out;
+    step->bytes = bytes;
+    step->executed = 1;
+}
+
+size_t table_memory(const Table* table) {
+    if (table == NULL) {
+        return 0;
+    }
+    size_t bytes = sizeof(Table) + table->capacity * sizeof(char**);
+    if (table->arena != NULL) {
+        bytes += table->arena->total_bytes;
+    }
+
+    const ColumnStore* store = table->store;
+    if (store != NULL) {
+        bytes += sizeof(ColumnStore);
+        for (int col = 0; col < table->col_count; col++) {
+            const ColumnVector* column = &store->columns[col];
+            const ZoneMap* zones = &store->zones[col];
+            bytes += zones->capacity * (2 * sizeof(double) + sizeof(int));
+            if (store->mapped) {
+                continue;
+            }
+            bytes += store->capacity * sizeof(unsigned char);
+            if (column->type == TYPE_STRING) {
+                bytes += store->capacity * sizeof(size_t) + column->heap_capacity;
+            } else {
+                bytes += store->capacity * sizeof(long long);
+            }
+        }
+    }
+    return bytes;
+}
+
+// 在out已有的文本后追加，超出size时截断
+static void append_text(char* out, size_t size, const char* format, ...) {
+    size_t len = strlen(out);
+    if (len + 1 >= size) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    vsnprintf(out + len, size - len, format, args);
+    va_end(args);
+}
+
+// 常量: 数字原样输出，其余加单引号
+static void append_value(char* out, size_t size, const char* value) {
+    char* end;
+    strtod(value, &end);
+    if (value[0] != '\0' && *end == '\0') {
+        append_text(out, size, "%s", value);
+    } else {
+        append_text(out, size, "'%s'", value);
+    }
+}
+
+static const char* operator_text(Operator op) {
+    switch (op) {
+        case OP_EQUAL:         return "=";
+        case OP_NOT_EQUAL:     return "!=";
+        case OP_GREATER:       return ">";
+        case OP_LESS:          return "<";
+        case OP_GREATER_EQUAL: return ">=";
+        case OP_LESS_EQUAL:    return "<=";
+        case OP_LIKE:          return "LIKE";
+        case OP_BETWEEN:       return "BETWEEN";
+        default:               return "IN";
+    }
+}
+
+static void append_condition(char* out, size_t size, const Condition* condition) {
+    switch (condition->kind) {
+        case COND_COMPARE:
+            append_text(out, size, "%s %s ", condition->column, operator_text(condition->op));
+            if (condition->op == OP_IN) {
+                append_text(out, size, "(");
+                for (int i = 0; i < condition->in_count; i++) {
+                    append_text(out, size, "%s", (i > 0) ? ", " : "");
+                    append_value(out, size, condition->in_values[i]);
+                }
+                append_text(out, size, ")");
+            } else {
+                append_value(out, size, condition->value);
+                if (condition->op == OP_BETWEEN) {
+                    append_text(out, size, " AND ");
+                    append_value(out, size, condition->value2);
+                }
+            }
+            break;
+        case COND_NOT:
+            append_text(out, size, "NOT ");
+            append_condition(out, size, condition->left);
+            break;
+        default:
+            append_text(out, size, "(");
+            append_condition(out, size, condition->left);
+            append_text(out, size, "%s", (condition->kind == COND_AND) ? " AND " : " OR ");
+            append_condition(out, size, condition->right);
+            append_text(out, size, ")");
+            break;
+    }
+}
+
+void format_condition(const Condition* conditions, char* out, size_t size) {
+    out[0] = '\0';
+    for (const Condition* c = conditions; c != NULL; c = c->next) {
+        append_text(out, size, "%s", (c != conditions) ? " AND " : "");
+        append_condition(out, size, c);
+    }
+}
+
+static const char* op_name(PlanOp op) {
+    switch (op) {
+        case PLAN_JOIN:        return "Hash Join";
+        case PLAN_SCAN:        return "Scan";
+        case PLAN_INDEX_COUNT: return "Bitmap Count";
+        case PLAN_FILTER:      return "Filter";
+        case PLAN_AGGREGATE:   return "Aggregate";
+        case PLAN_PROJECT:     return "Project";
+        case PLAN_SORT:        return "Sort";
+        case PLAN_LIMIT:       return "Limit";
+        default:               return "Materialize";
+    }
+}
+
+Table* plan_table(const QueryPlan* plan, int analyze) {
+    static const char* names[] = { "operator", "est_rows", "est_cost", "actual", "time_ms",
+                                   "rows_in", "rows_out", "bytes", "rows_per_sec" };
+    Table* table = create_table("query_plan", analyze ? 9 : 3, names);
+    if (table == NULL) {
+        return NULL;
+    }
+
+    // 代价按执行顺序累加: 每个算子的代价包含它下面的所有算子
+    double total_cost[MAX_PLAN_STEPS];
+    double cost = 0.0;
+    for (int i = 0; i < plan->count; i++) {
+        cost += plan->steps[i].est_cost;
+        total_cost[i] = cost;
+    }
+
+    // 根算子 (最后执行的) 在第一行，越往下越缩进
+    for (int i = plan->count - 1; i >= 0; i--) {
+        const PlanStep* step = &plan->steps[i];
+        int depth = plan->count - 1 - i;
+        char text[256], rows[32], costs[32], time_ms[32], rows_in[32], rows_out[32], bytes[32], rate[32];
+
+        snprintf(text, sizeof(text), "%*s%s%s%s%s", (depth > 0) ? depth * 3 - 3 : 0, "",
+                 (depth > 0) ? "-> " : "", op_name(step->op), (step->detail[0] != '\0') ? " " : "",
+                 step->detail);
+        snprintf(rows, sizeof(rows), "%.0f", step->est_rows);
+        snprintf(costs, sizeof(costs), "%.1f", total_cost[i]);
+
+        const char* row[] = { text, rows, costs, step->actual, time_ms, rows_in, rows_out, bytes, rate };
+        if (analyze && step->executed) {
+            snprintf(time_ms, sizeof(time_ms), "%.3f", step->time_ms);
+            snprintf(rows_in, sizeof(rows_in), "%d", step->rows_in);
+            snprintf(rows_out, sizeof(rows_out), "%d", step->rows_out);
+            snprintf(bytes, sizeof(bytes), "%llu", (unsigned long long)step->bytes);
+            if (step->time_ms > 0.0) {
+                snprintf(rate, sizeof(rate), "%.0f", step->rows_in / (step->time_ms / 1000.0));
+            } else {
+                strcpy(rate, "-");
+            }
+        } else if (analyze) {
+            // 计划中有但没有执行到的算子 (如前面的算子出错)
+            row[4] = "never executed";
+            for (int col = 5; col < 9; col++) {
+                row[col] = "";
+            }
+        }
+        if (add_row(table, row) != 0) {
+            free_table(table);
+            return NULL;
+        }
+    }
+    return table;
+}
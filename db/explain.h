@@ -0,0 +1,59 @@
+#ifndef EXPLAIN_H
+#define EXPLAIN_H
+
+#include <stddef.h>
+#include "table.h"
+
+#define MAX_PLAN_STEPS 12
+
+// 执行计划中的算子，执行器按这个顺序调用 (每种最多出现一次)
+typedef enum {
+    PLAN_JOIN,          // 哈希连接，结果作为后续算子的输入表
+    PLAN_SCAN,          // 在表上建立视图
+    PLAN_INDEX_COUNT,   // COUNT(*)由位图索引的基数回答，代替过滤和聚合
+    PLAN_FILTER,
+    PLAN_AGGREGATE,
+    PLAN_PROJECT,
+    PLAN_SORT,          // 全排序、堆取前N行或沿有序索引取行
+    PLAN_LIMIT,
+    PLAN_MATERIALIZE    // 把视图复制成结果表
+} PlanOp;
+
+// 一个算子: 规划时填写估计值，EXPLAIN ANALYZE执行时填写实测值
+typedef struct {
+    PlanOp op;
+    char detail[160];       // 算子说明 (表、条件、索引、排序列等)
+    double est_rows;        // 估计的输出行数
+    double est_cost;        // 本算子的估计代价: 处理的行数乘以每行的相对代价
+    int executed;
+    char actual[64];        // 执行时实际走的路径，如索引给出的候选行数
+    double start_ms;
+    double time_ms;
+    int rows_in;
+    int rows_out;
+    size_t bytes;           // 算子输出分配的内存 (行号数组、中间表或结果表)
+} PlanStep;
+
+typedef struct {
+    PlanStep steps[MAX_PLAN_STEPS];   // 按执行顺序
+    int count;
+} QueryPlan;
+
+// 规划: 追加一个算子，detail按printf格式生成；计划已满时返回NULL
+PlanStep* plan_add_step(QueryPlan* plan, PlanOp op, double est_rows, double est_cost, const char* format, ...);
+
+// 执行: 找到计划中的算子并开始计时 (plan为NULL或计划中没有该算子时返回NULL)，
+// 算子完成后用plan_end记录输出行数和内存 (step为NULL时什么也不做)
+PlanStep* plan_begin(QueryPlan* plan, PlanOp op, int rows_in);
+void plan_end(PlanStep* step, int rows_out, size_t bytes);
+
+// 表占用的内存: 行数组、arena和列式存储 (快照映射的列不计)
+size_t table_memory(const Table* table);
+
+// 把WHERE条件写成文本，用于算子说明
+void format_condition(const Condition* conditions, char* out, size_t size);
+
+// 计划输出成结果表: 根算子在前，子算子缩进；analyze为1时带上实测的各列
+Table* plan_table(const QueryPlan* plan, int analyze);
+
+#endif // EXPLAIN_H
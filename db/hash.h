@@ -0,0 +1,36 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 64位整数混合 (splitmix64的最后一步)，相邻整数也能均匀分布到各个桶
+static inline uint64_t hash_u64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// FNV-1a字符串哈希，再混合一次让低位也足够随机
+static inline uint64_t hash_bytes(const char* data, size_t len) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 0x100000001b3ULL;
+    }
+    return hash_u64(h);
+}
+
+static inline uint64_t hash_string(const char* str) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (; *str != '\0'; str++) {
+        h ^= (unsigned char)*str;
+        h *= 0x100000001b3ULL;
+    }
+    return hash_u64(h);
+}
+
+#endif // HASH_H
@@ -0,0 +1,1317 @@
+#include "index.h"
+#include "column_store.h"
+#include "hash.h"
+#include "sort.h"
+#include "roaring.h"
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#ifdef _WIN32
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#endif
+
+#define MIN_INDEX_SLOTS 16
+#define INT_KEY_LIMIT 9223372036854775808.0   // 2^63
+#define SORTED_SCAN_DIVISOR 4      // 区间超过表的1/4时，向量化的逐行扫描比按索引取行更快
+#define SORTED_QSORT_DIVISOR 64    // 区间不超过表的1/64时直接排序行号，否则用标记数组按行号收集
+#define STATS_SCAN_SELECTIVITY 0.25   // 统计信息估计的满足比例超过这个值时不查索引，同样是逐行扫描更快
+#define TRIGRAM_CODE(a, b, c) (((uint32_t)(unsigned char)(a) << 16) | ((uint32_t)(unsigned char)(b) << 8) | \
+                               (uint32_t)(unsigned char)(c))
+
+// 被索引列的读取方式，与compile_predicate选择比较函数的规则一致
+typedef struct {
+    const Table* table;
+    int col;
+    DataType key_type;
+    const ColumnVector* column;   // 列式存储中的列，没有时为NULL
+} IndexColumn;
+
+static void init_index_column(IndexColumn* ic, const Table* table, int col) {
+    ic->table = table;
+    ic->col = col;
+    ic->column = (table->store != NULL) ? &table->store->columns[col] : NULL;
+    ic->key_type = TYPE_STRING;
+
+    DataType type = table->columns[col].type;
+    if ((type == TYPE_INT || type == TYPE_FLOAT) && column_is_numeric(ic->column)) {
+        ic->key_type = ic->column->type;
+    }
+}
+
+static const char* text_cell(const IndexColumn* ic, int row) {
+    if (ic->column != NULL && ic->column->type == TYPE_STRING) {
+        return column_get_string(ic->column, row);
+    }
+    return ic->table->data[row][ic->col];
+}
+
+// double按位哈希前把-0.0统一成0.0
+static uint64_t hash_double(double value) {
+    uint64_t bits;
+    if (value == 0.0) {
+        value = 0.0;
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    return hash_u64(bits);
+}
+
+// 空值 (以及永远不相等的NaN) 不进索引
+static int skip_row(const IndexColumn* ic, int row) {
+    if (ic->key_type == TYPE_STRING) {
+        return text_cell(ic, row) == NULL;
+    }
+    if (ic->column->nulls[row]) {
+        return 1;
+    }
+    return ic->key_type == TYPE_FLOAT && isnan(ic->column->floats[row]);
+}
+
+static uint64_t hash_row(const IndexColumn* ic, int row) {
+    if (ic->key_type == TYPE_INT) {
+        return hash_u64((uint64_t)ic->column->ints[row]);
+    }
+    if (ic->key_type == TYPE_FLOAT) {
+        return hash_double(ic->column->floats[row]);
+    }
+    return hash_string(text_cell(ic, row));
+}
+
+static int rows_equal(const IndexColumn* ic, int a, int b) {
+    if (ic->key_type == TYPE_INT) {
+        return ic->column->ints[a] == ic->column->ints[b];
+    }
+    if (ic->key_type == TYPE_FLOAT) {
+        return ic->column->floats[a] == ic->column->floats[b];
+    }
+    return strcmp(text_cell(ic, a), text_cell(ic, b)) == 0;
+}
+
+static void free_hash_index(HashIndex* hash) {
+    free(hash->slots);
+    free(hash->key_hashes);
+    free(hash->key_rows);
+    free(hash->offsets);
+    free(hash->row_ids);
+    memset(hash, 0, sizeof(HashIndex));
+}
+
+// 槽位翻倍后按保存的哈希值重新放置各个键
+static int grow_slots(HashIndex* hash) {
+    int slot_count = hash->slot_count * 2;
+    int* slots = malloc(slot_count * sizeof(int));
+    if (slots == NULL) {
+        return -1;
+    }
+    memset(slots, -1, slot_count * sizeof(int));
+
+    int mask = slot_count - 1;
+    for (int key = 0; key < hash->key_count; key++) {
+        int slot = (int)(hash->key_hashes[key] & mask);
+        while (slots[slot] != -1) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = key;
+    }
+    free(hash->slots);
+    hash->slots = slots;
+    hash->slot_count = slot_count;
+    return 0;
+}
+
+// 返回row的值对应的键号，第一次出现时新建键；内存不足返回-1
+static int find_or_add_key(HashIndex* hash, const IndexColumn* ic, int row, int* key_capacity) {
+    if ((hash->key_count + 1) * 2 > hash->slot_count && grow_slots(hash) != 0) {
+        return -1;
+    }
+
+    uint64_t h = hash_row(ic, row);
+    int mask = hash->slot_count - 1;
+    int slot = (int)(h & mask);
+    while (hash->slots[slot] != -1) {
+        int key = hash->slots[slot];
+        if (hash->key_hashes[key] == h && rows_equal(ic, hash->key_rows[key], row)) {
+            return key;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (hash->key_count == *key_capacity) {
+        int capacity = *key_capacity * 2;
+        uint64_t* key_hashes = realloc(hash->key_hashes, capacity * sizeof(uint64_t));
+        if (key_hashes == NULL) {
+            return -1;
+        }
+        hash->key_hashes = key_hashes;
+        int* key_rows = realloc(hash->key_rows, capacity * sizeof(int));
+        if (key_rows == NULL) {
+            return -1;
+        }
+        hash->key_rows = key_rows;
+        *key_capacity = capacity;
+    }
+
+    int key = hash->key_count++;
+    hash->key_hashes[key] = h;
+    hash->key_rows[key] = row;
+    hash->slots[slot] = key;
+    return key;
+}
+
+// 两遍建索引: 第一遍给每行分配键号并计数，第二遍按行号顺序填入各键的行号段
+static int build_hash_index(HashIndex* hash, const Table* table, int col) {
+    IndexColumn ic;
+    init_index_column(&ic, table, col);
+    memset(hash, 0, sizeof(HashIndex));
+    hash->key_type = ic.key_type;
+
+    int row_count = table->row_count;
+    int key_capacity = MIN_INDEX_SLOTS;
+    hash->slot_count = MIN_INDEX_SLOTS;
+    hash->slots = malloc(hash->slot_count * sizeof(int));
+    hash->key_hashes = malloc(key_capacity * sizeof(uint64_t));
+    hash->key_rows = malloc(key_capacity * sizeof(int));
+    int* row_keys = malloc((row_count > 0 ? row_count : 1) * sizeof(int));
+    if (hash->slots == NULL || hash->key_hashes == NULL || hash->key_rows == NULL || row_keys == NULL) {
+        free(row_keys);
+        free_hash_index(hash);
+        return -1;
+    }
+    memset(hash->slots, -1, hash->slot_count * sizeof(int));
+
+    int indexed = 0;
+    for (int row = 0; row < row_count; row++) {
+        row_keys[row] = -1;
+        if (skip_row(&ic, row)) {
+            continue;
+        }
+        row_keys[row] = find_or_add_key(hash, &ic, row, &key_capacity);
+        if (row_keys[row] < 0) {
+            free(row_keys);
+            free_hash_index(hash);
+            return -1;
+        }
+        indexed++;
+    }
+
+    hash->offsets = calloc(hash->key_count + 1, sizeof(int));
+    hash->row_ids = malloc((indexed > 0 ? indexed : 1) * sizeof(int));
+    if (hash->offsets == NULL || hash->row_ids == NULL) {
+        free(row_keys);
+        free_hash_index(hash);
+        return -1;
+    }
+
+    // offsets[key+1] 先计数，前缀和后 offsets[key] 即该键的起点
+    for (int row = 0; row < row_count; row++) {
+        if (row_keys[row] >= 0) {
+            hash->offsets[row_keys[row] + 1]++;
+        }
+    }
+    for (int key = 0; key < hash->key_count; key++) {
+        hash->offsets[key + 1] += hash->offsets[key];
+    }
+
+    // cursor[key] 是该键下一个行号的写入位置
+    int* cursor = malloc((hash->key_count > 0 ? hash->key_count : 1) * sizeof(int));
+    if (cursor == NULL) {
+        free(row_keys);
+        free_hash_index(hash);
+        return -1;
+    }
+    memcpy(cursor, hash->offsets, hash->key_count * sizeof(int));
+    for (int row = 0; row < row_count; row++) {
+        if (row_keys[row] >= 0) {
+            hash->row_ids[cursor[row_keys[row]]++] = row;
+        }
+    }
+
+    free(cursor);
+    free(row_keys);
+    return 0;
+}
+
+// 查找常量对应的键号，不存在返回-1
+static int lookup_int(const HashIndex* hash, const Table* table, int col, long long value) {
+    const ColumnVector* column = &table->store->columns[col];
+    uint64_t h = hash_u64((uint64_t)value);
+    int mask = hash->slot_count - 1;
+    for (int slot = (int)(h & mask); hash->slots[slot] != -1; slot = (slot + 1) & mask) {
+        int key = hash->slots[slot];
+        if (hash->key_hashes[key] == h && column->ints[hash->key_rows[key]] == value) {
+            return key;
+        }
+    }
+    return -1;
+}
+
+static int lookup_float(const HashIndex* hash, const Table* table, int col, double value) {
+    const ColumnVector* column = &table->store->columns[col];
+    uint64_t h = hash_double(value);
+    int mask = hash->slot_count - 1;
+    for (int slot = (int)(h & mask); hash->slots[slot] != -1; slot = (slot + 1) & mask) {
+        int key = hash->slots[slot];
+        if (hash->key_hashes[key] == h && column->floats[hash->key_rows[key]] == value) {
+            return key;
+        }
+    }
+    return -1;
+}
+
+static int lookup_text(const HashIndex* hash, const Table* table, int col, const char* value) {
+    IndexColumn ic;
+    init_index_column(&ic, table, col);
+    uint64_t h = hash_string(value);
+    int mask = hash->slot_count - 1;
+    for (int slot = (int)(h & mask); hash->slots[slot] != -1; slot = (slot + 1) & mask) {
+        int key = hash->slots[slot];
+        if (hash->key_hashes[key] == h && strcmp(text_cell(&ic, hash->key_rows[key]), value) == 0) {
+            return key;
+        }
+    }
+    return -1;
+}
+
+// 整数列上的等值常量: '5' 和 '5.0' 都查5，非整数常量没有匹配
+static int lookup_int_constant(const HashIndex* hash, const Table* table, int col, const CompiledPredicate* p) {
+    if (p->exact_int) {
+        return lookup_int(hash, table, col, p->int_value);
+    }
+    double value = p->float_value;
+    if (value != floor(value) || !(value > -9.2e18 && value < 9.2e18)) {
+        return -1;
+    }
+    return lookup_int(hash, table, col, (long long)value);
+}
+
+static int compare_row_ids(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// 把若干键的行号段拼起来；多个键时排序恢复行号升序
+static int collect_key_rows(const HashIndex* hash, const int* keys, int key_count, int** rows) {
+    int total = 0;
+    for (int i = 0; i < key_count; i++) {
+        total += hash->offsets[keys[i] + 1] - hash->offsets[keys[i]];
+    }
+
+    int* out = malloc((total > 0 ? total : 1) * sizeof(int));
+    if (out == NULL) {
+        return -1;
+    }
+    int count = 0;
+    for (int i = 0; i < key_count; i++) {
+        int start = hash->offsets[keys[i]];
+        int n = hash->offsets[keys[i] + 1] - start;
+        memcpy(out + count, hash->row_ids + start, n * sizeof(int));
+        count += n;
+    }
+    if (key_count > 1) {
+        qsort(out, count, sizeof(int), compare_row_ids);
+    }
+    *rows = out;
+    return count;
+}
+
+// 谓词能否用键字典 (哈希/位图索引) 回答: = 或与键同类型的 IN
+static int key_dictionary_accepts(const Table* table, const TableIndex* index, const CompiledPredicate* predicate) {
+    if (index->row_count != table->row_count || predicate->col_index != index->col_index) {
+        return 0;
+    }
+    if (predicate->op == OP_EQUAL) {
+        // 数值列上的非数字常量按文本比较，索引帮不上
+        return index->hash.key_type == TYPE_STRING || (predicate->numeric_constant && predicate->column != NULL);
+    }
+    return predicate->op == OP_IN && predicate->set != NULL && predicate->set->type == index->hash.key_type;
+}
+
+// = / IN 的常量在键字典中对应的键号 (*keys需调用者释放)，谓词不能用键字典回答时返回-1
+static int predicate_keys(const Table* table, const TableIndex* index, const CompiledPredicate* predicate,
+                          int** keys, int* key_count) {
+    if (!key_dictionary_accepts(table, index, predicate)) {
+        return -1;
+    }
+
+    const HashIndex* hash = &index->hash;
+    int col = index->col_index;
+    int key;
+    *key_count = 0;
+
+    if (predicate->op == OP_EQUAL) {
+        if (hash->key_type == TYPE_INT) {
+            key = lookup_int_constant(hash, table, col, predicate);
+        } else if (hash->key_type == TYPE_FLOAT) {
+            key = lookup_float(hash, table, col, predicate->float_value);
+        } else {
+            key = lookup_text(hash, table, col, predicate->text);
+        }
+        *keys = malloc(sizeof(int));
+        if (*keys == NULL) {
+            return -1;
+        }
+        if (key >= 0) {
+            (*keys)[(*key_count)++] = key;
+        }
+        return 0;
+    }
+
+    // IN: 逐个取集合中的常量查索引
+    const ValueSet* set = predicate->set;
+    *keys = malloc((set->count > 0 ? set->count : 1) * sizeof(int));
+    if (*keys == NULL) {
+        return -1;
+    }
+    for (int slot = 0; slot < set->capacity; slot++) {
+        if (!set->used[slot]) {
+            continue;
+        }
+        if (hash->key_type == TYPE_INT) {
+            key = lookup_int(hash, table, col, (long long)set->keys[slot]);
+        } else if (hash->key_type == TYPE_FLOAT) {
+            double value;
+            memcpy(&value, &set->keys[slot], sizeof(value));
+            key = lookup_float(hash, table, col, value);
+        } else {
+            key = lookup_text(hash, table, col, set->strings[slot]);
+        }
+        if (key >= 0) {
+            (*keys)[(*key_count)++] = key;
+        }
+    }
+    return 0;
+}
+
+int hash_index_rows(const Table* table, const TableIndex* index, const CompiledPredicate* predicate, int** rows) {
+    if (table == NULL || index == NULL || predicate == NULL || rows == NULL || index->kind != INDEX_HASH) {
+        return -1;
+    }
+
+    int* keys;
+    int key_count;
+    if (predicate_keys(table, index, predicate, &keys, &key_count) != 0) {
+        return -1;
+    }
+    int count = collect_key_rows(&index->hash, keys, key_count, rows);
+    free(keys);
+    return count;
+}
+
+static void free_sorted_index(SortedIndex* sorted) {
+    free(sorted->keys);
+    free(sorted->row_ids);
+    memset(sorted, 0, sizeof(SortedIndex));
+}
+
+// 对全部行号做一次稳定排序 (数值列为基数排序)，再保存排好序的键用于二分查找
+static int build_sorted_index(SortedIndex* sorted, const Table* table, int col) {
+    IndexColumn ic;
+    init_index_column(&ic, table, col);
+    memset(sorted, 0, sizeof(SortedIndex));
+    if (ic.key_type == TYPE_STRING) {
+        return -1;
+    }
+
+    int row_count = table->row_count;
+    sorted->row_ids = malloc((row_count > 0 ? row_count : 1) * sizeof(int));
+    sorted->keys = malloc((row_count > 0 ? row_count : 1) * sizeof(uint64_t));
+    if (sorted->row_ids == NULL || sorted->keys == NULL) {
+        free_sorted_index(sorted);
+        return -1;
+    }
+    for (int row = 0; row < row_count; row++) {
+        sorted->row_ids[row] = row;
+    }
+    if (sort_row_ids(table, col, SORT_ASC, sorted->row_ids, row_count) != 0) {
+        free_sorted_index(sorted);
+        return -1;
+    }
+
+    for (int i = 0; i < row_count; i++) {
+        int row = sorted->row_ids[i];
+        sorted->keys[i] = (ic.key_type == TYPE_INT) ? sort_key_int(ic.column->ints[row])
+                                                    : sort_key_double(ic.column->floats[row]);
+    }
+    sorted->count = row_count;
+    return 0;
+}
+
+// 常量换算成保序键区间的端点；整数列向外取整，保证候选行不少于真正满足的行
+static uint64_t range_low_key(DataType key_type, double value) {
+    if (key_type == TYPE_FLOAT) {
+        return sort_key_double(value);
+    }
+    if (!(value >= -INT_KEY_LIMIT)) {
+        return 0;
+    }
+    if (value >= INT_KEY_LIMIT) {
+        return UINT64_MAX;
+    }
+    return sort_key_int((long long)floor(value));
+}
+
+static uint64_t range_high_key(DataType key_type, double value) {
+    if (key_type == TYPE_FLOAT) {
+        return sort_key_double(value);
+    }
+    if (!(value < INT_KEY_LIMIT)) {
+        return UINT64_MAX;
+    }
+    if (value < -INT_KEY_LIMIT) {
+        return 0;
+    }
+    return sort_key_int((long long)ceil(value));
+}
+
+// 第一个键 >= key 的位置
+static int lower_bound(const SortedIndex* sorted, uint64_t key) {
+    int low = 0;
+    int high = sorted->count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (sorted->keys[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// 第一个键 > key 的位置
+static int upper_bound(const SortedIndex* sorted, uint64_t key) {
+    int low = 0;
+    int high = sorted->count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (sorted->keys[mid] <= key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// 谓词在有序索引中对应的连续一段 [*start, *end)
+// 不能用该索引，或区间超过表的 1/SORTED_SCAN_DIVISOR (逐行扫描更快) 时返回-1
+static int sorted_index_range(const Table* table, const TableIndex* index, const CompiledPredicate* predicate,
+                              int* start, int* end) {
+    if (index->kind != INDEX_SORTED || index->row_count != table->row_count ||
+        predicate->col_index != index->col_index || predicate->column == NULL ||
+        !column_is_numeric(predicate->column)) {
+        return -1;
+    }
+
+    const SortedIndex* sorted = &index->sorted;
+    DataType key_type = predicate->column->type;
+    uint64_t low = 0;
+    uint64_t high = UINT64_MAX;
+
+    switch (predicate->op) {
+        case OP_GREATER:
+        case OP_GREATER_EQUAL:
+            low = range_low_key(key_type, predicate->float_value);
+            break;
+        case OP_LESS:
+        case OP_LESS_EQUAL:
+            high = range_high_key(key_type, predicate->float_value);
+            break;
+        case OP_BETWEEN:
+            low = range_low_key(key_type, predicate->float_value);
+            high = range_high_key(key_type, predicate->float_high);
+            break;
+        case OP_EQUAL:
+            // 非数字常量按文本比较，索引帮不上
+            if (!predicate->numeric_constant) {
+                return -1;
+            }
+            if (key_type == TYPE_INT && predicate->exact_int) {
+                low = high = sort_key_int(predicate->int_value);
+            } else {
+                low = range_low_key(key_type, predicate->float_value);
+                high = range_high_key(key_type, predicate->float_value);
+            }
+            break;
+        default:
+            return -1;
+    }
+
+    // 二分查找出连续的一段
+    *start = lower_bound(sorted, low);
+    *end = (low <= high) ? upper_bound(sorted, high) : *start;
+    if (*end < *start) {
+        *end = *start;
+    }
+    if (*end - *start > sorted->count / SORTED_SCAN_DIVISOR) {
+        return -1;
+    }
+    return 0;
+}
+
+int sorted_index_rows(const Table* table, const TableIndex* index, const CompiledPredicate* predicate, int** rows) {
+    int start;
+    int end;
+    if (table == NULL || index == NULL || predicate == NULL || rows == NULL ||
+        sorted_index_range(table, index, predicate, &start, &end) != 0) {
+        return -1;
+    }
+
+    // 区间内的行恢复成行号升序
+    const SortedIndex* sorted = &index->sorted;
+    int count = end - start;
+
+    int* out = malloc((count > 0 ? count : 1) * sizeof(int));
+    if (out == NULL) {
+        return -1;
+    }
+    if (count <= sorted->count / SORTED_QSORT_DIVISOR) {
+        memcpy(out, sorted->row_ids + start, count * sizeof(int));
+        qsort(out, count, sizeof(int), compare_row_ids);
+    } else {
+        unsigned char* marks = calloc(sorted->count, 1);
+        if (marks == NULL) {
+            free(out);
+            return -1;
+        }
+        for (int i = start; i < end; i++) {
+            marks[sorted->row_ids[i]] = 1;
+        }
+        int n = 0;
+        for (int row = 0; row < sorted->count; row++) {
+            if (marks[row]) {
+                out[n++] = row;
+            }
+        }
+        free(marks);
+    }
+    *rows = out;
+    return count;
+}
+
+int index_predicate_rows(const Table* table, const CompiledPredicate* predicate, int** rows) {
+    if (table == NULL || predicate == NULL || rows == NULL || predicate->col_index == -1) {
+        return -1;
+    }
+    // 有统计信息时，不用先从各个索引取出候选行才发现谓词不够有选择性
+    if (stats_predicate_selectivity(table, predicate) > STATS_SCAN_SELECTIVITY) {
+        return -1;
+    }
+
+    int best_count = -1;
+    for (const TableIndex* index = table->indexes; index != NULL; index = index->next) {
+        // 位图索引在index_filter_rows中按整棵条件树使用
+        if (index->col_index != predicate->col_index || index->row_count != table->row_count ||
+            index->kind == INDEX_BITMAP) {
+            continue;
+        }
+        int* candidate = NULL;
+        int count;
+        if (index->kind == INDEX_HASH) {
+            count = hash_index_rows(table, index, predicate, &candidate);
+        } else if (index->kind == INDEX_SORTED) {
+            count = sorted_index_rows(table, index, predicate, &candidate);
+        } else {
+            count = trigram_index_rows(table, index, predicate, &candidate);
+        }
+        if (count < 0) {
+            continue;
+        }
+        if (best_count == -1 || count < best_count) {
+            if (best_count != -1) {
+                free(*rows);
+            }
+            *rows = candidate;
+            best_count = count;
+        } else {
+            free(candidate);
+        }
+    }
+    return best_count;
+}
+
+static void free_bitmap_index(TableIndex* index) {
+    if (index->bitmaps != NULL) {
+        for (int key = 0; key < index->hash.key_count; key++) {
+            roaring_free(index->bitmaps[key]);
+        }
+    }
+    free(index->bitmaps);
+    index->bitmaps = NULL;
+}
+
+// 位图索引: 先按哈希索引的方式把行按值分组，再把每个值的行号段压成一个Roaring位图
+static int build_bitmap_index(TableIndex* index, const Table* table, int col) {
+    if (build_hash_index(&index->hash, table, col) != 0) {
+        return -1;
+    }
+    HashIndex* hash = &index->hash;
+    if (hash->key_count > BITMAP_MAX_VALUES) {
+        free_hash_index(hash);
+        return -1;
+    }
+
+    index->bitmaps = calloc(hash->key_count > 0 ? hash->key_count : 1, sizeof(RoaringBitmap*));
+    if (index->bitmaps == NULL) {
+        free_hash_index(hash);
+        return -1;
+    }
+    for (int key = 0; key < hash->key_count; key++) {
+        int start = hash->offsets[key];
+        index->bitmaps[key] = roaring_from_sorted(hash->row_ids + start, hash->offsets[key + 1] - start);
+        if (index->bitmaps[key] == NULL) {
+            free_bitmap_index(index);
+            free_hash_index(hash);
+            return -1;
+        }
+    }
+
+    // 行号段已经压进位图，只保留键字典
+    free(hash->offsets);
+    free(hash->row_ids);
+    hash->offsets = NULL;
+    hash->row_ids = NULL;
+    return 0;
+}
+
+// 叶子谓词能否由位图索引精确回答
+static int bitmap_answers_predicate(const Table* table, const CompiledPredicate* predicate) {
+    const TableIndex* index = find_table_index(table, predicate->col_index, INDEX_BITMAP);
+    if (index == NULL) {
+        return 0;
+    }
+    // 整数列和超出双精度整数范围的非整数写法常量: 比较按double进行，查键不一定与之一致
+    if (index->hash.key_type == TYPE_INT && predicate->op == OP_EQUAL && !predicate->exact_int &&
+        !(fabs(predicate->float_value) < 9007199254740992.0)) {
+        return 0;
+    }
+
+    int* keys;
+    int key_count;
+    if (predicate_keys(table, index, predicate, &keys, &key_count) != 0) {
+        return 0;
+    }
+    free(keys);
+    return 1;
+}
+
+// 整棵条件树的叶子都能由位图索引回答时，AND/OR/NOT可以直接换成位运算
+static int bitmap_answers_filter(const Table* table, const FilterNode* node) {
+    if (node->kind == COND_COMPARE) {
+        return node->predicate.col_index != -1 && bitmap_answers_predicate(table, &node->predicate);
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        if (!bitmap_answers_filter(table, node->children[i])) {
+            return 0;
+        }
+    }
+    return node->child_count > 0;
+}
+
+// 叶子谓词: 匹配到的各个值的位图之并
+static RoaringBitmap* bitmap_predicate(const Table* table, const CompiledPredicate* predicate) {
+    const TableIndex* index = find_table_index(table, predicate->col_index, INDEX_BITMAP);
+    int* keys;
+    int key_count;
+    if (index == NULL || predicate_keys(table, index, predicate, &keys, &key_count) != 0) {
+        return NULL;
+    }
+
+    RoaringBitmap* result = roaring_create();
+    for (int i = 0; i < key_count && result != NULL; i++) {
+        RoaringBitmap* merged = roaring_or(result, index->bitmaps[keys[i]]);
+        roaring_free(result);
+        result = merged;
+    }
+    free(keys);
+    return result;
+}
+
+// 按条件树求满足条件的行的位图 (要求bitmap_answers_filter成立)，内存不足返回NULL
+static RoaringBitmap* bitmap_filter(const Table* table, const FilterNode* node) {
+    if (node->kind == COND_COMPARE) {
+        return bitmap_predicate(table, &node->predicate);
+    }
+
+    RoaringBitmap* result = bitmap_filter(table, node->children[0]);
+    if (node->kind == COND_NOT) {
+        RoaringBitmap* all = roaring_range(table->row_count);
+        RoaringBitmap* complement = roaring_andnot(all, result);
+        roaring_free(all);
+        roaring_free(result);
+        return complement;
+    }
+
+    for (int i = 1; i < node->child_count && result != NULL; i++) {
+        RoaringBitmap* child = bitmap_filter(table, node->children[i]);
+        RoaringBitmap* combined = (node->kind == COND_AND) ? roaring_and(result, child) : roaring_or(result, child);
+        roaring_free(child);
+        roaring_free(result);
+        result = combined;
+    }
+    return result;
+}
+
+static int bitmap_rows(const RoaringBitmap* bitmap, int** rows) {
+    int count = roaring_cardinality(bitmap);
+    *rows = malloc((count > 0 ? count : 1) * sizeof(int));
+    if (*rows == NULL) {
+        return -1;
+    }
+    return roaring_to_array(bitmap, *rows);
+}
+
+int index_filter_rows(const Table* table, const FilterNode* filter, int** rows, int* exact) {
+    *exact = 0;
+    if (table == NULL || filter == NULL || rows == NULL || table->indexes == NULL) {
+        return -1;
+    }
+
+    // 整个条件都能由位图索引回答: 结果是精确的，不需要再逐行检查
+    if (bitmap_answers_filter(table, filter)) {
+        RoaringBitmap* bitmap = bitmap_filter(table, filter);
+        int count = (bitmap != NULL) ? bitmap_rows(bitmap, rows) : -1;
+        roaring_free(bitmap);
+        if (count >= 0) {
+            *exact = 1;
+            return count;
+        }
+    }
+
+    // 否则看WHERE本身或顶层AND的各个子条件: 能由位图回答的子条件求交，
+    // 其余子条件各自查哈希/有序索引，取候选行最少的一种
+    const FilterNode* const* children = &filter;
+    int child_count = 1;
+    if (filter->kind == COND_AND) {
+        children = (const FilterNode* const*)filter->children;
+        child_count = filter->child_count;
+    }
+
+    RoaringBitmap* candidates = NULL;
+    int best_count = -1;
+    for (int i = 0; i < child_count; i++) {
+        if (bitmap_answers_filter(table, children[i])) {
+            RoaringBitmap* bitmap = bitmap_filter(table, children[i]);
+            RoaringBitmap* combined = (candidates != NULL && bitmap != NULL) ? roaring_and(candidates, bitmap) : NULL;
+            if (candidates == NULL) {
+                candidates = bitmap;
+            } else {
+                roaring_free(candidates);
+                roaring_free(bitmap);
+                candidates = combined;
+            }
+            continue;
+        }
+        if (children[i]->kind != COND_COMPARE) {
+            continue;
+        }
+
+        int* candidate = NULL;
+        int count = index_predicate_rows(table, &children[i]->predicate, &candidate);
+        if (count < 0) {
+            continue;
+        }
+        if (best_count == -1 || count < best_count) {
+            if (best_count != -1) {
+                free(*rows);
+            }
+            *rows = candidate;
+            best_count = count;
+        } else {
+            free(candidate);
+        }
+    }
+
+    if (candidates != NULL && (best_count == -1 || roaring_cardinality(candidates) < best_count)) {
+        int* candidate = NULL;
+        int count = bitmap_rows(candidates, &candidate);
+        if (count >= 0) {
+            if (best_count != -1) {
+                free(*rows);
+            }
+            *rows = candidate;
+            best_count = count;
+        }
+    }
+    roaring_free(candidates);
+    return best_count;
+}
+
+// LIKE模式中通配符之间是否有长度不小于3的文字段 (没有时三元组索引帮不上)
+static int has_trigram_segment(const char* pattern) {
+    while (*pattern != '\0') {
+        size_t len = strcspn(pattern, "%_");
+        if (len >= 3) {
+            return 1;
+        }
+        pattern += len;
+        if (*pattern != '\0') {
+            pattern++;
+        }
+    }
+    return 0;
+}
+
+// 索引能否回答该谓词: 与各 *_index_rows 返回-1的条件相同 (有序索引同样检查区间是否太宽)
+// index_filter_access只用它判断而不取行，EXPLAIN说明的访问路径因此与执行时一致
+static int index_accepts(const Table* table, const TableIndex* index, const CompiledPredicate* predicate) {
+    int start;
+    int end;
+    switch (index->kind) {
+        case INDEX_HASH:
+            return key_dictionary_accepts(table, index, predicate);
+        case INDEX_SORTED:
+            return sorted_index_range(table, index, predicate, &start, &end) == 0;
+        case INDEX_TRIGRAM:
+            return predicate->op == OP_LIKE && index->row_count == table->row_count &&
+                   predicate->col_index == index->col_index && has_trigram_segment(predicate->text);
+        default:
+            return 0;
+    }
+}
+
+IndexAccess index_filter_access(const Table* table, const FilterNode* filter, const TableIndex** used) {
+    *used = NULL;
+    if (table == NULL || filter == NULL || table->indexes == NULL) {
+        return INDEX_ACCESS_NONE;
+    }
+    if (bitmap_answers_filter(table, filter)) {
+        *used = find_table_index(table, filter->kind == COND_COMPARE ? filter->predicate.col_index : -1,
+                                 INDEX_BITMAP);
+        return INDEX_ACCESS_EXACT;
+    }
+
+    const FilterNode* const* children = &filter;
+    int child_count = 1;
+    if (filter->kind == COND_AND) {
+        children = (const FilterNode* const*)filter->children;
+        child_count = filter->child_count;
+    }
+    // 与index_filter_rows相同的候选: 位图能回答的子条件，或有合适索引且不太宽的比较
+    for (int i = 0; i < child_count; i++) {
+        if (bitmap_answers_filter(table, children[i])) {
+            return INDEX_ACCESS_CANDIDATES;
+        }
+        const CompiledPredicate* predicate = &children[i]->predicate;
+        if (children[i]->kind != COND_COMPARE || predicate->col_index == -1 ||
+            stats_predicate_selectivity(table, predicate) > STATS_SCAN_SELECTIVITY) {
+            continue;
+        }
+        for (const TableIndex* index = table->indexes; index != NULL; index = index->next) {
+            if (index_accepts(table, index, predicate)) {
+                *used = index;
+                return INDEX_ACCESS_CANDIDATES;
+            }
+        }
+    }
+    return INDEX_ACCESS_NONE;
+}
+
+int index_count_rows(const Table* table, const FilterNode* filter) {
+    if (table == NULL || filter == NULL || table->indexes == NULL || !bitmap_answers_filter(table, filter)) {
+        return -1;
+    }
+    RoaringBitmap* bitmap = bitmap_filter(table, filter);
+    if (bitmap == NULL) {
+        return -1;
+    }
+    int count = roaring_cardinality(bitmap);
+    roaring_free(bitmap);
+    return count;
+}
+
+static void free_trigram_index(TrigramIndex* trigram) {
+    if (trigram->postings != NULL) {
+        for (int gram = 0; gram < trigram->gram_count; gram++) {
+            roaring_free(trigram->postings[gram]);
+        }
+    }
+    free(trigram->postings);
+    free(trigram->slots);
+    free(trigram->grams);
+    memset(trigram, 0, sizeof(TrigramIndex));
+}
+
+// 三元组编码对应的三元组号，不存在返回-1
+static int find_gram(const TrigramIndex* trigram, uint32_t code) {
+    int mask = trigram->slot_count - 1;
+    for (int slot = (int)(hash_u64(code) & mask); trigram->slots[slot] != -1; slot = (slot + 1) & mask) {
+        if (trigram->grams[trigram->slots[slot]] == code) {
+            return trigram->slots[slot];
+        }
+    }
+    return -1;
+}
+
+// 建索引时的三元组字典: counts和last_rows与grams一起增长
+typedef struct {
+    int capacity;
+    int* counts;        // [三元组号] 含有它的行数
+    int* last_rows;     // [三元组号] 最近一次出现的行，同一行里重复的三元组只记一次
+} GramBuilder;
+
+static int grow_gram_slots(TrigramIndex* trigram) {
+    int slot_count = trigram->slot_count * 2;
+    int* slots = malloc(slot_count * sizeof(int));
+    if (slots == NULL) {
+        return -1;
+    }
+    memset(slots, -1, slot_count * sizeof(int));
+
+    int mask = slot_count - 1;
+    for (int gram = 0; gram < trigram->gram_count; gram++) {
+        int slot = (int)(hash_u64(trigram->grams[gram]) & mask);
+        while (slots[slot] != -1) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = gram;
+    }
+    free(trigram->slots);
+    trigram->slots = slots;
+    trigram->slot_count = slot_count;
+    return 0;
+}
+
+// 返回编码对应的三元组号，第一次出现时新建；内存不足返回-1
+static int find_or_add_gram(TrigramIndex* trigram, GramBuilder* builder, uint32_t code) {
+    int gram = find_gram(trigram, code);
+    if (gram != -1) {
+        return gram;
+    }
+    if ((trigram->gram_count + 1) * 2 > trigram->slot_count && grow_gram_slots(trigram) != 0) {
+        return -1;
+    }
+
+    if (trigram->gram_count == builder->capacity) {
+        int capacity = builder->capacity * 2;
+        uint32_t* grams = realloc(trigram->grams, capacity * sizeof(uint32_t));
+        if (grams == NULL) {
+            return -1;
+        }
+        trigram->grams = grams;
+        int* counts = realloc(builder->counts, capacity * sizeof(int));
+        if (counts == NULL) {
+            return -1;
+        }
+        builder->counts = counts;
+        int* last_rows = realloc(builder->last_rows, capacity * sizeof(int));
+        if (last_rows == NULL) {
+            return -1;
+        }
+        builder->last_rows = last_rows;
+        builder->capacity = capacity;
+    }
+
+    int mask = trigram->slot_count - 1;
+    int slot = (int)(hash_u64(code) & mask);
+    while (trigram->slots[slot] != -1) {
+        slot = (slot + 1) & mask;
+    }
+    gram = trigram->gram_count++;
+    trigram->grams[gram] = code;
+    trigram->slots[slot] = gram;
+    builder->counts[gram] = 0;
+    builder->last_rows[gram] = -1;
+    return gram;
+}
+
+// 两遍建索引: 第一遍建字典并统计每个三元组的行数，第二遍按行号顺序填入各三元组的行号段，
+// 最后把每段压成位图
+static int build_trigram_index(TrigramIndex* trigram, const Table* table, int col) {
+    IndexColumn ic;
+    init_index_column(&ic, table, col);
+    memset(trigram, 0, sizeof(TrigramIndex));
+
+    GramBuilder builder;
+    builder.capacity = MIN_INDEX_SLOTS;
+    builder.counts = malloc(builder.capacity * sizeof(int));
+    builder.last_rows = malloc(builder.capacity * sizeof(int));
+    trigram->slot_count = MIN_INDEX_SLOTS;
+    trigram->slots = malloc(trigram->slot_count * sizeof(int));
+    trigram->grams = malloc(builder.capacity * sizeof(uint32_t));
+    int status = (builder.counts == NULL || builder.last_rows == NULL || trigram->slots == NULL ||
+                  trigram->grams == NULL) ? -1 : 0;
+    if (status == 0) {
+        memset(trigram->slots, -1, trigram->slot_count * sizeof(int));
+    }
+
+    long long total = 0;
+    for (int row = 0; row < table->row_count && status == 0; row++) {
+        const char* text = text_cell(&ic, row);
+        if (text == NULL) {
+            continue;
+        }
+        size_t len = strlen(text);
+        for (size_t i = 0; i + 3 <= len; i++) {
+            int gram = find_or_add_gram(trigram, &builder, TRIGRAM_CODE(text[i], text[i + 1], text[i + 2]));
+            if (gram < 0) {
+                status = -1;
+                break;
+            }
+            if (builder.last_rows[gram] != row) {
+                builder.last_rows[gram] = row;
+                builder.counts[gram]++;
+                total++;
+            }
+        }
+    }
+    if (total > INT_MAX) {
+        status = -1;
+    }
+
+    int* offsets = NULL;
+    int* row_ids = NULL;
+    if (status == 0) {
+        offsets = malloc((trigram->gram_count + 1) * sizeof(int));
+        row_ids = malloc((total > 0 ? total : 1) * sizeof(int));
+        status = (offsets == NULL || row_ids == NULL) ? -1 : 0;
+    }
+
+    if (status == 0) {
+        // counts改作各三元组下一个行号的写入位置
+        offsets[0] = 0;
+        for (int gram = 0; gram < trigram->gram_count; gram++) {
+            offsets[gram + 1] = offsets[gram] + builder.counts[gram];
+            builder.counts[gram] = offsets[gram];
+            builder.last_rows[gram] = -1;
+        }
+        for (int row = 0; row < table->row_count; row++) {
+            const char* text = text_cell(&ic, row);
+            if (text == NULL) {
+                continue;
+            }
+            size_t len = strlen(text);
+            for (size_t i = 0; i + 3 <= len; i++) {
+                int gram = find_gram(trigram, TRIGRAM_CODE(text[i], text[i + 1], text[i + 2]));
+                if (builder.last_rows[gram] != row) {
+                    builder.last_rows[gram] = row;
+                    row_ids[builder.counts[gram]++] = row;
+                }
+            }
+        }
+
+        trigram->postings = calloc(trigram->gram_count > 0 ? trigram->gram_count : 1, sizeof(RoaringBitmap*));
+        status = (trigram->postings == NULL) ? -1 : 0;
+        for (int gram = 0; gram < trigram->gram_count && status == 0; gram++) {
+            trigram->postings[gram] = roaring_from_sorted(row_ids + offsets[gram], offsets[gram + 1] - offsets[gram]);
+            status = (trigram->postings[gram] == NULL) ? -1 : 0;
+        }
+    }
+
+    free(offsets);
+    free(row_ids);
+    free(builder.counts);
+    free(builder.last_rows);
+    if (status != 0) {
+        free_trigram_index(trigram);
+    }
+    return status;
+}
+
+int trigram_index_rows(const Table* table, const TableIndex* index, const CompiledPredicate* predicate, int** rows) {
+    if (table == NULL || index == NULL || predicate == NULL || rows == NULL || index->kind != INDEX_TRIGRAM ||
+        predicate->op != OP_LIKE || index->row_count != table->row_count ||
+        predicate->col_index != index->col_index || !has_trigram_segment(predicate->text)) {
+        return -1;
+    }
+
+    // 通配符 % 和 _ 之间的每段文字都必须出现在匹配的单元格中，其中每个三元组也是
+    const TrigramIndex* trigram = &index->trigram;
+    const char* pattern = predicate->text;
+    size_t pattern_len = strlen(pattern);
+    int* grams = malloc((pattern_len > 0 ? pattern_len : 1) * sizeof(int));
+    int* sizes = malloc((pattern_len > 0 ? pattern_len : 1) * sizeof(int));
+    if (grams == NULL || sizes == NULL) {
+        free(grams);
+        free(sizes);
+        return -1;
+    }
+
+    int gram_count = 0;
+    int missing = 0;
+    for (const char* segment = pattern; *segment != '\0' && !missing;) {
+        size_t len = strcspn(segment, "%_");
+        for (size_t i = 0; i + 3 <= len; i++) {
+            int gram = find_gram(trigram, TRIGRAM_CODE(segment[i], segment[i + 1], segment[i + 2]));
+            if (gram == -1) {
+                missing = 1;
+                break;
+            }
+            // 按位图大小插入排序，从最小的开始求交
+            int size = roaring_cardinality(trigram->postings[gram]);
+            int j = gram_count++;
+            while (j > 0 && sizes[j - 1] > size) {
+                grams[j] = grams[j - 1];
+                sizes[j] = sizes[j - 1];
+                j--;
+            }
+            grams[j] = gram;
+            sizes[j] = size;
+        }
+        segment += len;
+        if (*segment != '\0') {
+            segment++;
+        }
+    }
+
+    int count = -1;
+    if (missing) {
+        // 有三元组从未出现过: 没有行能匹配
+        *rows = malloc(sizeof(int));
+        count = (*rows != NULL) ? 0 : -1;
+    } else if (gram_count > 0) {
+        const RoaringBitmap* current = trigram->postings[grams[0]];
+        RoaringBitmap* owned = NULL;
+        for (int i = 1; i < gram_count && current != NULL && roaring_cardinality(current) > 0; i++) {
+            RoaringBitmap* next = roaring_and(current, trigram->postings[grams[i]]);
+            roaring_free(owned);
+            owned = next;
+            current = next;
+        }
+        count = (current != NULL) ? bitmap_rows(current, rows) : -1;
+        roaring_free(owned);
+    }
+
+    free(grams);
+    free(sizes);
+    return count;
+}
+
+int sorted_index_order(const Table* table, const TableIndex* index, SortDirection direction,
+                       const int* selected, int count, int limit, int* out) {
+    if (table == NULL || index == NULL || out == NULL || index->kind != INDEX_SORTED ||
+        index->row_count != table->row_count) {
+        return -1;
+    }
+
+    // 子集用标记数组判断成员
+    const SortedIndex* sorted = &index->sorted;
+    unsigned char* marks = NULL;
+    if (selected != NULL) {
+        marks = calloc(sorted->count > 0 ? sorted->count : 1, 1);
+        if (marks == NULL) {
+            return -1;
+        }
+        for (int i = 0; i < count; i++) {
+            marks[selected[i]] = 1;
+        }
+    }
+    if (limit > count) {
+        limit = count;
+    }
+
+    int n = 0;
+    if (direction == SORT_ASC) {
+        for (int i = 0; i < sorted->count && n < limit; i++) {
+            int row = sorted->row_ids[i];
+            if (marks == NULL || marks[row]) {
+                out[n++] = row;
+            }
+        }
+    } else {
+        // 降序: 从后往前逐段取相等的值，段内仍按行号升序输出 (与稳定排序一致)
+        int end = sorted->count;
+        while (end > 0 && n < limit) {
+            int start = end - 1;
+            while (start > 0 && sorted->keys[start - 1] == sorted->keys[end - 1]) {
+                start--;
+            }
+            for (int i = start; i < end && n < limit; i++) {
+                int row = sorted->row_ids[i];
+                if (marks == NULL || marks[row]) {
+                    out[n++] = row;
+                }
+            }
+            end = start;
+        }
+    }
+
+    free(marks);
+    return n;
+}
+
+static void free_index(TableIndex* index) {
+    free_bitmap_index(index);
+    free_trigram_index(&index->trigram);
+    free_hash_index(&index->hash);
+    free_sorted_index(&index->sorted);
+    free(index);
+}
+
+int create_table_index(Table* table, const char* name, const char* column, IndexKind kind) {
+    if (table == NULL || name == NULL || column == NULL) {
+        return -1;
+    }
+    int col = get_column_index(table, column);
+    if (col == -1) {
+        return -1;
+    }
+
+    TableIndex* index = calloc(1, sizeof(TableIndex));
+    if (index == NULL) {
+        return -1;
+    }
+    strncpy(index->name, name, MAX_COLUMN_NAME_LEN - 1);
+    index->kind = kind;
+    index->col_index = col;
+    index->row_count = table->row_count;
+    int status;
+    if (kind == INDEX_HASH) {
+        status = build_hash_index(&index->hash, table, col);
+    } else if (kind == INDEX_SORTED) {
+        status = build_sorted_index(&index->sorted, table, col);
+    } else if (kind == INDEX_BITMAP) {
+        status = build_bitmap_index(index, table, col);
+    } else {
+        status = build_trigram_index(&index->trigram, table, col);
+    }
+    if (status != 0) {
+        free(index);
+        return -1;
+    }
+
+    // 同名索引 (不区分大小写) 被新索引替换
+    TableIndex** link = &table->indexes;
+    while (*link != NULL) {
+        TableIndex* old = *link;
+        if (strcasecmp(old->name, name) == 0) {
+            *link = old->next;
+            free_index(old);
+        } else {
+            link = &old->next;
+        }
+    }
+    index->next = table->indexes;
+    table->indexes = index;
+    return 0;
+}
+
+const TableIndex* find_table_index(const Table* table, int col_index, IndexKind kind) {
+    if (table == NULL) {
+        return NULL;
+    }
+    for (const TableIndex* index = table->indexes; index != NULL; index = index->next) {
+        if (index->col_index == col_index && index->kind == kind && index->row_count == table->row_count) {
+            return index;
+        }
+    }
+    return NULL;
+}
+
+void free_table_indexes(Table* table) {
+    if (table == NULL) {
+        return;
+    }
+    TableIndex* index = table->indexes;
+    while (index != NULL) {
+        TableIndex* next = index->next;
+        free_index(index);
+        index = next;
+    }
+    table->indexes = NULL;
+}
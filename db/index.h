@@ -0,0 +1,111 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+#include <stdint.h>
+#include "table.h"
+#include "predicate.h"
+#include "roaring.h"
+
+#define BITMAP_MAX_VALUES 65536   // 位图索引用于低基数列，不同值超过这个数时拒绝建立
+
+// 索引种类
+typedef enum {
+    INDEX_HASH,
+    INDEX_SORTED,
+    INDEX_BITMAP,
+    INDEX_TRIGRAM
+} IndexKind;
+
+// 哈希索引: 每个不同的值对应一段按行号升序的行号列表，空值不进索引
+// 类型化数值列按数值建键，其余列按单元格文本建键 (与谓词的比较方式一致)
+typedef struct {
+    DataType key_type;        // TYPE_INT/TYPE_FLOAT/TYPE_STRING
+    int* slots;               // 开放寻址，存键号，-1为空槽
+    int slot_count;           // 2的幂
+    uint64_t* key_hashes;     // [键号]
+    int* key_rows;            // [键号] 该值第一次出现的行，用于比较键
+    int* offsets;             // [键号] 在row_ids中的起点，共 key_count+1 项
+    int* row_ids;
+    int key_count;
+} HashIndex;
+
+// 有序索引: 按值升序排列的行号 (相等的值按行号升序)，只用于类型化数值列
+// keys[i] 是 row_ids[i] 的保序键 (见sort.h)；空值与排序和范围比较一样按0处理
+typedef struct {
+    uint64_t* keys;
+    int* row_ids;
+    int count;
+} SortedIndex;
+
+// 三元组倒排索引: 单元格文本中每三个连续字节为一个三元组，每个三元组一个含有它的行的位图
+// 用于 LIKE 的子串查找，按字节比较 (区分大小写)，空值不进索引
+typedef struct {
+    int* slots;               // 开放寻址，存三元组号，-1为空槽
+    int slot_count;           // 2的幂
+    uint32_t* grams;          // [三元组号] 三个字节拼成的24位编码
+    RoaringBitmap** postings; // [三元组号]
+    int gram_count;
+} TrigramIndex;
+
+// 表上的一个索引，挂在 Table.indexes 链表上
+typedef struct TableIndex {
+    char name[MAX_COLUMN_NAME_LEN];
+    IndexKind kind;
+    int col_index;
+    int row_count;            // 建索引时的行数，之后表又追加了行则索引不再使用
+    HashIndex hash;           // INDEX_HASH; INDEX_BITMAP只用其中的键字典
+    SortedIndex sorted;       // INDEX_SORTED
+    RoaringBitmap** bitmaps;  // INDEX_BITMAP: 每个键号一个位图
+    TrigramIndex trigram;     // INDEX_TRIGRAM
+    struct TableIndex* next;
+} TableIndex;
+
+// 在column上建指定种类的索引 (同名索引会被替换)，成功返回0
+// 有序索引要求列是类型化的数值列，否则返回-1
+int create_table_index(Table* table, const char* name, const char* column, IndexKind kind);
+
+// 查找某列上可用的索引，没有时返回NULL
+const TableIndex* find_table_index(const Table* table, int col_index, IndexKind kind);
+
+// 释放表上的所有索引
+void free_table_indexes(Table* table);
+
+// 用索引求 = / IN 谓词的候选行 (升序，*rows需调用者释放)
+// 返回行数；谓词不能走该索引时返回-1 (如数值列和非数字常量按文本比较)
+int hash_index_rows(const Table* table, const TableIndex* index, const CompiledPredicate* predicate, int** rows);
+
+// 用有序索引求 > < >= <= BETWEEN 和数值 = 的候选行 (升序，可能多于真正满足的行)
+// 区间太大、逐行扫描更快时返回-1
+int sorted_index_rows(const Table* table, const TableIndex* index, const CompiledPredicate* predicate, int** rows);
+
+// 用三元组索引求 LIKE 的候选行 (升序，还需逐行检查)：取模式中通配符之间的各段文字，
+// 对其中所有三元组的位图求交；没有长度不小于3的文字段时返回-1
+int trigram_index_rows(const Table* table, const TableIndex* index, const CompiledPredicate* predicate, int** rows);
+
+// 在谓词列上的所有哈希/有序/三元组索引中取候选行最少的一个，没有可用索引时返回-1
+// ANALYZE过的表上估计满足比例较高的谓词直接返回-1 (逐行扫描)
+int index_predicate_rows(const Table* table, const CompiledPredicate* predicate, int** rows);
+
+// 用索引求整个WHERE的行 (升序，*rows需调用者释放)，不能用索引时返回-1
+// 条件树完全由位图索引回答时*exact为1，结果就是满足条件的行；否则是还需逐行检查的候选行
+int index_filter_rows(const Table* table, const FilterNode* filter, int** rows, int* exact);
+
+// index_filter_rows会走的路径，供EXPLAIN在不执行时说明
+typedef enum {
+    INDEX_ACCESS_NONE,          // 逐行扫描
+    INDEX_ACCESS_EXACT,         // 位图索引精确回答整个条件
+    INDEX_ACCESS_CANDIDATES     // 索引给出候选行，再逐行检查 (候选行太多时仍可能退回扫描)
+} IndexAccess;
+
+// 判断条件会怎样使用索引 (不取行)，*used为说明用的一个索引，可能为NULL
+IndexAccess index_filter_access(const Table* table, const FilterNode* filter, const TableIndex** used);
+
+// 条件树完全由位图索引回答时返回满足条件的行数 (位图的基数)，否则返回-1
+int index_count_rows(const Table* table, const FilterNode* filter);
+
+// 按有序索引的顺序输出行号，结果与对这些行做稳定排序相同
+// selected为升序的行号子集 (NULL表示全部行)，最多输出limit行，返回输出的行数
+int sorted_index_order(const Table* table, const TableIndex* index, SortDirection direction,
+                       const int* selected, int count, int limit, int* out);
+
+#endif // INDEX_H
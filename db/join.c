@@ -0,0 +1,311 @@
+#include "join.h"
+#include "column_store.h"
+#include "hash.h"
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#define strncasecmp _strnicmp
+#else
+#include <strings.h>
+#endif
+
+#define MIN_JOIN_BUCKETS 16
+
+// 连接键的比较方式: 两边都是整数列时按整数，都是数值列时按浮点数，否则按单元格字符串
+typedef enum {
+    JOIN_KEY_INT,
+    JOIN_KEY_FLOAT,
+    JOIN_KEY_TEXT
+} JoinKeyMode;
+
+typedef struct {
+    const Table* table;
+    int col;
+    const ColumnVector* column;   // 类型化列，没有列式存储时为NULL
+} JoinSide;
+
+// 连接结果的行号对
+typedef struct {
+    int* left_rows;
+    int* right_rows;
+    int count;
+    int capacity;
+} JoinPairs;
+
+// 把ON中的列名解析到某一侧: 带前缀时按前缀选表，否则必须只在一侧出现
+// 返回0表示左表，1表示右表，-1表示找不到或有歧义
+static int resolve_join_column(const char* name, const Table* left, const char* left_name,
+                               const Table* right, const char* right_name, int* col) {
+    const char* dot = strchr(name, '.');
+    if (dot != NULL) {
+        size_t prefix_len = (size_t)(dot - name);
+        if (strlen(left_name) == prefix_len && strncasecmp(name, left_name, prefix_len) == 0) {
+            *col = get_column_index(left, dot + 1);
+            return (*col != -1) ? 0 : -1;
+        }
+        if (strlen(right_name) == prefix_len && strncasecmp(name, right_name, prefix_len) == 0) {
+            *col = get_column_index(right, dot + 1);
+            return (*col != -1) ? 1 : -1;
+        }
+        return -1;
+    }
+
+    int left_col = get_column_index(left, name);
+    int right_col = get_column_index(right, name);
+    if ((left_col == -1) == (right_col == -1)) {
+        return -1;
+    }
+    *col = (left_col != -1) ? left_col : right_col;
+    return (left_col != -1) ? 0 : 1;
+}
+
+static void init_side(JoinSide* side, const Table* table, int col) {
+    side->table = table;
+    side->col = col;
+    side->column = NULL;
+    if (table->store != NULL) {
+        side->column = &table->store->columns[col];
+    }
+}
+
+static int side_is_null(const JoinSide* side, int row) {
+    if (side->column != NULL) {
+        return side->column->nulls[row];
+    }
+    return side->table->data[row][side->col] == NULL;
+}
+
+static double side_double(const JoinSide* side, int row) {
+    return column_get_double(side->column, row);
+}
+
+static const char* side_text(const JoinSide* side, int row) {
+    const char* cell = side->table->data[row][side->col];
+    return (cell != NULL) ? cell : "";
+}
+
+// 数值相等的浮点数哈希相同 (-0.0与0.0)
+static uint64_t hash_key(const JoinSide* side, JoinKeyMode mode, int row) {
+    if (mode == JOIN_KEY_INT) {
+        return hash_u64((uint64_t)side->column->ints[row]);
+    }
+    if (mode == JOIN_KEY_FLOAT) {
+        double value = side_double(side, row);
+        if (value == 0.0) {
+            value = 0.0;
+        }
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return hash_u64(bits);
+    }
+    return hash_string(side_text(side, row));
+}
+
+static int keys_equal(const JoinSide* a, int row_a, const JoinSide* b, int row_b, JoinKeyMode mode) {
+    if (mode == JOIN_KEY_INT) {
+        return a->column->ints[row_a] == b->column->ints[row_b];
+    }
+    if (mode == JOIN_KEY_FLOAT) {
+        return side_double(a, row_a) == side_double(b, row_b);
+    }
+    return strcmp(side_text(a, row_a), side_text(b, row_b)) == 0;
+}
+
+static int append_pair(JoinPairs* pairs, int left_row, int right_row) {
+    if (pairs->count == pairs->capacity) {
+        int capacity = (pairs->capacity == 0) ? 1024 : pairs->capacity * 2;
+        int* left_rows = realloc(pairs->left_rows, capacity * sizeof(int));
+        if (left_rows == NULL) {
+            return -1;
+        }
+        pairs->left_rows = left_rows;
+        int* right_rows = realloc(pairs->right_rows, capacity * sizeof(int));
+        if (right_rows == NULL) {
+            return -1;
+        }
+        pairs->right_rows = right_rows;
+        pairs->capacity = capacity;
+    }
+    pairs->left_rows[pairs->count] = left_row;
+    pairs->right_rows[pairs->count] = right_row;
+    pairs->count++;
+    return 0;
+}
+
+// 建表 + 探测: 桶里存建表侧的第一行，next把同一桶的行串起来
+static int join_rows(const JoinSide* build, const JoinSide* probe, JoinKeyMode mode, int build_is_left,
+                     JoinPairs* pairs) {
+    int build_count = build->table->row_count;
+    int bucket_count = MIN_JOIN_BUCKETS;
+    while (bucket_count < build_count * 2) {
+        bucket_count *= 2;
+    }
+    int mask = bucket_count - 1;
+
+    int* heads = malloc(bucket_count * sizeof(int));
+    int* next = malloc((build_count > 0 ? build_count : 1) * sizeof(int));
+    uint64_t* hashes = malloc((build_count > 0 ? build_count : 1) * sizeof(uint64_t));
+    if (heads == NULL || next == NULL || hashes == NULL) {
+        free(heads);
+        free(next);
+        free(hashes);
+        return -1;
+    }
+    memset(heads, -1, bucket_count * sizeof(int));
+
+    // 倒序插入，同一个键的行按行号升序串在一起
+    for (int row = build_count - 1; row >= 0; row--) {
+        if (side_is_null(build, row)) {
+            continue;
+        }
+        hashes[row] = hash_key(build, mode, row);
+        int bucket = (int)(hashes[row] & mask);
+        next[row] = heads[bucket];
+        heads[bucket] = row;
+    }
+
+    int status = 0;
+    for (int row = 0; row < probe->table->row_count && status == 0; row++) {
+        if (side_is_null(probe, row)) {
+            continue;
+        }
+        uint64_t hash = hash_key(probe, mode, row);
+        for (int match = heads[hash & mask]; match != -1; match = next[match]) {
+            if (hashes[match] != hash || !keys_equal(build, match, probe, row, mode)) {
+                continue;
+            }
+            status = build_is_left ? append_pair(pairs, match, row) : append_pair(pairs, row, match);
+            if (status != 0) {
+                break;
+            }
+        }
+    }
+
+    free(heads);
+    free(next);
+    free(hashes);
+    return status;
+}
+
+// 结果表是深拷贝: 匹配行的单元格复制进结果表自己的arena，释放结果不影响两张输入表
+// 带前缀的列名 (如 c.id) 放不进MAX_COLUMN_NAME_LEN时返回NULL，不截断，避免两列截成同一个名字
+static Table* build_join_result(const Table* left, const char* left_name, const Table* right,
+                                const char* right_name, const JoinPairs* pairs) {
+    int col_count = left->col_count + right->col_count;
+    char names[MAX_COLUMNS][MAX_COLUMN_NAME_LEN];
+    const char* col_names[MAX_COLUMNS];
+    for (int col = 0; col < col_count; col++) {
+        int from_left = (col < left->col_count);
+        const Table* source = from_left ? left : right;
+        int source_col = from_left ? col : col - left->col_count;
+        int length = snprintf(names[col], MAX_COLUMN_NAME_LEN, "%s.%s", from_left ? left_name : right_name,
+                              source->columns[source_col].name);
+        if (length < 0 || length >= MAX_COLUMN_NAME_LEN) {
+            return NULL;
+        }
+        col_names[col] = names[col];
+    }
+
+    Table* result = create_table("join_result", col_count, col_names);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (int col = 0; col < col_count; col++) {
+        result->columns[col].type = (col < left->col_count) ? left->columns[col].type
+                                                            : right->columns[col - left->col_count].type;
+    }
+
+    // 结果行数已知，行指针数组一次分配
+    if (pairs->count > 0) {
+        result->data = malloc(pairs->count * sizeof(char**));
+        if (result->data == NULL) {
+            free_table(result);
+            return NULL;
+        }
+        result->capacity = pairs->count;
+    }
+
+    const char* row_data[MAX_COLUMNS];
+    for (int i = 0; i < pairs->count; i++) {
+        char** left_row = left->data[pairs->left_rows[i]];
+        char** right_row = right->data[pairs->right_rows[i]];
+        for (int col = 0; col < left->col_count; col++) {
+            row_data[col] = left_row[col];
+        }
+        for (int col = 0; col < right->col_count; col++) {
+            row_data[left->col_count + col] = right_row[col];
+        }
+        if (add_row(result, row_data) != 0) {
+            free_table(result);
+            return NULL;
+        }
+    }
+
+    // 连接结果同样建立列式存储，后续的过滤、分组和排序走类型化路径
+    build_column_store(result);
+    return result;
+}
+
+int plan_hash_join(const Table* left, const char* left_name, const Table* right, const char* right_name,
+                   const char* left_column, const char* right_column, int* left_col, int* right_col,
+                   int* build_is_left) {
+    if (left == NULL || right == NULL || left_name == NULL || right_name == NULL ||
+        left_column == NULL || right_column == NULL) {
+        return -1;
+    }
+    if (left->col_count + right->col_count > MAX_COLUMNS) {
+        return -1;
+    }
+
+    int first_col, second_col;
+    int first_side = resolve_join_column(left_column, left, left_name, right, right_name, &first_col);
+    int second_side = resolve_join_column(right_column, left, left_name, right, right_name, &second_col);
+    if (first_side == -1 || second_side == -1 || first_side == second_side) {
+        return -1;
+    }
+    *left_col = (first_side == 0) ? first_col : second_col;
+    *right_col = (first_side == 1) ? first_col : second_col;
+
+    // 连接键非空的行少的一侧建哈希表 (有统计信息时扣除空值，空值不进哈希表)
+    *build_is_left = (stats_key_rows(left, *left_col) <= stats_key_rows(right, *right_col));
+    return 0;
+}
+
+Table* join_schema(const Table* left, const char* left_name, const Table* right, const char* right_name) {
+    if (left == NULL || right == NULL || left->col_count + right->col_count > MAX_COLUMNS) {
+        return NULL;
+    }
+    JoinPairs pairs = { NULL, NULL, 0, 0 };
+    return build_join_result(left, left_name, right, right_name, &pairs);
+}
+
+Table* hash_join(const Table* left, const char* left_name, const Table* right, const char* right_name,
+                 const char* left_column, const char* right_column) {
+    int left_col, right_col, build_is_left;
+    if (plan_hash_join(left, left_name, right, right_name, left_column, right_column,
+                       &left_col, &right_col, &build_is_left) != 0) {
+        return NULL;
+    }
+
+    JoinSide left_side, right_side;
+    init_side(&left_side, left, left_col);
+    init_side(&right_side, right, right_col);
+
+    JoinKeyMode mode = JOIN_KEY_TEXT;
+    if (left_side.column != NULL && right_side.column != NULL &&
+        column_is_numeric(left_side.column) && column_is_numeric(right_side.column)) {
+        mode = (left_side.column->type == TYPE_INT && right_side.column->type == TYPE_INT) ? JOIN_KEY_INT
+                                                                                          : JOIN_KEY_FLOAT;
+    }
+
+    JoinPairs pairs = { NULL, NULL, 0, 0 };
+    int status = build_is_left ? join_rows(&left_side, &right_side, mode, 1, &pairs)
+                               : join_rows(&right_side, &left_side, mode, 0, &pairs);
+
+    Table* result = (status == 0) ? build_join_result(left, left_name, right, right_name, &pairs) : NULL;
+    free(pairs.left_rows);
+    free(pairs.right_rows);
+    return result;
+}
@@ -0,0 +1,22 @@
+#ifndef JOIN_H
+#define JOIN_H
+
+#include "table.h"
+
+// 内连接 left_column = right_column: 行数较少的一侧 (ANALYZE后按连接键非空的行数) 建哈希表，另一侧逐行探测
+// ON中的列名可以带表名/别名前缀，也可以左右颠倒
+// 结果列为左表在前、右表在后，列名带前缀 (如 c.id)；空值不参与匹配
+// 结果是独立的新表 (单元格复制到结果表的arena中)，由调用者free_table；带前缀的列名放不下时返回NULL
+Table* hash_join(const Table* left, const char* left_name, const Table* right, const char* right_name,
+                 const char* left_column, const char* right_column);
+
+// 解析ON中的两列并决定建哈希表的一侧 (与hash_join的选择相同)，供EXPLAIN使用
+// 成功返回0，*left_col/*right_col为两表的连接列，*build_is_left为1表示左表建哈希表
+int plan_hash_join(const Table* left, const char* left_name, const Table* right, const char* right_name,
+                   const char* left_column, const char* right_column, int* left_col, int* right_col,
+                   int* build_is_left);
+
+// 只有列没有行的连接结果，EXPLAIN不执行连接时用它规划后续算子
+Table* join_schema(const Table* left, const char* left_name, const Table* right, const char* right_name);
+
+#endif // JOIN_H
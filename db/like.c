@@ -0,0 +1,274 @@
+#include "like.h"
+#include <stdlib.h>
+#include <string.h>
+
+// UTF-8字符的字节数: 续字节不完整时截短，非法的首字节按单字节处理
+static int char_length(const char* s) {
+    unsigned char lead = (unsigned char)s[0];
+    int len = 1;
+    if ((lead & 0xE0) == 0xC0) {
+        len = 2;
+    } else if ((lead & 0xF0) == 0xE0) {
+        len = 3;
+    } else if ((lead & 0xF8) == 0xF0) {
+        len = 4;
+    }
+    for (int i = 1; i < len; i++) {
+        if (((unsigned char)s[i] & 0xC0) != 0x80) {
+            return i;
+        }
+    }
+    return len;
+}
+
+// 把一个字符的字节拼成整数，用于比较多字节字符
+static uint32_t char_code(const char* s, int len) {
+    uint32_t code = 0;
+    for (int i = 0; i < len; i++) {
+        code = (code << 8) | (unsigned char)s[i];
+    }
+    return code;
+}
+
+// 只有%的模式: 把%换成'\0'，模式副本就成了各段以'\0'结尾的文字
+static int compile_segments(LikePattern* like) {
+    size_t len = strlen(like->pattern);
+    like->anchored_start = (like->pattern[0] != '%');
+    like->anchored_end = (len == 0 || like->pattern[len - 1] != '%');
+    if (strchr(like->pattern, '%') == NULL) {
+        like->kind = LIKE_EXACT;
+        return 0;
+    }
+
+    like->segments = malloc((len + 1) * sizeof(LikeSegment));
+    if (like->segments == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (like->pattern[i] == '%') {
+            like->pattern[i] = '\0';
+        }
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (like->pattern[i] != '\0' && (i == 0 || like->pattern[i - 1] == '\0')) {
+            like->segments[like->segment_count].text = like->pattern + i;
+            like->segments[like->segment_count].len = strlen(like->pattern + i);
+            like->segment_count++;
+        }
+    }
+
+    if (like->segment_count == 0) {
+        like->kind = LIKE_ANY;
+    } else if (like->segment_count > 1) {
+        like->kind = LIKE_SEGMENTS;
+    } else if (like->anchored_start) {
+        like->kind = LIKE_PREFIX;
+    } else {
+        like->kind = like->anchored_end ? LIKE_SUFFIX : LIKE_CONTAINS;
+    }
+    return 0;
+}
+
+// 含_的模式: 每个非%字符一个状态位，字符能匹配的位置记在掩码里
+static int compile_nfa(LikePattern* like) {
+    like->kind = LIKE_NFA;
+    like->wide_chars = malloc((like->char_count > 0 ? like->char_count : 1) * sizeof(uint32_t));
+    like->wide_positions = malloc((like->char_count > 0 ? like->char_count : 1) * sizeof(int));
+    if (like->wide_chars == NULL || like->wide_positions == NULL) {
+        return -1;
+    }
+
+    int position = 0;
+    for (const char* p = like->pattern; *p != '\0';) {
+        if (*p == '%') {
+            like->gap_mask |= 1ULL << position;
+            p++;
+            continue;
+        }
+        int len = char_length(p);
+        uint64_t bit = 1ULL << position;
+        if (*p == '_') {
+            like->any_mask |= bit;
+        } else if (len == 1 && (unsigned char)*p < 128) {
+            like->ascii_masks[(unsigned char)*p] |= bit;
+        } else {
+            like->wide_chars[like->wide_count] = char_code(p, len);
+            like->wide_positions[like->wide_count] = position;
+            like->wide_count++;
+        }
+        position++;
+        p += len;
+    }
+    return 0;
+}
+
+LikePattern* compile_like(const char* pattern) {
+    if (pattern == NULL) {
+        return NULL;
+    }
+    LikePattern* like = calloc(1, sizeof(LikePattern));
+    if (like == NULL) {
+        return NULL;
+    }
+    size_t len = strlen(pattern);
+    like->pattern = malloc(len + 1);
+    if (like->pattern == NULL) {
+        free_like(like);
+        return NULL;
+    }
+    memcpy(like->pattern, pattern, len + 1);
+
+    int status;
+    if (strchr(pattern, '_') == NULL) {
+        status = compile_segments(like);
+    } else {
+        for (const char* p = pattern; *p != '\0'; p += (*p == '%') ? 1 : char_length(p)) {
+            if (*p != '%') {
+                like->char_count++;
+            }
+        }
+        if (like->char_count <= LIKE_NFA_MAX_CHARS) {
+            status = compile_nfa(like);
+        } else {
+            like->kind = LIKE_BACKTRACK;
+            status = 0;
+        }
+    }
+
+    if (status != 0) {
+        free_like(like);
+        return NULL;
+    }
+    return like;
+}
+
+void free_like(LikePattern* like) {
+    if (like == NULL) {
+        return;
+    }
+    free(like->pattern);
+    free(like->segments);
+    free(like->wide_chars);
+    free(like->wide_positions);
+    free(like);
+}
+
+// 前缀和后缀段固定在两端，中间各段依次取最左边的出现位置 (贪心对只有%的模式是最优的)
+static int match_segments(const LikePattern* like, const char* cell) {
+    const char* pos = cell;
+    const char* end = cell + strlen(cell);
+    int first = 0;
+    int last = like->segment_count;
+
+    if (like->anchored_start) {
+        const LikeSegment* segment = &like->segments[0];
+        if (strncmp(cell, segment->text, segment->len) != 0) {
+            return 0;
+        }
+        pos += segment->len;
+        first = 1;
+    }
+    if (like->anchored_end) {
+        const LikeSegment* segment = &like->segments[last - 1];
+        if ((size_t)(end - pos) < segment->len || memcmp(end - segment->len, segment->text, segment->len) != 0) {
+            return 0;
+        }
+        end -= segment->len;
+        last--;
+    }
+
+    for (int i = first; i < last; i++) {
+        const LikeSegment* segment = &like->segments[i];
+        const char* found = strstr(pos, segment->text);
+        if (found == NULL || found + segment->len > end) {
+            return 0;
+        }
+        pos = found + segment->len;
+    }
+    return 1;
+}
+
+// 位并行NFA: 每读一个字符，活跃状态能匹配它的前进一位，%后的状态保持不变
+static int match_nfa(const LikePattern* like, const char* cell) {
+    uint64_t state = 1;
+    for (const char* s = cell; *s != '\0';) {
+        int len = char_length(s);
+        uint64_t mask = like->any_mask;
+        if (len == 1 && (unsigned char)*s < 128) {
+            mask |= like->ascii_masks[(unsigned char)*s];
+        } else {
+            uint32_t code = char_code(s, len);
+            for (int i = 0; i < like->wide_count; i++) {
+                if (like->wide_chars[i] == code) {
+                    mask |= 1ULL << like->wide_positions[i];
+                }
+            }
+        }
+        state = ((state & mask) << 1) | (state & like->gap_mask);
+        if (state == 0) {
+            return 0;
+        }
+        s += len;
+    }
+    return (state >> like->char_count) & 1;
+}
+
+// 字符太多时的回溯匹配: 失配时退回最近的%，让它多吞一个字符
+static int match_backtrack(const char* pattern, const char* cell) {
+    const char* p = pattern;
+    const char* s = cell;
+    const char* star_p = NULL;
+    const char* star_s = NULL;
+
+    while (*s != '\0') {
+        if (*p == '%') {
+            star_p = ++p;
+            star_s = s;
+            continue;
+        }
+        int s_len = char_length(s);
+        if (*p != '\0') {
+            int p_len = char_length(p);
+            if (*p == '_' || (p_len == s_len && memcmp(p, s, s_len) == 0)) {
+                p += p_len;
+                s += s_len;
+                continue;
+            }
+        }
+        if (star_p == NULL) {
+            return 0;
+        }
+        p = star_p;
+        star_s += char_length(star_s);
+        s = star_s;
+    }
+
+    while (*p == '%') {
+        p++;
+    }
+    return *p == '\0';
+}
+
+int like_matches(const LikePattern* like, const char* cell) {
+    switch (like->kind) {
+        case LIKE_EXACT:
+            return strcmp(cell, like->pattern) == 0;
+        case LIKE_PREFIX:
+            return strncmp(cell, like->segments[0].text, like->segments[0].len) == 0;
+        case LIKE_SUFFIX: {
+            size_t len = strlen(cell);
+            const LikeSegment* segment = &like->segments[0];
+            return len >= segment->len && memcmp(cell + len - segment->len, segment->text, segment->len) == 0;
+        }
+        case LIKE_CONTAINS:
+            return strstr(cell, like->segments[0].text) != NULL;
+        case LIKE_ANY:
+            return 1;
+        case LIKE_SEGMENTS:
+            return match_segments(like, cell);
+        case LIKE_NFA:
+            return match_nfa(like, cell);
+        default:
+            return match_backtrack(like->pattern, cell);
+    }
+}
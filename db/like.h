@@ -0,0 +1,50 @@
+#ifndef LIKE_H
+#define LIKE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LIKE_NFA_MAX_CHARS 63   // 位并行NFA的状态放在一个64位字里: 最多63个非%字符
+
+// LIKE模式编译后的匹配方式: % 匹配任意多个字符，_ 匹配一个字符 (UTF-8按字符计)，区分大小写
+typedef enum {
+    LIKE_EXACT,       // 'abc': 没有通配符，整个值相等
+    LIKE_PREFIX,      // 'abc%'
+    LIKE_SUFFIX,      // '%abc'
+    LIKE_CONTAINS,    // '%abc%'
+    LIKE_ANY,         // '%': 任何非空值
+    LIKE_SEGMENTS,    // 只有%的其他模式，如 'a%b%c'
+    LIKE_NFA,         // 含_的模式
+    LIKE_BACKTRACK    // 含_但字符太多，放不进NFA
+} LikeKind;
+
+// 只有%的模式按%拆成文字段
+typedef struct {
+    const char* text;
+    size_t len;
+} LikeSegment;
+
+typedef struct {
+    LikeKind kind;
+    char* pattern;              // 模式的副本，各段文字指向这里
+    LikeSegment* segments;
+    int segment_count;
+    int anchored_start;         // 模式不以%开头: 第一段必须是前缀
+    int anchored_end;           // 模式不以%结尾: 最后一段必须是后缀
+
+    // LIKE_NFA: 第i位表示已匹配前i个非%字符
+    int char_count;
+    uint64_t ascii_masks[128];  // [ASCII字符] 该字符能匹配的位置
+    uint64_t any_mask;          // _ 的位置
+    uint64_t gap_mask;          // 前面紧跟%的状态，这些状态可以吞掉任意字符
+    uint32_t* wide_chars;       // 多字节字符 (UTF-8字节拼成的编码) 及其位置
+    int* wide_positions;
+    int wide_count;
+} LikePattern;
+
+// 编译模式 (内存不足时返回NULL)；匹配时cell不能为NULL
+LikePattern* compile_like(const char* pattern);
+void free_like(LikePattern* like);
+int like_matches(const LikePattern* like, const char* cell);
+
+#endif // LIKE_H
@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#include <limits.h>
 
 
 
@@ -15,31 +17,31 @@ Operator parse_operator(const char* op_str) {
     if (strcmp(op_str, ">=") == 0) return OP_GREATER_EQUAL;
     if (strcmp(op_str, "<=") == 0) return OP_LESS_EQUAL;
     if (strcmp(op_str, "LIKE") == 0) return OP_LIKE;
+    if (strcmp(op_str, "BETWEEN") == 0) return OP_BETWEEN;
+    if (strcmp(op_str, "IN") == 0) return OP_IN;
     return OP_EQUAL; // 默认
 }
 
+// 语句类型与parse_query的判断一致 (引号外的关键字、长度不限)，无法解析的语句按SELECT处理
 QueryType parse_query_type(const char* sql) {
-    char sql_upper[512];
-    strncpy(sql_upper, sql, sizeof(sql_upper) - 1);
-    sql_upper[sizeof(sql_upper) - 1] = '\0';
-    
-    for (char* p = sql_upper; *p; p++) {
-        *p = toupper(*p);
-    }
-    
-    if (strstr(sql_upper, "SELECT") != NULL) return QUERY_SELECT;
-    if (strstr(sql_upper, "WHERE") != NULL) return QUERY_FILTER;
-    if (strstr(sql_upper, "COUNT") != NULL || strstr(sql_upper, "SUM") != NULL || 
-        strstr(sql_upper, "AVG") != NULL || strstr(sql_upper, "MAX") != NULL || 
-        strstr(sql_upper, "MIN") != NULL) return QUERY_AGGREGATE;
-    if (strstr(sql_upper, "ORDER BY") != NULL) return QUERY_SORT;
-    
-    return QUERY_SELECT; // 默认
+    Query* query = parse_query(sql);
+    if (query == NULL) {
+        return QUERY_SELECT; // 默认
+    }
+    QueryType type = query->type;
+    free_query(query);
+    return type;
 }
 
 void free_condition(Condition* condition) {
     while (condition != NULL) {
         Condition* next = condition->next;
+        for (int i = 0; i < condition->in_count; i++) {
+            free(condition->in_values[i]);
+        }
+        free(condition->in_values);
+        free_condition(condition->left);
+        free_condition(condition->right);
         free(condition);
         condition = next;
     }
@@ -48,46 +50,611 @@ void free_condition(Condition* condition) {
 
 
 
+// WHERE表达式的递归下降解析:
+//   or_expr  := and_expr { OR and_expr }
+//   and_expr := not_expr { AND not_expr }
+//   not_expr := NOT not_expr | '(' or_expr ')' | column op value
+typedef struct {
+    const char* pos;
+} ConditionLexer;
 
-// 定义常量
-Query* parse_query(const char* sql) {
-    if (sql == NULL || strlen(sql) == 0) {
+static void skip_spaces(ConditionLexer* lex) {
+    while (isspace((unsigned char)*lex->pos)) lex->pos++;
+}
+
+// 匹配关键字 (不区分大小写，后面必须是单词边界)
+static int match_keyword(ConditionLexer* lex, const char* keyword) {
+    skip_spaces(lex);
+    size_t len = strlen(keyword);
+    for (size_t i = 0; i < len; i++) {
+        if (toupper((unsigned char)lex->pos[i]) != keyword[i]) {
+            return 0;
+        }
+    }
+    char next = lex->pos[len];
+    if (isalnum((unsigned char)next) || next == '_') {
+        return 0;
+    }
+    lex->pos += len;
+    return 1;
+}
+
+static int match_symbol(ConditionLexer* lex, const char* symbol) {
+    skip_spaces(lex);
+    size_t len = strlen(symbol);
+    if (strncmp(lex->pos, symbol, len) != 0) {
+        return 0;
+    }
+    lex->pos += len;
+    return 1;
+}
+
+static int is_word_end(char c) {
+    return c == '\0' || isspace((unsigned char)c) || strchr("=!<>()',;\"", c) != NULL;
+}
+
+// 读取列名 (可以带表名前缀，如 a.id)
+static int parse_identifier(ConditionLexer* lex, char* out, size_t size) {
+    skip_spaces(lex);
+    size_t len = 0;
+    while (!is_word_end(lex->pos[len])) {
+        len++;
+    }
+    if (len == 0 || len >= size) {
+        return -1;
+    }
+    memcpy(out, lex->pos, len);
+    out[len] = '\0';
+    lex->pos += len;
+    return 0;
+}
+
+// 读取常量: 单/双引号字符串 (两个引号表示一个引号) 或不带引号的单词，保留原始大小写
+static int parse_value(ConditionLexer* lex, char* out, size_t size) {
+    skip_spaces(lex);
+    size_t len = 0;
+    char quote = *lex->pos;
+
+    if (quote == '\'' || quote == '"') {
+        const char* p = lex->pos + 1;
+        while (1) {
+            if (*p == '\0') {
+                return -1;
+            }
+            if (*p == quote) {
+                if (p[1] != quote) {
+                    break;
+                }
+                p++;
+            }
+            if (len + 1 >= size) {
+                return -1;
+            }
+            out[len++] = *p++;
+        }
+        out[len] = '\0';
+        lex->pos = p + 1;
+        return 0;
+    }
+
+    while (lex->pos[len] != '\0' && !isspace((unsigned char)lex->pos[len]) &&
+           strchr("(),;", lex->pos[len]) == NULL) {
+        len++;
+    }
+    if (len == 0 || len >= size) {
+        return -1;
+    }
+    memcpy(out, lex->pos, len);
+    out[len] = '\0';
+    lex->pos += len;
+    return 0;
+}
+
+// IN列表: ( value {, value} )
+static int parse_in_list(ConditionLexer* lex, Condition* cond) {
+    if (!match_symbol(lex, "(")) {
+        return -1;
+    }
+
+    int capacity = 0;
+    do {
+        char value[MAX_CELL_LEN];
+        if (parse_value(lex, value, sizeof(value)) != 0) {
+            return -1;
+        }
+        if (cond->in_count >= capacity) {
+            int new_capacity = (capacity == 0) ? 8 : capacity * 2;
+            char** values = realloc(cond->in_values, new_capacity * sizeof(char*));
+            if (values == NULL) {
+                return -1;
+            }
+            cond->in_values = values;
+            capacity = new_capacity;
+        }
+
+        size_t len = strlen(value) + 1;
+        char* copy = malloc(len);
+        if (copy == NULL) {
+            return -1;
+        }
+        memcpy(copy, value, len);
+        cond->in_values[cond->in_count++] = copy;
+    } while (match_symbol(lex, ","));
+
+    return match_symbol(lex, ")") ? 0 : -1;
+}
+
+static Condition* new_condition(ConditionKind kind, Condition* left, Condition* right) {
+    Condition* cond = calloc(1, sizeof(Condition));
+    if (cond == NULL) {
+        free_condition(left);
+        free_condition(right);
         return NULL;
     }
+    cond->kind = kind;
+    cond->left = left;
+    cond->right = right;
+    return cond;
+}
 
-    Query* query = create_query();
-    if (query == NULL) {
+static Condition* parse_or_expression(ConditionLexer* lex);
+
+// 单个比较: column op value
+static Condition* parse_comparison(ConditionLexer* lex) {
+    Condition* cond = new_condition(COND_COMPARE, NULL, NULL);
+    if (cond == NULL) {
+        return NULL;
+    }
+    if (parse_identifier(lex, cond->column, sizeof(cond->column)) != 0) {
+        free_condition(cond);
         return NULL;
     }
 
-    // 简单的SQL解析实现
-    // 这里只实现基本的SELECT查询解析
-    char sql_copy[1000];
-    strncpy(sql_copy, sql, sizeof(sql_copy) - 1);
-    sql_copy[sizeof(sql_copy) - 1] = '\0';
+    // 先匹配两个字符的操作符
+    int negate = 0;
+    if (match_symbol(lex, "!=") || match_symbol(lex, "<>")) cond->op = OP_NOT_EQUAL;
+    else if (match_symbol(lex, ">=")) cond->op = OP_GREATER_EQUAL;
+    else if (match_symbol(lex, "<=")) cond->op = OP_LESS_EQUAL;
+    else if (match_symbol(lex, "=")) cond->op = OP_EQUAL;
+    else if (match_symbol(lex, ">")) cond->op = OP_GREATER;
+    else if (match_symbol(lex, "<")) cond->op = OP_LESS;
+    else {
+        // [NOT] LIKE / BETWEEN / IN
+        negate = match_keyword(lex, "NOT");
+        if (match_keyword(lex, "LIKE")) cond->op = OP_LIKE;
+        else if (match_keyword(lex, "BETWEEN")) cond->op = OP_BETWEEN;
+        else if (match_keyword(lex, "IN")) cond->op = OP_IN;
+        else {
+            free_condition(cond);
+            return NULL;
+        }
+    }
 
-    // 转换为大写便于解析
-    for (char* p = sql_copy; *p; p++) {
-        *p = toupper(*p);
+    int status;
+    if (cond->op == OP_BETWEEN) {
+        // BETWEEN中的AND属于这个比较，不是逻辑运算
+        status = parse_value(lex, cond->value, sizeof(cond->value));
+        if (status == 0 && !match_keyword(lex, "AND")) {
+            status = -1;
+        }
+        if (status == 0) {
+            status = parse_value(lex, cond->value2, sizeof(cond->value2));
+        }
+    } else if (cond->op == OP_IN) {
+        status = parse_in_list(lex, cond);
+    } else {
+        status = parse_value(lex, cond->value, sizeof(cond->value));
+    }
+
+    if (status != 0) {
+        free_condition(cond);
+        return NULL;
+    }
+    return negate ? new_condition(COND_NOT, cond, NULL) : cond;
+}
+
+static Condition* parse_not_expression(ConditionLexer* lex) {
+    if (match_keyword(lex, "NOT")) {
+        Condition* operand = parse_not_expression(lex);
+        return (operand != NULL) ? new_condition(COND_NOT, operand, NULL) : NULL;
+    }
+
+    if (match_symbol(lex, "(")) {
+        Condition* inner = parse_or_expression(lex);
+        if (inner == NULL || !match_symbol(lex, ")")) {
+            free_condition(inner);
+            return NULL;
+        }
+        return inner;
+    }
+    return parse_comparison(lex);
+}
+
+static Condition* parse_and_expression(ConditionLexer* lex) {
+    Condition* left = parse_not_expression(lex);
+    while (left != NULL && match_keyword(lex, "AND")) {
+        Condition* right = parse_not_expression(lex);
+        if (right == NULL) {
+            free_condition(left);
+            return NULL;
+        }
+        left = new_condition(COND_AND, left, right);
+    }
+    return left;
+}
+
+static Condition* parse_or_expression(ConditionLexer* lex) {
+    Condition* left = parse_and_expression(lex);
+    while (left != NULL && match_keyword(lex, "OR")) {
+        Condition* right = parse_and_expression(lex);
+        if (right == NULL) {
+            free_condition(left);
+            return NULL;
+        }
+        left = new_condition(COND_OR, left, right);
+    }
+    return left;
+}
+
+// 解析完整的WHERE子句，子句必须被完整消耗 (允许结尾的分号)
+static Condition* parse_where_clause(const char* text) {
+    ConditionLexer lex = { text };
+    Condition* root = parse_or_expression(&lex);
+    if (root == NULL) {
+        return NULL;
+    }
+
+    skip_spaces(&lex);
+    while (*lex.pos == ';' || isspace((unsigned char)*lex.pos)) lex.pos++;
+    if (*lex.pos != '\0') {
+        free_condition(root);
+        return NULL;
+    }
+    return root;
+}
+
+
+
+
+
+static int is_word_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '.';
+}
+
+// 在SQL文本中找子句关键字 (不区分大小写，前后是单词边界)，跳过引号中的字符串常量
+// 关键字中的空格匹配任意多个空白，如 "ORDER BY"；找到时返回关键字的开头，rest指向关键字之后
+static char* find_clause(char* text, const char* keyword, char** rest) {
+    char quote = '\0';
+    for (char* p = text; *p != '\0'; p++) {
+        if (quote != '\0') {
+            if (*p == quote) {
+                quote = '\0';   // 两个引号表示一个引号，相当于先关闭再打开
+            }
+            continue;
+        }
+        if (*p == '\'' || *p == '"') {
+            quote = *p;
+            continue;
+        }
+        if (p > text && is_word_char(p[-1])) {
+            continue;
+        }
+
+        char* q = p;
+        const char* k = keyword;
+        while (*k != '\0') {
+            if (*k == ' ') {
+                if (!isspace((unsigned char)*q)) {
+                    break;
+                }
+                while (isspace((unsigned char)*q)) q++;
+                k++;
+            } else if (toupper((unsigned char)*q) == *k) {
+                q++;
+                k++;
+            } else {
+                break;
+            }
+        }
+        if (*k == '\0' && !is_word_char(*q)) {
+            *rest = q;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// 定义常量
+// 表引用: name [[AS] alias]
+static int parse_table_ref(ConditionLexer* lex, char* name, size_t name_size, char* alias, size_t alias_size) {
+    if (parse_identifier(lex, name, name_size) != 0) {
+        return -1;
+    }
+    alias[0] = '\0';
+    if (match_keyword(lex, "AS")) {
+        return parse_identifier(lex, alias, alias_size);
+    }
+
+    // 下一个单词不是关键字时就是别名
+    ConditionLexer saved = *lex;
+    if (match_keyword(lex, "INNER") || match_keyword(lex, "JOIN") || match_keyword(lex, "ON")) {
+        *lex = saved;
+        return 0;
+    }
+    skip_spaces(lex);
+    if (*lex->pos != '\0' && *lex->pos != ';' && parse_identifier(lex, alias, alias_size) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// FROM子句 (保留原始大小写):
+//   table [[AS] alias] [[INNER] JOIN table [[AS] alias] ON column = column]
+static int parse_from_clause(const char* text, Query* query) {
+    ConditionLexer lex = { text };
+    if (parse_table_ref(&lex, query->table_name, sizeof(query->table_name),
+                        query->table_alias, sizeof(query->table_alias)) != 0) {
+        return -1;
+    }
+
+    int inner = match_keyword(&lex, "INNER");
+    if (match_keyword(&lex, "JOIN")) {
+        if (parse_table_ref(&lex, query->join_table, sizeof(query->join_table),
+                            query->join_alias, sizeof(query->join_alias)) != 0 ||
+            !match_keyword(&lex, "ON") ||
+            parse_identifier(&lex, query->join_left, sizeof(query->join_left)) != 0 ||
+            !match_symbol(&lex, "=") ||
+            parse_identifier(&lex, query->join_right, sizeof(query->join_right)) != 0) {
+            return -1;
+        }
+    } else if (inner) {
+        return -1;
+    }
+
+    match_symbol(&lex, ";");
+    skip_spaces(&lex);
+    return (*lex.pos == '\0') ? 0 : -1;
+}
+
+// USING method (HASH/SORTED等)，方法名转成大写；没有USING时返回0
+static int parse_index_method(ConditionLexer* lex, Query* query) {
+    if (!match_keyword(lex, "USING")) {
+        return 0;
+    }
+    if (query->index_method[0] != '\0' ||
+        parse_identifier(lex, query->index_method, sizeof(query->index_method)) != 0) {
+        return -1;
+    }
+    for (char* p = query->index_method; *p; p++) {
+        *p = toupper((unsigned char)*p);
+    }
+    return 0;
+}
+
+// CREATE INDEX name ON table [USING method] (column) [USING method]，CREATE关键字已经读过
+static int parse_create_index(ConditionLexer* lex, Query* query) {
+    if (!match_keyword(lex, "INDEX") ||
+        parse_identifier(lex, query->index_name, sizeof(query->index_name)) != 0 ||
+        !match_keyword(lex, "ON") ||
+        parse_identifier(lex, query->table_name, sizeof(query->table_name)) != 0 ||
+        parse_index_method(lex, query) != 0 ||
+        !match_symbol(lex, "(") ||
+        parse_identifier(lex, query->columns[0], sizeof(query->columns[0])) != 0 ||
+        !match_symbol(lex, ")") ||
+        parse_index_method(lex, query) != 0) {
+        return -1;
+    }
+    query->type = QUERY_CREATE_INDEX;
+    query->column_count = 1;
+
+    match_symbol(lex, ";");
+    skip_spaces(lex);
+    return (*lex->pos == '\0') ? 0 : -1;
+}
+
+// ANALYZE table，ANALYZE关键字已经读过
+static int parse_analyze(ConditionLexer* lex, Query* query) {
+    if (parse_identifier(lex, query->table_name, sizeof(query->table_name)) != 0) {
+        return -1;
+    }
+    query->type = QUERY_ANALYZE;
+
+    match_symbol(lex, ";");
+    skip_spaces(lex);
+    return (*lex->pos == '\0') ? 0 : -1;
+}
+
+// 排序列: 列名，或按聚合结果列排序时的 COUNT(*)、SUM(col) 等 (括号内的空格去掉)
+static int parse_order_column(ConditionLexer* lex, char* out, size_t size) {
+    if (parse_identifier(lex, out, size) != 0) {
+        return -1;
+    }
+    if (*lex->pos != '(') {
+        return 0;
+    }
+    size_t len = strlen(out);
+    while (*lex->pos != ')') {
+        if (*lex->pos == '\0' || len + 2 >= size) {
+            return -1;
+        }
+        if (!isspace((unsigned char)*lex->pos)) {
+            out[len++] = *lex->pos;
+        }
+        lex->pos++;
+    }
+    out[len++] = ')';
+    out[len] = '\0';
+    lex->pos++;
+    return 0;
+}
+
+// ORDER BY列表: column [ASC|DESC] {, column [ASC|DESC]}
+static int parse_order_by(const char* text, Query* query) {
+    ConditionLexer lex = { text };
+    do {
+        if (query->order_by_count >= MAX_COLUMNS) {
+            return -1;
+        }
+        OrderKey* key = &query->order_by[query->order_by_count];
+        if (parse_order_column(&lex, key->column, sizeof(key->column)) != 0) {
+            return -1;
+        }
+        key->direction = match_keyword(&lex, "DESC") ? SORT_DESC : SORT_ASC;
+        if (key->direction == SORT_ASC) {
+            match_keyword(&lex, "ASC");
+        }
+        query->order_by_count++;
+    } while (match_symbol(&lex, ","));
+
+    match_symbol(&lex, ";");
+    skip_spaces(&lex);
+    return (*lex.pos == '\0') ? 0 : -1;
+}
+
+static AggregateType parse_aggregate_type(const char* name) {
+    if (strcmp(name, "COUNT") == 0) return AGG_COUNT;
+    if (strcmp(name, "SUM") == 0) return AGG_SUM;
+    if (strcmp(name, "AVG") == 0) return AGG_AVG;
+    if (strcmp(name, "MAX") == 0) return AGG_MAX;
+    if (strcmp(name, "MIN") == 0) return AGG_MIN;
+    return AGG_NONE;
+}
+
+// 去掉首尾空格，返回新的起始位置
+static char* trim_spaces(char* text) {
+    while (*text == ' ') text++;
+    size_t len = strlen(text);
+    while (len > 0 && text[len - 1] == ' ') {
+        text[--len] = '\0';
+    }
+    return text;
+}
+
+// SELECT列表中的一项: 列名，或 COUNT(*)、SUM(col) 等聚合 (文本已转为大写)
+static int parse_select_item(char* item, Query* query) {
+    int index = query->column_count;
+    AggregateType type = AGG_NONE;
+    char* column = item;
+
+    // 列数或列名超出Query的容量时拒绝，而不是静默截断
+    if (index >= MAX_COLUMNS) {
+        return -1;
+    }
+
+    char* open = strchr(item, '(');
+    if (open != NULL) {
+        char* close = strrchr(item, ')');
+        if (close == NULL || close < open || close[1] != '\0') {
+            return -1;
+        }
+        *open = '\0';
+        *close = '\0';
+        type = parse_aggregate_type(trim_spaces(item));
+        column = trim_spaces(open + 1);
+        if (type == AGG_NONE || column[0] == '\0' || (strcmp(column, "*") == 0 && type != AGG_COUNT)) {
+            return -1;
+        }
+        query->aggregate_count++;
+    }
+    if (strlen(column) >= MAX_COLUMN_NAME_LEN) {
+        return -1;
+    }
+
+    strncpy(query->columns[index], column, MAX_COLUMN_NAME_LEN - 1);
+    query->columns[index][MAX_COLUMN_NAME_LEN - 1] = '\0';
+    query->aggregates[index] = type;
+    query->column_count++;
+    return 0;
+}
+
+// SELECT语句: sql_copy是sql转成大写的副本 (长度相同)，各子句在副本中定位、截断，
+// 需要保留大小写的FROM和WHERE再从原始SQL的相同位置取文本；成功返回0
+static int parse_select(char* sql_copy, const char* sql, Query* query) {
+    // 解析LIMIT子句
+    // 子句关键字在引号外查找，字符串常量中的 ' LIMIT ' 等不会截断语句
+    char* limit_text;
+    char* limit_start = find_clause(sql_copy, "LIMIT", &limit_text);
+    if (limit_start != NULL) {
+        // 行数必须是int范围内的非负整数，超出范围时strtol设置ERANGE
+        char* end;
+        errno = 0;
+        long limit = strtol(limit_text, &end, 10);
+        while (*end == ' ' || *end == ';') end++;
+        if (end == limit_text || *end != '\0' || errno == ERANGE || limit < 0 || limit > INT_MAX) {
+            return -1;
+        }
+        query->limit = (int)limit;
+        *limit_start = '\0';
+    }
+
+    // 解析ORDER BY子句，并把它从后续解析的文本中截掉
+    // 列名从原始SQL的相同位置取，保留大小写 (EXPLAIN中按用户写法显示)
+    char* order_text;
+    char* order_start = find_clause(sql_copy, "ORDER BY", &order_text);
+    if (order_start != NULL) {
+        *order_start = '\0';
+        size_t offset = (size_t)(order_text - sql_copy);
+        size_t length = strlen(order_text);
+        char* order_part = malloc(length + 1);
+        if (order_part == NULL) {
+            return -1;
+        }
+        memcpy(order_part, sql + offset, length);
+        order_part[length] = '\0';
+
+        int order_status = parse_order_by(order_part, query);
+        free(order_part);
+        if (order_status != 0) {
+            return -1;
+        }
+    }
+
+    // 解析GROUP BY子句 (可以有多个分组列)
+    char* group_text;
+    char* group_start = find_clause(sql_copy, "GROUP BY", &group_text);
+    if (group_start != NULL) {
+        // 分组列直接在副本中切分，不再复制到定长缓冲区
+        *group_start = '\0';
+
+        char* semicolon = strchr(group_text, ';');
+        if (semicolon != NULL) {
+            *semicolon = '\0';
+        }
+
+        char* group_col = strtok(group_text, ",");
+        while (group_col != NULL) {
+            group_col = trim_spaces(group_col);
+            if (group_col[0] == '\0' || strlen(group_col) >= MAX_COLUMN_NAME_LEN ||
+                query->group_by_count >= MAX_COLUMNS) {
+                return -1;
+            }
+            strncpy(query->group_by[query->group_by_count], group_col, MAX_COLUMN_NAME_LEN - 1);
+            query->group_by[query->group_by_count][MAX_COLUMN_NAME_LEN - 1] = '\0';
+            query->group_by_count++;
+            group_col = strtok(NULL, ",");
+        }
+        if (query->group_by_count == 0) {
+            return -1;
+        }
     }
 
     // 检测查询类型
-    if (strstr(sql_copy, "SELECT") != NULL) {
+    char* select_text;
+    char* from_text;
+    char* select_start = find_clause(sql_copy, "SELECT", &select_text);
+    if (select_start != NULL) {
         query->type = QUERY_SELECT;
         
         // 简单的列解析
-        char* select_start = strstr(sql_copy, "SELECT");
-        char* from_start = strstr(sql_copy, "FROM");
+        char* from_start = find_clause(select_text, "FROM", &from_text);
         
         if (from_start != NULL) {
-            // 解析列名
-            char columns_part[200];
-            strncpy(columns_part, select_start + 6, from_start - select_start - 6);
-            columns_part[from_start - select_start - 6] = '\0';
+            // 解析列名: 在FROM处截断，列表直接在副本中切分，长度不受限制
+            *from_start = '\0';
             
             // 去除空格
-            char* col_token = strtok(columns_part, ",");
-            while (col_token != NULL && query->column_count < MAX_COLUMNS) {
+            char* col_token = strtok(select_text, ",");
+            while (col_token != NULL) {
                 // 去除前后空格
                 while (*col_token == ' ') col_token++;
                 char* end = col_token + strlen(col_token) - 1;
@@ -98,99 +665,51 @@ Query* parse_query(const char* sql) {
                     // 选择所有列
                     query->column_count = 0; // 特殊标记表示选择所有列
                     break;
-                } else {
-                    strncpy(query->columns[query->column_count], col_token, MAX_COLUMN_NAME_LEN - 1);
-                    query->column_count++;
+                } else if (parse_select_item(col_token, query) != 0) {
+                    return -1;
                 }
                 
                 col_token = strtok(NULL, ",");
             }
-            
-            // 解析表名
-            char* where_start = strstr(from_start, "WHERE");
-            char table_part[500];
-            
-            if (where_start != NULL) {
-                strncpy(table_part, from_start + 4, where_start - from_start - 4);
-            } else {
-                strncpy(table_part, from_start + 4, sizeof(table_part) - 1);
+
+            // 有聚合函数或GROUP BY时走分组聚合
+            if (query->aggregate_count > 0 || query->group_by_count > 0) {
+                query->type = QUERY_AGGREGATE;
             }
-            table_part[sizeof(table_part) - 1] = '\0';
             
-            // 去除空格
-            char* table_name = table_part;
-            while (*table_name == ' ') table_name++;
-            char* table_end = table_name + strlen(table_name) - 1;
-            while (table_end > table_name && *table_end == ' ') table_end--;
-            *(table_end + 1) = '\0';
-            
-            strncpy(query->table_name, table_name, sizeof(query->table_name) - 1);
+            // 解析表名和JOIN: 从原始SQL中取同一段文本，别名保留大小写
+            char* where_text;
+            char* where_start = find_clause(from_text, "WHERE", &where_text);
+            size_t table_offset = (size_t)(from_text - sql_copy);
+            size_t table_len = (where_start != NULL) ? (size_t)(where_start - from_text) : strlen(from_text);
+            char* table_part = malloc(table_len + 1);
+            if (table_part == NULL) {
+                return -1;
+            }
+            memcpy(table_part, sql + table_offset, table_len);
+            table_part[table_len] = '\0';
+
+            int from_status = parse_from_clause(table_part, query);
+            free(table_part);
+            if (from_status != 0) {
+                return -1;
+            }
             
-            // 解析WHERE条件
+            // 解析WHERE条件: 从原始SQL中取同一段文本，字符串常量保留大小写
             if (where_start != NULL) {
-                char* condition_str = where_start + 5;
-                while (*condition_str == ' ') condition_str++;
-                
-                // 简单的条件解析
-                char condition[500];
-                strncpy(condition, condition_str, sizeof(condition) - 1);
-                condition[sizeof(condition) - 1] = '\0';
-                
-                // 检查是否包含AND/OR（当前不支持）
-                if (strstr(condition, " AND ") != NULL || strstr(condition, " OR ") != NULL) {
-                    // 不支持多个条件，返回解析错误
-                    free_query(query);
-                    return NULL;
+                size_t offset = (size_t)(where_text - sql_copy);
+                size_t length = strlen(where_text);
+                char* condition = malloc(length + 1);
+                if (condition == NULL) {
+                    return -1;
                 }
-                
-                // 查找操作符
-                char* op_pos = NULL;
-                char* operators[] = {"=", "!=", ">", "<", ">=", "<=", "LIKE"};
-                Operator ops[] = {OP_EQUAL, OP_NOT_EQUAL, OP_GREATER, OP_LESS, 
-                                 OP_GREATER_EQUAL, OP_LESS_EQUAL, OP_LIKE};
-                
-                for (int i = 0; i < 7; i++) {
-                    op_pos = strstr(condition, operators[i]);
-                    if (op_pos != NULL) {
-                        Condition* cond = malloc(sizeof(Condition));
-                        if (cond != NULL) {
-                            // 提取列名
-                            strncpy(cond->column, condition, op_pos - condition);
-                            cond->column[op_pos - condition] = '\0';
-                            
-                            // 去除列名前后空格
-                            char* col_start = cond->column;
-                            while (*col_start == ' ') col_start++;
-                            char* col_end = col_start + strlen(col_start) - 1;
-                            while (col_end > col_start && *col_end == ' ') col_end--;
-                            *(col_end + 1) = '\0';
-                            if (col_start != cond->column) {
-                                memmove(cond->column, col_start, strlen(col_start) + 1);
-                            }
-                            
-                            // 设置操作符
-                            cond->op = ops[i];
-                            
-                            // 提取值
-                            char* value_start = op_pos + strlen(operators[i]);
-                            while (*value_start == ' ') value_start++;
-                            
-                            // 去除值的前后空格和引号
-                            char* value_end = value_start + strlen(value_start) - 1;
-                            while (value_end > value_start && (*value_end == ' ' || *value_end == '\'' || *value_end == '"')) value_end--;
-                            *(value_end + 1) = '\0';
-                            
-                            if (*value_start == '\'' || *value_start == '"') {
-                                value_start++;
-                            }
-                            
-                            strncpy(cond->value, value_start, MAX_CELL_LEN - 1);
-                            cond->next = NULL;
-                            
-                            query->where_conditions = cond;
-                        }
-                        break;
-                    }
+                memcpy(condition, sql + offset, length);
+                condition[length] = '\0';
+
+                query->where_conditions = parse_where_clause(condition);
+                free(condition);
+                if (query->where_conditions == NULL) {
+                    return -1;
                 }
             }
         }
@@ -198,9 +717,63 @@ Query* parse_query(const char* sql) {
     else 
     {
         // 不支持其他查询类型
+        return -1;
+    }
+
+    return 0;
+}
+
+Query* parse_query(const char* sql) {
+    if (sql == NULL || strlen(sql) == 0) {
+        return NULL;
+    }
+
+    Query* query = create_query();
+    if (query == NULL) {
+        return NULL;
+    }
+
+    // EXPLAIN [ANALYZE] 前缀: 其后必须是SELECT查询
+    ConditionLexer explain_lex = { sql };
+    if (match_keyword(&explain_lex, "EXPLAIN")) {
+        query->explain = match_keyword(&explain_lex, "ANALYZE") ? EXPLAIN_ANALYZE : EXPLAIN_PLAN;
+        skip_spaces(&explain_lex);
+        sql = explain_lex.pos;
+    }
+
+    // CREATE INDEX 和 ANALYZE 语句单独解析 (不能跟在EXPLAIN后面)
+    ConditionLexer create_lex = { sql };
+    int create = match_keyword(&create_lex, "CREATE");
+    int analyze = !create && match_keyword(&create_lex, "ANALYZE");
+    if (create || analyze) {
+        int status = (query->explain != EXPLAIN_NONE) ? -1
+                     : create ? parse_create_index(&create_lex, query) : parse_analyze(&create_lex, query);
+        if (status != 0) {
+            free_query(query);
+            return NULL;
+        }
+        return query;
+    }
+
+    // 简单的SQL解析实现
+    // 这里只实现基本的SELECT查询解析，语句长度不限
+    size_t length = strlen(sql);
+    char* sql_copy = malloc(length + 1);
+    if (sql_copy == NULL) {
         free_query(query);
         return NULL;
     }
 
+    // 转换为大写便于解析
+    for (size_t i = 0; i <= length; i++) {
+        sql_copy[i] = (char)toupper((unsigned char)sql[i]);
+    }
+
+    int status = parse_select(sql_copy, sql, query);
+    free(sql_copy);
+    if (status != 0) {
+        free_query(query);
+        return NULL;
+    }
     return query;
-}
\ No newline at end of file
+}
@@ -0,0 +1,554 @@
+#include "predicate.h"
+#include "column_store.h"
+#include "stats.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static int match_never(const CompiledPredicate* p, const Table* table, int row) {
+    (void)p;
+    (void)table;
+    (void)row;
+    return 0;
+}
+
+// 字符串列: 优先读列式存储的字符串堆
+static const char* string_cell(const CompiledPredicate* p, const Table* table, int row) {
+    if (p->column != NULL) {
+        return column_get_string(p->column, row);
+    }
+    return table->data[row][p->col_index];
+}
+
+#define DEFINE_STRING_MATCH(name, expr)                                        \
+    static int name(const CompiledPredicate* p, const Table* table, int row) { \
+        const char* cell = string_cell(p, table, row);                         \
+        return cell != NULL && (expr);                                         \
+    }
+
+DEFINE_STRING_MATCH(string_eq, strcmp(cell, p->text) == 0)
+DEFINE_STRING_MATCH(string_ne, strcmp(cell, p->text) != 0)
+DEFINE_STRING_MATCH(string_gt, strcmp(cell, p->text) > 0)
+DEFINE_STRING_MATCH(string_lt, strcmp(cell, p->text) < 0)
+DEFINE_STRING_MATCH(string_ge, strcmp(cell, p->text) >= 0)
+DEFINE_STRING_MATCH(string_le, strcmp(cell, p->text) <= 0)
+DEFINE_STRING_MATCH(string_like, like_matches(p->like, cell))
+DEFINE_STRING_MATCH(string_between, strcmp(cell, p->text) >= 0 && strcmp(cell, p->text_high) <= 0)
+DEFINE_STRING_MATCH(string_in, value_set_contains_string(p->set, cell))
+
+// 没有列式存储的数值列: 逐行解析单元格文本
+#define DEFINE_TEXT_NUMERIC_MATCH(name, op)                                    \
+    static int name(const CompiledPredicate* p, const Table* table, int row) { \
+        const char* cell = table->data[row][p->col_index];                     \
+        return cell != NULL && atof(cell) op p->float_value;                   \
+    }
+
+DEFINE_TEXT_NUMERIC_MATCH(text_gt, >)
+DEFINE_TEXT_NUMERIC_MATCH(text_lt, <)
+DEFINE_TEXT_NUMERIC_MATCH(text_ge, >=)
+DEFINE_TEXT_NUMERIC_MATCH(text_le, <=)
+
+static int text_between(const CompiledPredicate* p, const Table* table, int row) {
+    const char* cell = table->data[row][p->col_index];
+    if (cell == NULL) {
+        return 0;
+    }
+    double value = atof(cell);
+    return value >= p->float_value && value <= p->float_high;
+}
+
+// 类型化数值列: 直接读数组；空值在数组中为0，与原来按0比较的行为一致
+#define DEFINE_RANGE_MATCH(name, array, op)                                    \
+    static int name(const CompiledPredicate* p, const Table* table, int row) { \
+        (void)table;                                                           \
+        return (double)p->column->array[row] op p->float_value;                \
+    }
+
+DEFINE_RANGE_MATCH(int_gt, ints, >)
+DEFINE_RANGE_MATCH(int_lt, ints, <)
+DEFINE_RANGE_MATCH(int_ge, ints, >=)
+DEFINE_RANGE_MATCH(int_le, ints, <=)
+DEFINE_RANGE_MATCH(float_gt, floats, >)
+DEFINE_RANGE_MATCH(float_lt, floats, <)
+DEFINE_RANGE_MATCH(float_ge, floats, >=)
+DEFINE_RANGE_MATCH(float_le, floats, <=)
+
+// 等值比较: 空值不等于任何常量
+static int int_eq(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    return !p->column->nulls[row] && p->column->ints[row] == p->int_value;
+}
+
+static int int_ne(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    return p->column->nulls[row] || p->column->ints[row] != p->int_value;
+}
+
+static int float_eq(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    return !p->column->nulls[row] && p->column->floats[row] == p->float_value;
+}
+
+static int float_ne(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    return p->column->nulls[row] || p->column->floats[row] != p->float_value;
+}
+
+static int int_eq_float(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    return !p->column->nulls[row] && (double)p->column->ints[row] == p->float_value;
+}
+
+static int int_ne_float(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    return p->column->nulls[row] || (double)p->column->ints[row] != p->float_value;
+}
+
+// BETWEEN: 一次无符号减法完成两端检查 (要求 low <= high)
+static int int_between(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    return (uint64_t)p->column->ints[row] - (uint64_t)p->int_value <=
+           (uint64_t)p->int_high - (uint64_t)p->int_value;
+}
+
+static int int_between_float(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    double value = (double)p->column->ints[row];
+    return value >= p->float_value && value <= p->float_high;
+}
+
+static int float_between(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    double value = p->column->floats[row];
+    return value >= p->float_value && value <= p->float_high;
+}
+
+static int int_in(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    return !p->column->nulls[row] && value_set_contains_int(p->set, p->column->ints[row]);
+}
+
+static int float_in(const CompiledPredicate* p, const Table* table, int row) {
+    (void)table;
+    return !p->column->nulls[row] && value_set_contains_float(p->set, p->column->floats[row]);
+}
+
+static PredicateFn string_match_fn(Operator op) {
+    switch (op) {
+        case OP_EQUAL:         return string_eq;
+        case OP_NOT_EQUAL:     return string_ne;
+        case OP_GREATER:       return string_gt;
+        case OP_LESS:          return string_lt;
+        case OP_GREATER_EQUAL: return string_ge;
+        case OP_LESS_EQUAL:    return string_le;
+        case OP_LIKE:          return string_like;
+        case OP_BETWEEN:       return string_between;
+        case OP_IN:            return string_in;
+        default:               return match_never;
+    }
+}
+
+// 整数列的BETWEEN: 把两端常量换算成整数边界 [ceil(low), floor(high)]
+static int int_between_bounds(CompiledPredicate* p) {
+    double low = ceil(p->float_value);
+    double high = floor(p->float_high);
+    if (!(low > -9.2e18 && low < 9.2e18 && high > -9.2e18 && high < 9.2e18)) {
+        return 0;
+    }
+    p->int_value = (long long)low;
+    p->int_high = (long long)high;
+    return 1;
+}
+
+static PredicateFn numeric_match_fn(CompiledPredicate* p) {
+    Operator op = p->op;
+
+    if (op == OP_LIKE) {
+        return string_like;
+    }
+    if (op == OP_IN) {
+        if (p->column == NULL) {
+            return string_in;
+        }
+        return (p->column->type == TYPE_INT) ? int_in : float_in;
+    }
+    if (op == OP_BETWEEN) {
+        if (p->float_value > p->float_high) {
+            return match_never;
+        }
+        if (p->column == NULL) {
+            return text_between;
+        }
+        if (p->column->type == TYPE_INT) {
+            if (!int_between_bounds(p)) {
+                return int_between_float;
+            }
+            return (p->int_value <= p->int_high) ? int_between : match_never;
+        }
+        return float_between;
+    }
+    // 等值比较的常量不是数字时，按文本比较
+    if ((op == OP_EQUAL || op == OP_NOT_EQUAL) && (!p->numeric_constant || p->column == NULL)) {
+        return (op == OP_EQUAL) ? string_eq : string_ne;
+    }
+
+    if (p->column == NULL) {
+        switch (op) {
+            case OP_GREATER:       return text_gt;
+            case OP_LESS:          return text_lt;
+            case OP_GREATER_EQUAL: return text_ge;
+            case OP_LESS_EQUAL:    return text_le;
+            default:               return match_never;
+        }
+    }
+
+    if (p->column->type == TYPE_INT) {
+        switch (op) {
+            case OP_EQUAL:         return p->exact_int ? int_eq : int_eq_float;
+            case OP_NOT_EQUAL:     return p->exact_int ? int_ne : int_ne_float;
+            case OP_GREATER:       return int_gt;
+            case OP_LESS:          return int_lt;
+            case OP_GREATER_EQUAL: return int_ge;
+            case OP_LESS_EQUAL:    return int_le;
+            default:               return match_never;
+        }
+    }
+
+    switch (op) {
+        case OP_EQUAL:         return float_eq;
+        case OP_NOT_EQUAL:     return float_ne;
+        case OP_GREATER:       return float_gt;
+        case OP_LESS:          return float_lt;
+        case OP_GREATER_EQUAL: return float_ge;
+        case OP_LESS_EQUAL:    return float_le;
+        default:               return match_never;
+    }
+}
+
+// IN列表编译成哈希集合: 类型化数值列按数值存，其余按原始文本存
+static int build_in_set(CompiledPredicate* p, const Condition* condition) {
+    DataType type = (p->column != NULL && column_is_numeric(p->column)) ? p->column->type : TYPE_STRING;
+    p->set = create_value_set(type, condition->in_count);
+    if (p->set == NULL) {
+        return -1;
+    }
+
+    for (int i = 0; i < condition->in_count; i++) {
+        const char* value = condition->in_values[i];
+        char* end;
+        int status = 0;
+
+        if (type == TYPE_STRING) {
+            status = value_set_add_string(p->set, value);
+        } else if (type == TYPE_INT) {
+            // 整数列只收精确等于某个整数的常量 ('5.0' 视为 5)
+            errno = 0;
+            long long int_value = strtoll(value, &end, 10);
+            if (value[0] != '\0' && *end == '\0' && errno != ERANGE) {
+                status = value_set_add_int(p->set, int_value);
+            } else {
+                double float_value = strtod(value, &end);
+                if (value[0] != '\0' && *end == '\0' && float_value == floor(float_value) &&
+                    float_value > -9.2e18 && float_value < 9.2e18) {
+                    status = value_set_add_int(p->set, (long long)float_value);
+                }
+            }
+        } else {
+            double float_value = strtod(value, &end);
+            if (value[0] != '\0' && *end == '\0') {
+                status = value_set_add_float(p->set, float_value);
+            }
+        }
+
+        if (status != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 编译单个条件: 绑定列号、解析常量、选择比较函数
+int compile_predicate(const Table* table, const Condition* condition, CompiledPredicate* out) {
+    if (table == NULL || condition == NULL || out == NULL) {
+        return -1;
+    }
+
+    memset(out, 0, sizeof(CompiledPredicate));
+    out->op = condition->op;
+    out->text = condition->value;
+    out->match = match_never;
+    out->col_index = get_column_index(table, condition->column);
+    if (out->col_index == -1) {
+        return 0;
+    }
+
+    char* end;
+    // 超出long long范围的整数常量不是精确整数，按double比较，不截成LLONG_MAX
+    errno = 0;
+    out->int_value = strtoll(condition->value, &end, 10);
+    out->exact_int = condition->value[0] != '\0' && *end == '\0' && errno != ERANGE;
+    strtod(condition->value, &end);
+    out->numeric_constant = condition->value[0] != '\0' && *end == '\0';
+    out->float_value = atof(condition->value);
+
+    if (out->op == OP_BETWEEN) {
+        out->text_high = condition->value2;
+        out->float_high = atof(condition->value2);
+    }
+
+    DataType type = table->columns[out->col_index].type;
+    const ColumnVector* column = NULL;
+    if (table->store != NULL) {
+        column = &table->store->columns[out->col_index];
+    }
+
+    if (type == TYPE_INT || type == TYPE_FLOAT) {
+        out->column = column_is_numeric(column) ? column : NULL;
+        out->match = numeric_match_fn(out);
+        // LIKE 和文本比较读取行视图中的原始文本
+        if (out->match == string_like || out->match == string_eq || out->match == string_ne ||
+            out->match == string_in) {
+            out->column = NULL;
+        }
+    } else {
+        out->column = (column != NULL && column->type == TYPE_STRING) ? column : NULL;
+        out->match = string_match_fn(out->op);
+    }
+
+    if (out->op == OP_IN && build_in_set(out, condition) != 0) {
+        out->match = match_never;
+        return -1;
+    }
+    if (out->op == OP_LIKE) {
+        out->like = compile_like(condition->value);
+        if (out->like == NULL) {
+            out->match = match_never;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void free_predicate(CompiledPredicate* predicate) {
+    if (predicate != NULL) {
+        free_value_set(predicate->set);
+        free_like(predicate->like);
+        predicate->set = NULL;
+        predicate->like = NULL;
+    }
+}
+
+// 选择率优先按ANALYZE的统计信息估计 (见stats.h)
+// 没有统计信息时用经验值: 等值选择率低，范围约三分之一；类型化数值比较最便宜
+static void estimate_predicate(const Table* table, FilterNode* node) {
+    const CompiledPredicate* p = &node->predicate;
+
+    if (p->match == match_never) {
+        node->selectivity = 0.0;
+        node->cost = 0.5;
+        return;
+    }
+
+    switch (p->op) {
+        case OP_EQUAL:     node->selectivity = 0.1; break;
+        case OP_NOT_EQUAL: node->selectivity = 0.9; break;
+        case OP_LIKE:      node->selectivity = 0.25; break;
+        case OP_BETWEEN:   node->selectivity = 0.25; break;
+        case OP_IN: {
+            double selectivity = 0.1 * (p->set != NULL ? p->set->count : 1);
+            node->selectivity = (selectivity < 0.9) ? selectivity : 0.9;
+            break;
+        }
+        default:           node->selectivity = 0.33; break;
+    }
+    double selectivity = stats_predicate_selectivity(table, p);
+    if (selectivity >= 0.0) {
+        node->selectivity = selectivity;
+    }
+
+    if (p->op == OP_LIKE) {
+        node->cost = 10.0;
+    } else if (p->op == OP_IN) {
+        node->cost = (p->column != NULL && column_is_numeric(p->column)) ? 2.0 : 5.0;
+    } else if (p->column != NULL && column_is_numeric(p->column)) {
+        node->cost = 1.0;
+    } else if (p->column != NULL) {
+        node->cost = 3.0;
+    } else {
+        node->cost = 6.0;   // 读行视图文本，数值列还要atof
+    }
+}
+
+// AND: 按 cost/(1-s) 升序，先跑便宜且能排除最多行的项
+// OR:  按 cost/s 升序，先跑便宜且最容易命中的项
+static double child_rank(const FilterNode* node, ConditionKind parent) {
+    double miss = (parent == COND_AND) ? 1.0 - node->selectivity : node->selectivity;
+    return node->cost / (miss > 1e-9 ? miss : 1e-9);
+}
+
+// 子节点通常很少，用插入排序 (稳定，相同估计时保持书写顺序)
+static void sort_children(FilterNode* node) {
+    for (int i = 1; i < node->child_count; i++) {
+        FilterNode* item = node->children[i];
+        double rank = child_rank(item, node->kind);
+        int j = i - 1;
+        while (j >= 0 && child_rank(node->children[j], node->kind) > rank) {
+            node->children[j + 1] = node->children[j];
+            j--;
+        }
+        node->children[j + 1] = item;
+    }
+}
+
+// 按顺序短路求值时的期望代价和整体选择率
+static void estimate_children(FilterNode* node) {
+    double reach = 1.0;
+    double cost = 0.0;
+
+    for (int i = 0; i < node->child_count; i++) {
+        const FilterNode* child = node->children[i];
+        cost += reach * child->cost;
+        reach *= (node->kind == COND_AND) ? child->selectivity : 1.0 - child->selectivity;
+    }
+    node->cost = cost;
+    node->selectivity = (node->kind == COND_AND) ? reach : 1.0 - reach;
+}
+
+static int append_child(FilterNode* node, FilterNode* child) {
+    FilterNode** children = realloc(node->children, (node->child_count + 1) * sizeof(FilterNode*));
+    if (children == NULL) {
+        free_filter(child);
+        return -1;
+    }
+    node->children = children;
+    node->children[node->child_count++] = child;
+    return 0;
+}
+
+static FilterNode* compile_node(const Table* table, const Condition* condition);
+
+// 同类的AND/OR子树展平到一个节点下
+static int collect_children(const Table* table, FilterNode* node, const Condition* condition) {
+    if (condition->kind == node->kind) {
+        if (collect_children(table, node, condition->left) != 0) {
+            return -1;
+        }
+        return collect_children(table, node, condition->right);
+    }
+
+    FilterNode* child = compile_node(table, condition);
+    if (child == NULL) {
+        return -1;
+    }
+    return append_child(node, child);
+}
+
+static FilterNode* compile_node(const Table* table, const Condition* condition) {
+    if (condition == NULL) {
+        return NULL;
+    }
+
+    FilterNode* node = calloc(1, sizeof(FilterNode));
+    if (node == NULL) {
+        return NULL;
+    }
+    node->kind = condition->kind;
+
+    switch (condition->kind) {
+        case COND_COMPARE:
+            if (compile_predicate(table, condition, &node->predicate) != 0) {
+                free_filter(node);
+                return NULL;
+            }
+            estimate_predicate(table, node);
+            return node;
+        case COND_NOT: {
+            FilterNode* child = compile_node(table, condition->left);
+            if (child == NULL || append_child(node, child) != 0) {
+                free_filter(node);
+                return NULL;
+            }
+            node->selectivity = 1.0 - child->selectivity;
+            node->cost = child->cost;
+            return node;
+        }
+        default:
+            if (condition->left == NULL || condition->right == NULL ||
+                collect_children(table, node, condition) != 0) {
+                free_filter(node);
+                return NULL;
+            }
+            break;
+    }
+
+    sort_children(node);
+    estimate_children(node);
+    return node;
+}
+
+// 编译WHERE条件: next链上的各个条件之间是AND关系
+FilterNode* compile_filter(const Table* table, const Condition* conditions) {
+    if (table == NULL || conditions == NULL) {
+        return NULL;
+    }
+    if (conditions->next == NULL) {
+        return compile_node(table, conditions);
+    }
+
+    FilterNode* root = calloc(1, sizeof(FilterNode));
+    if (root == NULL) {
+        return NULL;
+    }
+    root->kind = COND_AND;
+    for (const Condition* c = conditions; c != NULL; c = c->next) {
+        FilterNode* child = compile_node(table, c);
+        if (child == NULL || append_child(root, child) != 0) {
+            free_filter(root);
+            return NULL;
+        }
+    }
+
+    sort_children(root);
+    estimate_children(root);
+    return root;
+}
+
+void free_filter(FilterNode* node) {
+    if (node == NULL) {
+        return;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        free_filter(node->children[i]);
+    }
+    free_predicate(&node->predicate);
+    free(node->children);
+    free(node);
+}
+
+// 逐行短路求值
+int filter_matches(const FilterNode* node, const Table* table, int row) {
+    switch (node->kind) {
+        case COND_COMPARE:
+            return predicate_matches(&node->predicate, table, row);
+        case COND_NOT:
+            return !filter_matches(node->children[0], table, row);
+        case COND_AND:
+            for (int i = 0; i < node->child_count; i++) {
+                if (!filter_matches(node->children[i], table, row)) {
+                    return 0;
+                }
+            }
+            return 1;
+        case COND_OR:
+            for (int i = 0; i < node->child_count; i++) {
+                if (filter_matches(node->children[i], table, row)) {
+                    return 1;
+                }
+            }
+            return 0;
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef PREDICATE_H
+#define PREDICATE_H
+
+#include "table.h"
+#include "value_set.h"
+#include "like.h"
+
+typedef struct CompiledPredicate CompiledPredicate;
+typedef int (*PredicateFn)(const CompiledPredicate* predicate, const Table* table, int row);
+
+// 编译后的谓词: 列号和常量在查询开始时解析一次，按 (列类型, 运算符) 选择比较函数
+struct CompiledPredicate {
+    int col_index;
+    Operator op;
+    const ColumnVector* column;   // 类型化列，没有列式存储时为NULL
+    long long int_value;
+    double float_value;
+    int exact_int;                // 常量是否为精确整数
+    int numeric_constant;         // 常量是否整体是合法数字
+    const char* text;             // 原始常量文本 (指向Condition)
+    long long int_high;           // BETWEEN的上界
+    double float_high;
+    const char* text_high;
+    ValueSet* set;                // IN列表编译成的哈希集合
+    LikePattern* like;            // LIKE模式编译成的匹配器
+    PredicateFn match;
+};
+
+// 编译后的WHERE表达式树: AND/OR展平成多叉节点，子节点按估计的代价和选择率排好序
+typedef struct FilterNode {
+    ConditionKind kind;
+    CompiledPredicate predicate;     // COND_COMPARE
+    struct FilterNode** children;    // AND/OR的子节点，NOT只有一个
+    int child_count;
+    double selectivity;              // 估计的满足比例
+    double cost;                     // 估计的每行求值代价
+} FilterNode;
+
+// 谓词编译与求值
+int compile_predicate(const Table* table, const Condition* condition, CompiledPredicate* out);
+void free_predicate(CompiledPredicate* predicate);
+FilterNode* compile_filter(const Table* table, const Condition* conditions);
+void free_filter(FilterNode* node);
+int filter_matches(const FilterNode* node, const Table* table, int row);
+
+static inline int predicate_matches(const CompiledPredicate* predicate, const Table* table, int row) {
+    return predicate->match(predicate, table, row);
+}
+
+#endif // PREDICATE_H
@@ -1,5 +1,9 @@
 #include "result.h"
 #include "parser.h"
+#include "column_store.h"
+#include "snapshot.h"
+#include "index.h"
+#include "stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -61,8 +65,8 @@ void export_result_to_csv(const QueryResult* result, const char* filename) {
     for (int row = 0; row < table->row_count; row++) {
         for (int col = 0; col < table->col_count; col++) {
             if (table->data[row][col] != NULL) {
-                // If contains comma or quote, wrap with quotes
-                if (strchr(table->data[row][col], ',') != NULL || strchr(table->data[row][col], '"') != NULL) {
+                // If contains comma, quote or line break, wrap with quotes
+                if (strpbrk(table->data[row][col], ",\"\r\n") != NULL) {
                     fprintf(file, "\"");
                     // Escape quotes
                     const char* p = table->data[row][col];
@@ -103,33 +107,21 @@ Table* create_table(const char* name, int col_count, const char** col_names) {
     //test1
     table->col_count = col_count;
     table->row_count = 0;
-    table->capacity = INITIAL_CAPACITY;
-
-    // 分配数据存储空间
-    table->data = malloc(table->capacity * sizeof(char**));
-    if (table->data == NULL) {
+    table->capacity = 0;
+    table->store = NULL;
+    table->mapping = NULL;
+    table->mapping_size = 0;
+    table->indexes = NULL;
+    table->stats = NULL;
+
+    // 行数组在第一次add_row时才分配，单元格和行都放在表自己的arena里
+    table->data = NULL;
+    table->arena = arena_create();
+    if (table->arena == NULL) {
         free(table);
         return NULL;
     }
 
-    for (int i = 0; i < table->capacity; i++) {
-        table->data[i] = malloc(col_count * sizeof(char*));
-        if (table->data[i] == NULL) {
-            // 清理已分配的内存
-            for (int j = 0; j < i; j++) {
-                free(table->data[j]);
-            }
-            free(table->data);
-            free(table);
-            return NULL;
-        }
-        
-        // 初始化指针为NULL
-        for (int j = 0; j < col_count; j++) {
-            table->data[i][j] = NULL;
-        }
-    }
-
     // 设置列名
     if (col_names != NULL) {
         for (int i = 0; i < col_count; i++) {
@@ -155,50 +147,57 @@ int add_row(Table* table, const char** row_data) {
         return -1;
     }
 
-    // 检查是否需要扩容
+    int lengths[MAX_COLUMNS];
+    for (int i = 0; i < table->col_count; i++) {
+        lengths[i] = (row_data[i] != NULL) ? (int)strlen(row_data[i]) : 0;
+    }
+    return add_row_len(table, row_data, lengths);
+}
+
+// 按给定长度添加行，单元格不需要以'\0'结尾 (CSV加载器直接传入文件中的字段)
+int add_row_len(Table* table, const char** row_data, const int* lengths) {
+    if (table == NULL || row_data == NULL || lengths == NULL) {
+        return -1;
+    }
+
+    // 检查是否需要扩容 (只扩容行指针数组)
     if (table->row_count >= table->capacity) {
-        int new_capacity = table->capacity * 2;
+        int new_capacity = (table->capacity == 0) ? INITIAL_CAPACITY : table->capacity * 2;
         char*** new_data = realloc(table->data, new_capacity * sizeof(char**));
         if (new_data == NULL) {
             return -1;
         }
         
         table->data = new_data;
-        
-        // 分配新的行空间
-        for (int i = table->capacity; i < new_capacity; i++) {
-            table->data[i] = malloc(table->col_count * sizeof(char*));
-            if (table->data[i] == NULL) {
-                return -1;
-            }
-            
-            // 初始化指针为NULL
-            for (int j = 0; j < table->col_count; j++) {
-                table->data[i][j] = NULL;
-            }
-        }
-        
         table->capacity = new_capacity;
     }
 
+    // 行数组和单元格都从arena分配，失败时已分配的部分随表一起释放
+    char** row = arena_alloc(table->arena, table->col_count * sizeof(char*));
+    if (row == NULL) {
+        return -1;
+    }
+
     // 复制行数据
     for (int i = 0; i < table->col_count; i++) {
         if (row_data[i] != NULL) {
-            table->data[table->row_count][i] = malloc(strlen(row_data[i]) + 1);
-            if (table->data[table->row_count][i] == NULL) {
-                // 清理已分配的内存
-                for (int j = 0; j < i; j++) {
-                    free(table->data[table->row_count][j]);
-                }
+            row[i] = arena_strndup(table->arena, row_data[i], lengths[i]);
+            if (row[i] == NULL) {
                 return -1;
             }
-            strcpy(table->data[table->row_count][i], row_data[i]);
         } else {
-            table->data[table->row_count][i] = NULL;
+            row[i] = NULL;
         }
     }
+    table->data[table->row_count] = row;
     //test3
     table->row_count++;
+
+    // 同步追加到列式存储
+    if (table->store != NULL && column_store_append_row(table, table->row_count - 1) != 0) {
+        free_column_store(table->store);
+        table->store = NULL;
+    }
     return 0;
 }
 
@@ -278,7 +277,21 @@ int get_column_index(const Table* table, const char* column_name) {
         }
     }
 
-    return -1;
+    // 连接结果的列名带表名前缀 (如 c.id)，不带前缀的列名唯一时也能匹配
+    if (strchr(column_name, '.') != NULL) {
+        return -1;
+    }
+    int found = -1;
+    for (int i = 0; i < table->col_count; i++) {
+        const char* dot = strchr(table->columns[i].name, '.');
+        if (dot != NULL && strcasecmp(dot + 1, column_name) == 0) {
+            if (found != -1) {
+                return -1;
+            }
+            found = i;
+        }
+    }
+    return found;
 }
 
 // 查询相关函数的实现
@@ -291,14 +304,20 @@ Query* create_query() {
     // 初始化默认值
     query->type = QUERY_SELECT;
     query->table_name[0] = '\0';
+    query->table_alias[0] = '\0';
+    query->join_table[0] = '\0';
+    query->join_alias[0] = '\0';
+    query->join_left[0] = '\0';
+    query->join_right[0] = '\0';
     query->column_count = 0;
     query->where_conditions = NULL;
-    query->group_by[0] = '\0';
-    query->aggregate = AGG_NONE;
-    query->aggregate_column[0] = '\0';
-    query->order_by[0] = '\0';
-    query->sort_dir = SORT_ASC;
+    query->aggregate_count = 0;
+    query->group_by_count = 0;
+    query->order_by_count = 0;
     query->limit = -1;
+    query->index_name[0] = '\0';
+    query->index_method[0] = '\0';
+    query->explain = EXPLAIN_NONE;
 
     return query;
 }
@@ -351,19 +370,14 @@ void free_table(Table* table) {
         return;
     }
 
-    if (table->data != NULL) {
-        for (int i = 0; i < table->capacity; i++) {
-            if (table->data[i] != NULL) {
-                for (int j = 0; j < table->col_count; j++) {
-                    if (table->data[i][j] != NULL) {
-                        free(table->data[i][j]);
-                    }
-                }
-                free(table->data[i]);
-            }
-        }
-        free(table->data);
+    // 所有行和单元格都属于arena，只需释放少量内存块
+    free(table->data);
+    arena_destroy(table->arena);
+    free_column_store(table->store);
+    free_table_indexes(table);
+    free_table_stats(table);
+    if (table->mapping != NULL) {
+        close_snapshot_mapping(table->mapping, table->mapping_size);
     }
-
     free(table);
 }
\ No newline at end of file
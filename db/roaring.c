@@ -0,0 +1,462 @@
+#include "roaring.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CONTAINER_BITS 16
+#define CONTAINER_SIZE (1 << CONTAINER_BITS)
+
+typedef enum {
+    ROARING_AND,
+    ROARING_OR,
+    ROARING_ANDNOT
+} RoaringOp;
+
+static inline int roaring_popcount(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    while (bits) {
+        bits &= bits - 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// 最低的1位的位置 (bits不为0)
+static inline int roaring_ctz(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int n = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static void free_container(RoaringContainer* container) {
+    free(container->values);
+    free(container->words);
+    container->values = NULL;
+    container->words = NULL;
+}
+
+RoaringBitmap* roaring_create(void) {
+    return calloc(1, sizeof(RoaringBitmap));
+}
+
+void roaring_free(RoaringBitmap* bitmap) {
+    if (bitmap == NULL) {
+        return;
+    }
+    for (int i = 0; i < bitmap->count; i++) {
+        free_container(&bitmap->containers[i]);
+    }
+    free(bitmap->containers);
+    free(bitmap);
+}
+
+// 在末尾追加容器 (key大于已有的容器)，容器的数组归位图所有；空容器直接释放
+static int append_container(RoaringBitmap* bitmap, RoaringContainer* container) {
+    if (container->cardinality == 0) {
+        free_container(container);
+        return 0;
+    }
+    if (bitmap->count == bitmap->capacity) {
+        int capacity = (bitmap->capacity == 0) ? 4 : bitmap->capacity * 2;
+        RoaringContainer* containers = realloc(bitmap->containers, capacity * sizeof(RoaringContainer));
+        if (containers == NULL) {
+            free_container(container);
+            return -1;
+        }
+        bitmap->containers = containers;
+        bitmap->capacity = capacity;
+    }
+    bitmap->containers[bitmap->count++] = *container;
+    return 0;
+}
+
+// 由位图字构造容器 (words归容器所有)，基数小时转成有序数组
+static int container_from_words(RoaringContainer* container, uint16_t key, uint64_t* words) {
+    container->key = key;
+    container->values = NULL;
+    container->words = words;
+    container->cardinality = 0;
+    for (int w = 0; w < ROARING_WORDS; w++) {
+        container->cardinality += roaring_popcount(words[w]);
+    }
+    if (container->cardinality > ROARING_ARRAY_MAX) {
+        return 0;
+    }
+
+    uint16_t* values = malloc((container->cardinality > 0 ? container->cardinality : 1) * sizeof(uint16_t));
+    if (values == NULL) {
+        free_container(container);
+        return -1;
+    }
+    int n = 0;
+    for (int w = 0; w < ROARING_WORDS; w++) {
+        for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+            values[n++] = (uint16_t)(w * 64 + roaring_ctz(word));
+        }
+    }
+    free(words);
+    container->words = NULL;
+    container->values = values;
+    return 0;
+}
+
+// 把容器展开成新分配的位图字
+static uint64_t* container_words(const RoaringContainer* container) {
+    uint64_t* words = malloc(ROARING_WORDS * sizeof(uint64_t));
+    if (words == NULL) {
+        return NULL;
+    }
+    if (container->words != NULL) {
+        memcpy(words, container->words, ROARING_WORDS * sizeof(uint64_t));
+    } else {
+        memset(words, 0, ROARING_WORDS * sizeof(uint64_t));
+        for (int i = 0; i < container->cardinality; i++) {
+            uint16_t value = container->values[i];
+            words[value >> 6] |= 1ULL << (value & 63);
+        }
+    }
+    return words;
+}
+
+static int container_contains(const RoaringContainer* container, uint16_t value) {
+    if (container->words != NULL) {
+        return (int)((container->words[value >> 6] >> (value & 63)) & 1);
+    }
+    int low = 0;
+    int high = container->cardinality - 1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        if (container->values[mid] == value) {
+            return 1;
+        }
+        if (container->values[mid] < value) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return 0;
+}
+
+static int copy_container(RoaringContainer* dst, const RoaringContainer* src) {
+    *dst = *src;
+    dst->values = NULL;
+    dst->words = NULL;
+    if (src->words != NULL) {
+        dst->words = container_words(src);
+        return (dst->words != NULL) ? 0 : -1;
+    }
+    dst->values = malloc(src->cardinality * sizeof(uint16_t));
+    if (dst->values == NULL) {
+        return -1;
+    }
+    memcpy(dst->values, src->values, src->cardinality * sizeof(uint16_t));
+    return 0;
+}
+
+// 交集: 两个位图容器按字求与，否则结果不超过数组一侧的基数
+static int container_and(RoaringContainer* out, const RoaringContainer* a, const RoaringContainer* b) {
+    if (a->words != NULL && b->words != NULL) {
+        uint64_t* words = malloc(ROARING_WORDS * sizeof(uint64_t));
+        if (words == NULL) {
+            return -1;
+        }
+        for (int w = 0; w < ROARING_WORDS; w++) {
+            words[w] = a->words[w] & b->words[w];
+        }
+        return container_from_words(out, a->key, words);
+    }
+
+    const RoaringContainer* array = (a->words == NULL) ? a : b;
+    const RoaringContainer* other = (array == a) ? b : a;
+    uint16_t* values = malloc((array->cardinality > 0 ? array->cardinality : 1) * sizeof(uint16_t));
+    if (values == NULL) {
+        return -1;
+    }
+    int n = 0;
+    if (other->words != NULL) {
+        for (int i = 0; i < array->cardinality; i++) {
+            if (container_contains(other, array->values[i])) {
+                values[n++] = array->values[i];
+            }
+        }
+    } else {
+        int i = 0, j = 0;
+        while (i < array->cardinality && j < other->cardinality) {
+            if (array->values[i] < other->values[j]) {
+                i++;
+            } else if (array->values[i] > other->values[j]) {
+                j++;
+            } else {
+                values[n++] = array->values[i];
+                i++;
+                j++;
+            }
+        }
+    }
+    out->key = a->key;
+    out->cardinality = n;
+    out->values = values;
+    out->words = NULL;
+    return 0;
+}
+
+// 并集: 两个小数组直接归并，否则展开成位图字再按字求或
+static int container_or(RoaringContainer* out, const RoaringContainer* a, const RoaringContainer* b) {
+    if (a->words == NULL && b->words == NULL && a->cardinality + b->cardinality <= ROARING_ARRAY_MAX) {
+        uint16_t* values = malloc((a->cardinality + b->cardinality) * sizeof(uint16_t));
+        if (values == NULL) {
+            return -1;
+        }
+        int i = 0, j = 0, n = 0;
+        while (i < a->cardinality || j < b->cardinality) {
+            if (j >= b->cardinality || (i < a->cardinality && a->values[i] < b->values[j])) {
+                values[n++] = a->values[i++];
+            } else if (i >= a->cardinality || b->values[j] < a->values[i]) {
+                values[n++] = b->values[j++];
+            } else {
+                values[n++] = a->values[i];
+                i++;
+                j++;
+            }
+        }
+        out->key = a->key;
+        out->cardinality = n;
+        out->values = values;
+        out->words = NULL;
+        return 0;
+    }
+
+    uint64_t* words = container_words(a);
+    if (words == NULL) {
+        return -1;
+    }
+    if (b->words != NULL) {
+        for (int w = 0; w < ROARING_WORDS; w++) {
+            words[w] |= b->words[w];
+        }
+    } else {
+        for (int i = 0; i < b->cardinality; i++) {
+            words[b->values[i] >> 6] |= 1ULL << (b->values[i] & 63);
+        }
+    }
+    return container_from_words(out, a->key, words);
+}
+
+// 差集 a \ b
+static int container_andnot(RoaringContainer* out, const RoaringContainer* a, const RoaringContainer* b) {
+    if (a->words != NULL) {
+        uint64_t* words = container_words(a);
+        if (words == NULL) {
+            return -1;
+        }
+        if (b->words != NULL) {
+            for (int w = 0; w < ROARING_WORDS; w++) {
+                words[w] &= ~b->words[w];
+            }
+        } else {
+            for (int i = 0; i < b->cardinality; i++) {
+                words[b->values[i] >> 6] &= ~(1ULL << (b->values[i] & 63));
+            }
+        }
+        return container_from_words(out, a->key, words);
+    }
+
+    uint16_t* values = malloc((a->cardinality > 0 ? a->cardinality : 1) * sizeof(uint16_t));
+    if (values == NULL) {
+        return -1;
+    }
+    int n = 0;
+    for (int i = 0; i < a->cardinality; i++) {
+        if (!container_contains(b, a->values[i])) {
+            values[n++] = a->values[i];
+        }
+    }
+    out->key = a->key;
+    out->cardinality = n;
+    out->values = values;
+    out->words = NULL;
+    return 0;
+}
+
+// 按key归并两个位图的容器，只在一侧出现的容器按运算决定保留或丢弃
+static RoaringBitmap* combine(const RoaringBitmap* a, const RoaringBitmap* b, RoaringOp op) {
+    if (a == NULL || b == NULL) {
+        return NULL;
+    }
+    RoaringBitmap* out = roaring_create();
+    if (out == NULL) {
+        return NULL;
+    }
+
+    int i = 0, j = 0;
+    int status = 0;
+    while ((i < a->count || j < b->count) && status == 0) {
+        RoaringContainer container;
+        if (j >= b->count || (i < a->count && a->containers[i].key < b->containers[j].key)) {
+            if (op == ROARING_AND) {
+                i++;
+                continue;
+            }
+            status = copy_container(&container, &a->containers[i++]);
+        } else if (i >= a->count || b->containers[j].key < a->containers[i].key) {
+            if (op != ROARING_OR) {
+                j++;
+                continue;
+            }
+            status = copy_container(&container, &b->containers[j++]);
+        } else {
+            const RoaringContainer* ca = &a->containers[i++];
+            const RoaringContainer* cb = &b->containers[j++];
+            if (op == ROARING_AND) {
+                status = container_and(&container, ca, cb);
+            } else if (op == ROARING_OR) {
+                status = container_or(&container, ca, cb);
+            } else {
+                status = container_andnot(&container, ca, cb);
+            }
+        }
+        if (status == 0) {
+            status = append_container(out, &container);
+        }
+    }
+
+    if (status != 0) {
+        roaring_free(out);
+        return NULL;
+    }
+    return out;
+}
+
+RoaringBitmap* roaring_and(const RoaringBitmap* a, const RoaringBitmap* b) {
+    return combine(a, b, ROARING_AND);
+}
+
+RoaringBitmap* roaring_or(const RoaringBitmap* a, const RoaringBitmap* b) {
+    return combine(a, b, ROARING_OR);
+}
+
+RoaringBitmap* roaring_andnot(const RoaringBitmap* a, const RoaringBitmap* b) {
+    return combine(a, b, ROARING_ANDNOT);
+}
+
+// 由升序的行号构造位图: 每65536行一个容器
+RoaringBitmap* roaring_from_sorted(const int* rows, int count) {
+    RoaringBitmap* bitmap = roaring_create();
+    if (bitmap == NULL) {
+        return NULL;
+    }
+
+    int start = 0;
+    while (start < count) {
+        uint16_t key = (uint16_t)(rows[start] >> CONTAINER_BITS);
+        int end = start;
+        while (end < count && (rows[end] >> CONTAINER_BITS) == key) {
+            end++;
+        }
+
+        RoaringContainer container;
+        container.key = key;
+        container.cardinality = end - start;
+        container.values = NULL;
+        container.words = NULL;
+        if (container.cardinality <= ROARING_ARRAY_MAX) {
+            container.values = malloc(container.cardinality * sizeof(uint16_t));
+            if (container.values != NULL) {
+                for (int i = start; i < end; i++) {
+                    container.values[i - start] = (uint16_t)(rows[i] & (CONTAINER_SIZE - 1));
+                }
+            }
+        } else {
+            container.words = calloc(ROARING_WORDS, sizeof(uint64_t));
+            if (container.words != NULL) {
+                for (int i = start; i < end; i++) {
+                    int low = rows[i] & (CONTAINER_SIZE - 1);
+                    container.words[low >> 6] |= 1ULL << (low & 63);
+                }
+            }
+        }
+        if ((container.values == NULL && container.words == NULL) || append_container(bitmap, &container) != 0) {
+            roaring_free(bitmap);
+            return NULL;
+        }
+        start = end;
+    }
+    return bitmap;
+}
+
+// 0..count-1 的全部行 (用于NOT的补集)
+RoaringBitmap* roaring_range(int count) {
+    RoaringBitmap* bitmap = roaring_create();
+    if (bitmap == NULL) {
+        return NULL;
+    }
+
+    for (int start = 0; start < count; start += CONTAINER_SIZE) {
+        int n = (count - start < CONTAINER_SIZE) ? count - start : CONTAINER_SIZE;
+        RoaringContainer container;
+        container.key = (uint16_t)(start >> CONTAINER_BITS);
+        container.cardinality = n;
+        container.values = NULL;
+        container.words = NULL;
+        if (n <= ROARING_ARRAY_MAX) {
+            container.values = malloc(n * sizeof(uint16_t));
+            if (container.values != NULL) {
+                for (int i = 0; i < n; i++) {
+                    container.values[i] = (uint16_t)i;
+                }
+            }
+        } else {
+            container.words = calloc(ROARING_WORDS, sizeof(uint64_t));
+            if (container.words != NULL) {
+                memset(container.words, 0xFF, (n / 64) * sizeof(uint64_t));
+                if (n % 64 != 0) {
+                    container.words[n / 64] = (1ULL << (n % 64)) - 1;
+                }
+            }
+        }
+        if ((container.values == NULL && container.words == NULL) || append_container(bitmap, &container) != 0) {
+            roaring_free(bitmap);
+            return NULL;
+        }
+    }
+    return bitmap;
+}
+
+int roaring_cardinality(const RoaringBitmap* bitmap) {
+    int count = 0;
+    for (int i = 0; i < bitmap->count; i++) {
+        count += bitmap->containers[i].cardinality;
+    }
+    return count;
+}
+
+int roaring_to_array(const RoaringBitmap* bitmap, int* out) {
+    int n = 0;
+    for (int i = 0; i < bitmap->count; i++) {
+        const RoaringContainer* container = &bitmap->containers[i];
+        int base = (int)container->key << CONTAINER_BITS;
+        if (container->words != NULL) {
+            for (int w = 0; w < ROARING_WORDS; w++) {
+                for (uint64_t word = container->words[w]; word != 0; word &= word - 1) {
+                    out[n++] = base + w * 64 + roaring_ctz(word);
+                }
+            }
+        } else {
+            for (int v = 0; v < container->cardinality; v++) {
+                out[n++] = base + container->values[v];
+            }
+        }
+    }
+    return n;
+}
@@ -0,0 +1,39 @@
+#ifndef ROARING_H
+#define ROARING_H
+
+#include <stdint.h>
+
+#define ROARING_ARRAY_MAX 4096   // 基数不超过它的容器存成有序数组，否则存成65536位的位图
+#define ROARING_WORDS 1024       // 位图容器的64位字数
+
+// 容器: 行号高16位相同的一组行，低16位存成有序数组或位图
+typedef struct {
+    uint16_t key;
+    int cardinality;
+    uint16_t* values;   // 数组容器，位图容器时为NULL
+    uint64_t* words;    // 位图容器，数组容器时为NULL
+} RoaringContainer;
+
+// Roaring风格的压缩位图: 容器按key升序排列，空容器不保存
+typedef struct {
+    RoaringContainer* containers;
+    int count;
+    int capacity;
+} RoaringBitmap;
+
+// 位图操作函数 (返回新位图，内存不足时返回NULL)
+RoaringBitmap* roaring_create(void);
+void roaring_free(RoaringBitmap* bitmap);
+RoaringBitmap* roaring_from_sorted(const int* rows, int count);
+RoaringBitmap* roaring_range(int count);
+RoaringBitmap* roaring_and(const RoaringBitmap* a, const RoaringBitmap* b);
+RoaringBitmap* roaring_or(const RoaringBitmap* a, const RoaringBitmap* b);
+RoaringBitmap* roaring_andnot(const RoaringBitmap* a, const RoaringBitmap* b);
+
+// 基数: 各容器的计数之和 (位图容器的计数由popcount得到)
+int roaring_cardinality(const RoaringBitmap* bitmap);
+
+// 按升序写出所有行号，返回个数
+int roaring_to_array(const RoaringBitmap* bitmap, int* out);
+
+#endif // ROARING_H
@@ -0,0 +1,474 @@
+/* Activate POSIX capabilities for mmap */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "snapshot.h"
+#include "csv_loader.h"
+#include "column_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#define SNAPSHOT_MAGIC "MDBSNAP1"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_PAGE_SIZE 4096
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+#define SNAPSHOT_SUFFIX ".snap"
+
+// 每列在文件中的各段 (偏移都是相对文件开头的字节数)
+typedef struct {
+    uint64_t nulls;          // row_count 字节的空值标记
+    uint64_t values;         // 数值列: int64/double 数组
+    uint64_t text_offsets;   // uint64 数组: 每行文本在文本堆中的偏移
+    uint64_t text_heap;      // 以'\0'结尾的单元格文本
+    uint64_t text_size;
+} SnapshotSection;
+
+// 源CSV的文件状态: 与快照记录的完全一致时快照才可用
+// 修改时间精确到纳秒，同一秒内改写且大小不变的文件也能识别；换成另一个文件时inode和ctime会变
+typedef struct {
+    int64_t size;
+    int64_t mtime;
+    int64_t mtime_nsec;
+    int64_t ctime;
+    int64_t ctime_nsec;
+    uint64_t inode;
+} SourceStat;
+
+// 文件头: 表结构 + 行数 + 源CSV的文件状态 (用于判断快照是否过期)
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t column_size;
+    int32_t col_count;
+    int64_t row_count;
+    SourceStat source;
+    uint64_t file_size;
+    char table_name[100];
+    Column columns[MAX_COLUMNS];
+    SnapshotSection sections[MAX_COLUMNS];
+} SnapshotHeader;
+
+static int write_bytes(FILE* file, const void* data, size_t size, uint64_t* pos) {
+    if (size > 0 && fwrite(data, 1, size, file) != size) {
+        return -1;
+    }
+    *pos += size;
+    return 0;
+}
+
+// 补零到下一页边界，保证每一段都按页对齐
+static int pad_to_page(FILE* file, uint64_t* pos) {
+    static const char zeros[SNAPSHOT_PAGE_SIZE];
+    size_t padding = (size_t)((SNAPSHOT_PAGE_SIZE - *pos % SNAPSHOT_PAGE_SIZE) % SNAPSHOT_PAGE_SIZE);
+    return write_bytes(file, zeros, padding, pos);
+}
+
+static int get_source_stat(const char* source_csv, SourceStat* source) {
+    struct stat st;
+    memset(source, 0, sizeof(SourceStat));
+    if (source_csv == NULL || stat(source_csv, &st) != 0) {
+        return -1;
+    }
+    source->size = (int64_t)st.st_size;
+    source->mtime = (int64_t)st.st_mtime;
+    source->ctime = (int64_t)st.st_ctime;
+    source->inode = (uint64_t)st.st_ino;
+#ifndef _WIN32
+    source->mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+    source->ctime_nsec = (int64_t)st.st_ctim.tv_nsec;
+#endif
+    return 0;
+}
+
+// 数值列的原始文本也写入快照，打开时行视图直接指向映射中的文本
+static int write_numeric_text(FILE* file, const Table* table, int col, SnapshotSection* section, uint64_t* pos) {
+    int rows = table->row_count;
+    uint64_t* offsets = malloc((rows > 0 ? rows : 1) * sizeof(uint64_t));
+    if (offsets == NULL) {
+        return -1;
+    }
+
+    section->text_heap = *pos;
+    uint64_t heap_size = 0;
+    for (int row = 0; row < rows; row++) {
+        const char* cell = table->data[row][col];
+        if (cell == NULL) {
+            cell = "";
+        }
+        size_t len = strlen(cell) + 1;
+        offsets[row] = heap_size;
+        heap_size += len;
+        if (write_bytes(file, cell, len, pos) != 0) {
+            free(offsets);
+            return -1;
+        }
+    }
+    section->text_size = heap_size;
+
+    int status = pad_to_page(file, pos);
+    section->text_offsets = *pos;
+    if (status == 0) {
+        status = write_bytes(file, offsets, rows * sizeof(uint64_t), pos);
+    }
+    free(offsets);
+    return status;
+}
+
+static int write_column(FILE* file, const Table* table, int col, SnapshotSection* section, uint64_t* pos) {
+    const ColumnVector* column = &table->store->columns[col];
+    int rows = table->row_count;
+
+    section->nulls = *pos;
+    if (write_bytes(file, column->nulls, rows, pos) != 0 || pad_to_page(file, pos) != 0) {
+        return -1;
+    }
+
+    if (column->type == TYPE_INT || column->type == TYPE_FLOAT) {
+        const void* values = (column->type == TYPE_INT) ? (const void*)column->ints : (const void*)column->floats;
+        section->values = *pos;
+        if (write_bytes(file, values, rows * sizeof(int64_t), pos) != 0 || pad_to_page(file, pos) != 0) {
+            return -1;
+        }
+        if (write_numeric_text(file, table, col, section, pos) != 0) {
+            return -1;
+        }
+    } else {
+        // 字符串列的字符串堆同时就是行视图的文本
+        section->text_heap = *pos;
+        section->text_size = column->heap_size;
+        if (write_bytes(file, column->heap, column->heap_size, pos) != 0 || pad_to_page(file, pos) != 0) {
+            return -1;
+        }
+        section->text_offsets = *pos;
+        if (write_bytes(file, column->offsets, rows * sizeof(uint64_t), pos) != 0) {
+            return -1;
+        }
+    }
+    return pad_to_page(file, pos);
+}
+
+// 保存快照: 先写临时文件，完成后再改名，避免留下半个快照
+int save_table_snapshot(const Table* table, const char* path, const char* source_csv) {
+    if (table == NULL || table->store == NULL || path == NULL || sizeof(size_t) != sizeof(uint64_t)) {
+        return -1;
+    }
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.column_size = sizeof(Column);
+    header.col_count = table->col_count;
+    header.row_count = table->row_count;
+    strncpy(header.table_name, table->name, sizeof(header.table_name) - 1);
+    memcpy(header.columns, table->columns, sizeof(header.columns));
+    get_source_stat(source_csv, &header.source);
+
+    uint64_t pos = 0;
+    int status = write_bytes(file, &header, sizeof(header), &pos);
+    if (status == 0) {
+        status = pad_to_page(file, &pos);
+    }
+    for (int col = 0; col < table->col_count && status == 0; col++) {
+        status = write_column(file, table, col, &header.sections[col], &pos);
+    }
+
+    // 回到开头写入完整的文件头
+    header.file_size = pos;
+    if (status == 0 && (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1)) {
+        status = -1;
+    }
+    if (fclose(file) != 0) {
+        status = -1;
+    }
+
+    if (status != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+
+    remove(path);
+    if (rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+static void* map_snapshot_file(const char* path, size_t* size) {
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    // 私有映射: 行视图可以写单元格而不会改动快照文件
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    *size = (size_t)st.st_size;
+    return data;
+#else
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (file_size <= 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    char* data = malloc(file_size);
+    if (data == NULL || fread(data, 1, file_size, file) != (size_t)file_size) {
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *size = (size_t)file_size;
+    return data;
+#endif
+}
+
+void close_snapshot_mapping(void* mapping, size_t size) {
+    if (mapping == NULL) {
+        return;
+    }
+#ifndef _WIN32
+    munmap(mapping, size);
+#else
+    (void)size;
+    free(mapping);
+#endif
+}
+
+static int range_ok(uint64_t offset, uint64_t length, size_t file_size) {
+    return offset <= file_size && length <= file_size - offset;
+}
+
+static int validate_header(const SnapshotHeader* header, size_t file_size) {
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SNAPSHOT_VERSION ||
+        header->byte_order != SNAPSHOT_BYTE_ORDER ||
+        header->column_size != sizeof(Column) ||
+        header->file_size != file_size ||
+        header->col_count <= 0 || header->col_count > MAX_COLUMNS ||
+        header->row_count < 0 || header->row_count > INT_MAX) {
+        return -1;
+    }
+
+    uint64_t rows = (uint64_t)header->row_count;
+    for (int col = 0; col < header->col_count; col++) {
+        const SnapshotSection* section = &header->sections[col];
+        DataType type = header->columns[col].type;
+
+        if (!range_ok(section->nulls, rows, file_size) ||
+            !range_ok(section->text_offsets, rows * sizeof(uint64_t), file_size) ||
+            !range_ok(section->text_heap, section->text_size, file_size)) {
+            return -1;
+        }
+        if ((type == TYPE_INT || type == TYPE_FLOAT) &&
+            !range_ok(section->values, rows * sizeof(int64_t), file_size)) {
+            return -1;
+        }
+        if (section->text_size > 0 && ((const char*)header)[section->text_heap + section->text_size - 1] != '\0') {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 打开快照: 一次映射，列数组直接指向映射内容，行视图只做指针修正，不解析任何文本
+Table* open_table_snapshot(const char* path) {
+    if (path == NULL || sizeof(size_t) != sizeof(uint64_t)) {
+        return NULL;
+    }
+
+    size_t size = 0;
+    char* base = map_snapshot_file(path, &size);
+    if (base == NULL) {
+        return NULL;
+    }
+
+    const SnapshotHeader* header = (const SnapshotHeader*)base;
+    if (size < sizeof(SnapshotHeader) || validate_header(header, size) != 0) {
+        close_snapshot_mapping(base, size);
+        return NULL;
+    }
+
+    int rows = (int)header->row_count;
+    int col_count = header->col_count;
+    const char* col_names[MAX_COLUMNS];
+    for (int col = 0; col < col_count; col++) {
+        col_names[col] = header->columns[col].name;
+    }
+
+    Table* table = create_table(header->table_name, col_count, col_names);
+    ColumnStore* store = calloc(1, sizeof(ColumnStore));
+    char*** data = malloc((rows > 0 ? rows : 1) * sizeof(char**));
+    if (table == NULL || store == NULL || data == NULL) {
+        free(store);
+        free(data);
+        free_table(table);
+        close_snapshot_mapping(base, size);
+        return NULL;
+    }
+
+    table->store = store;
+    table->data = data;
+    table->capacity = (rows > 0) ? rows : 1;
+    table->mapping = base;
+    table->mapping_size = size;
+    store->mapped = 1;
+    store->row_count = rows;
+    store->capacity = rows;
+
+    for (int col = 0; col < col_count; col++) {
+        const SnapshotSection* section = &header->sections[col];
+        ColumnVector* column = &store->columns[col];
+
+        table->columns[col].type = header->columns[col].type;
+        column->type = header->columns[col].type;
+        column->nulls = (unsigned char*)(base + section->nulls);
+        if (column->type == TYPE_INT) {
+            column->ints = (long long*)(base + section->values);
+        } else if (column->type == TYPE_FLOAT) {
+            column->floats = (double*)(base + section->values);
+        } else {
+            column->offsets = (size_t*)(base + section->text_offsets);
+            column->heap = base + section->text_heap;
+            column->heap_size = section->text_size;
+            column->heap_capacity = section->text_size;
+        }
+    }
+    if (build_zone_maps(store, col_count) != 0) {
+        free_table(table);
+        return NULL;
+    }
+
+    // 行视图: 每个单元格指向映射中的文本
+    for (int row = 0; row < rows; row++) {
+        char** cells = arena_alloc(table->arena, col_count * sizeof(char*));
+        if (cells == NULL) {
+            free_table(table);
+            return NULL;
+        }
+
+        for (int col = 0; col < col_count; col++) {
+            const SnapshotSection* section = &header->sections[col];
+            const uint64_t* offsets = (const uint64_t*)(base + section->text_offsets);
+
+            if (store->columns[col].type == TYPE_STRING && store->columns[col].nulls[row]) {
+                cells[col] = NULL;
+            } else if (offsets[row] < section->text_size) {
+                cells[col] = base + section->text_heap + offsets[row];
+            } else {
+                free_table(table);
+                return NULL;
+            }
+        }
+        table->data[row] = cells;
+        table->row_count++;
+    }
+
+    return table;
+}
+
+// 快照记录的源文件状态与当前CSV一致时才可用
+int snapshot_is_fresh(const char* snapshot_path, const char* source_csv) {
+    SourceStat source;
+    if (get_source_stat(source_csv, &source) != 0) {
+        return 0;
+    }
+
+    FILE* file = fopen(snapshot_path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    SnapshotHeader header;
+    int ok = fread(&header, sizeof(header), 1, file) == 1;
+    fclose(file);
+
+    return ok &&
+           memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+           header.version == SNAPSHOT_VERSION &&
+           memcmp(&header.source, &source, sizeof(SourceStat)) == 0;
+}
+
+// 快照放在缓存目录 (环境变量SNAPSHOT_DIR_ENV) 下，文件名由CSV路径把分隔符换成'_'得到
+// 没有配置缓存目录或路径太长时返回-1
+static int snapshot_path_for(const char* csv_path, char* out, size_t size) {
+    const char* dir = getenv(SNAPSHOT_DIR_ENV);
+    if (dir == NULL || dir[0] == '\0') {
+        return -1;
+    }
+
+    size_t len = (size_t)snprintf(out, size, "%s/", dir);
+    for (const char* p = csv_path; *p != '\0' && len < size; p++) {
+        out[len++] = (*p == '/' || *p == '\\' || *p == ':') ? '_' : *p;
+    }
+    if (len + strlen(SNAPSHOT_SUFFIX) >= size) {
+        return -1;
+    }
+    strcpy(out + len, SNAPSHOT_SUFFIX);
+    return 0;
+}
+
+// 加载CSV: 配置了缓存目录时先找新鲜的快照直接映射，否则解析CSV并尽量写出快照供下次使用
+// (目录不可写时不写快照，也不报错)
+Table* load_csv_cached(const char* csv_path) {
+    if (csv_path == NULL) {
+        return NULL;
+    }
+
+    char snapshot_path[512];
+    if (snapshot_path_for(csv_path, snapshot_path, sizeof(snapshot_path)) != 0) {
+        return load_csv(csv_path);
+    }
+
+    if (snapshot_is_fresh(snapshot_path, csv_path)) {
+        Table* table = open_table_snapshot(snapshot_path);
+        if (table != NULL) {
+            printf("Loaded snapshot %s (%d rows)\n", snapshot_path, table->row_count);
+            return table;
+        }
+    }
+
+    Table* table = load_csv(csv_path);
+    if (table != NULL) {
+        save_table_snapshot(table, snapshot_path, csv_path);
+    }
+    return table;
+}
@@ -0,0 +1,16 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "table.h"
+
+// 快照缓存目录的环境变量，没有设置时load_csv_cached不读写快照
+#define SNAPSHOT_DIR_ENV "MINIDB_SNAPSHOT_DIR"
+
+// 二进制列式快照: 列优先、按类型存储、各段按页对齐，打开时只需一次mmap
+int save_table_snapshot(const Table* table, const char* path, const char* source_csv);
+Table* open_table_snapshot(const char* path);
+int snapshot_is_fresh(const char* snapshot_path, const char* source_csv);
+Table* load_csv_cached(const char* csv_path);
+void close_snapshot_mapping(void* mapping, size_t size);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,380 @@
+#include "sort.h"
+#include "column_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INSERTION_SORT_THRESHOLD 16
+#define TOP_N_BATCH 1024
+#define SIGN_BIT 0x8000000000000000ULL
+
+// double -> 保序的无符号整数 (负数取反，正数置符号位)
+uint64_t sort_key_double(double value) {
+    uint64_t bits;
+    if (value == 0.0) {
+        value = 0.0;  // -0.0 与 0.0 视为相等
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & SIGN_BIT) ? ~bits : (bits | SIGN_BIT);
+}
+
+uint64_t sort_key_int(long long value) {
+    return (uint64_t)value ^ SIGN_BIT;
+}
+
+// 字符串前8字节按大端拼成整数，整数比较结果与strcmp前缀一致
+static uint64_t string_prefix(const char* str) {
+    uint64_t key = 0;
+    int i = 0;
+    for (; i < 8 && str[i] != '\0'; i++) {
+        key = (key << 8) | (unsigned char)str[i];
+    }
+    return key << (8 * (8 - i));
+}
+
+static int is_numeric_column(const Table* table, int col_index) {
+    DataType type = table->columns[col_index].type;
+    return type == TYPE_INT || type == TYPE_FLOAT;
+}
+
+// 为每一行预先计算排序键，之后的比较不再解析数字
+int build_sort_entries(const Table* table, int col_index, SortDirection direction,
+                       const int* rows, int count, SortEntry* entries) {
+    if (table == NULL || col_index < 0 || col_index >= table->col_count) {
+        return -1;
+    }
+
+    const ColumnVector* column = NULL;
+    if (table->store != NULL && column_is_numeric(&table->store->columns[col_index])) {
+        column = &table->store->columns[col_index];
+    }
+    int numeric = is_numeric_column(table, col_index);
+
+    for (int i = 0; i < count; i++) {
+        int row = rows[i];
+        entries[i].row = row;
+        entries[i].str = NULL;
+
+        if (column != NULL && column->type == TYPE_INT) {
+            entries[i].key = sort_key_int(column->ints[row]);
+        } else if (column != NULL) {
+            entries[i].key = sort_key_double(column->floats[row]);
+        } else {
+            const char* value = table->data[row][col_index];
+            if (value == NULL) {
+                value = "";
+            }
+            if (numeric) {
+                entries[i].key = sort_key_double(atof(value));
+            } else {
+                entries[i].key = string_prefix(value);
+                entries[i].str = value;
+            }
+        }
+
+        // 数值降序直接取反键值，保持相等元素的原始顺序
+        if (numeric && direction == SORT_DESC) {
+            entries[i].key = ~entries[i].key;
+        }
+    }
+    return 0;
+}
+
+// 比较两个排序项 (数值键已包含方向，字符串在这里处理方向)
+int compare_sort_entries(const SortEntry* a, const SortEntry* b, SortDirection direction) {
+    int cmp;
+    if (a->key != b->key) {
+        cmp = (a->key < b->key) ? -1 : 1;
+    } else if (a->str != NULL && b->str != NULL) {
+        cmp = strcmp(a->str, b->str);
+    } else {
+        return 0;
+    }
+
+    if (a->str != NULL && direction == SORT_DESC) {
+        cmp = -cmp;
+    }
+    return cmp;
+}
+
+// LSD基数排序，每趟8位，所有键在某字节上相同则跳过该趟
+static int radix_sort_entries(SortEntry* entries, int count) {
+    SortEntry* buffer = malloc(count * sizeof(SortEntry));
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    SortEntry* src = entries;
+    SortEntry* dst = buffer;
+    for (int shift = 0; shift < 64; shift += 8) {
+        int histogram[256] = {0};
+        for (int i = 0; i < count; i++) {
+            histogram[(src[i].key >> shift) & 0xFF]++;
+        }
+        if (histogram[(src[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        int offset = 0;
+        for (int b = 0; b < 256; b++) {
+            int n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+        for (int i = 0; i < count; i++) {
+            dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+
+        SortEntry* temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    if (src != entries) {
+        memcpy(entries, src, count * sizeof(SortEntry));
+    }
+    free(buffer);
+    return 0;
+}
+
+// 稳定的自底向上归并排序，小段先用插入排序
+static int merge_sort_entries(SortEntry* entries, int count, SortDirection direction) {
+    for (int start = 0; start < count; start += INSERTION_SORT_THRESHOLD) {
+        int end = start + INSERTION_SORT_THRESHOLD;
+        if (end > count) {
+            end = count;
+        }
+        for (int i = start + 1; i < end; i++) {
+            SortEntry item = entries[i];
+            int j = i - 1;
+            while (j >= start && compare_sort_entries(&entries[j], &item, direction) > 0) {
+                entries[j + 1] = entries[j];
+                j--;
+            }
+            entries[j + 1] = item;
+        }
+    }
+    if (count <= INSERTION_SORT_THRESHOLD) {
+        return 0;
+    }
+
+    SortEntry* buffer = malloc(count * sizeof(SortEntry));
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    SortEntry* src = entries;
+    SortEntry* dst = buffer;
+    for (int width = INSERTION_SORT_THRESHOLD; width < count; width *= 2) {
+        for (int left = 0; left < count; left += 2 * width) {
+            int mid = (left + width < count) ? left + width : count;
+            int right = (left + 2 * width < count) ? left + 2 * width : count;
+            int i = left, j = mid, k = left;
+
+            while (i < mid && j < right) {
+                if (compare_sort_entries(&src[j], &src[i], direction) < 0) {
+                    dst[k++] = src[j++];
+                } else {
+                    dst[k++] = src[i++];
+                }
+            }
+            while (i < mid) dst[k++] = src[i++];
+            while (j < right) dst[k++] = src[j++];
+        }
+
+        SortEntry* temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    if (src != entries) {
+        memcpy(entries, src, count * sizeof(SortEntry));
+    }
+    free(buffer);
+    return 0;
+}
+
+// 按某列对行号数组做稳定排序: 数值列走基数排序，字符串列走归并排序
+int sort_row_ids(const Table* table, int col_index, SortDirection direction, int* rows, int count) {
+    if (table == NULL || rows == NULL) {
+        return -1;
+    }
+    if (count < 2) {
+        return 0;
+    }
+
+    SortEntry* entries = malloc(count * sizeof(SortEntry));
+    if (entries == NULL) {
+        return -1;
+    }
+
+    int status = build_sort_entries(table, col_index, direction, rows, count, entries);
+    if (status == 0) {
+        if (is_numeric_column(table, col_index)) {
+            status = radix_sort_entries(entries, count);
+        } else {
+            status = merge_sort_entries(entries, count, direction);
+        }
+    }
+
+    if (status == 0) {
+        for (int i = 0; i < count; i++) {
+            rows[i] = entries[i].row;
+        }
+    }
+    free(entries);
+    return status;
+}
+
+// 多列排序: 从最后一列往前依次做稳定排序，排完后先按第一列、相同时再按后面的列有序
+int sort_row_ids_by(const Table* table, const SortColumn* keys, int key_count, int* rows, int count) {
+    if (keys == NULL || key_count < 1) {
+        return -1;
+    }
+    for (int k = key_count - 1; k >= 0; k--) {
+        if (sort_row_ids(table, keys[k].col_index, keys[k].direction, rows, count) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+
+
+// 堆中的元素: 排序项 + 在输入流中的位置 (用于保持与稳定排序相同的并列顺序)
+typedef struct {
+    SortEntry entry;
+    int position;
+} HeapItem;
+
+// 堆的排序方式: 第一列的排序键预先算好，其余列只在第一列相同时才比较
+typedef struct {
+    const Table* table;
+    const SortColumn* keys;
+    int key_count;
+} HeapOrder;
+
+// 按某一列比较两行
+static int compare_rows(const Table* table, const SortColumn* key, int a, int b) {
+    int rows[2] = { a, b };
+    SortEntry entries[2];
+    build_sort_entries(table, key->col_index, key->direction, rows, 2, entries);
+    return compare_sort_entries(&entries[0], &entries[1], key->direction);
+}
+
+// a排在b之后时返回正数
+static int compare_heap_items(const HeapItem* a, const HeapItem* b, const HeapOrder* order) {
+    int cmp = compare_sort_entries(&a->entry, &b->entry, order->keys[0].direction);
+    for (int k = 1; cmp == 0 && k < order->key_count; k++) {
+        cmp = compare_rows(order->table, &order->keys[k], a->entry.row, b->entry.row);
+    }
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (a->position > b->position) - (a->position < b->position);
+}
+
+static void heap_sift_down(HeapItem* heap, int size, int i, const HeapOrder* order) {
+    while (1) {
+        int largest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < size && compare_heap_items(&heap[left], &heap[largest], order) > 0) {
+            largest = left;
+        }
+        if (right < size && compare_heap_items(&heap[right], &heap[largest], order) > 0) {
+            largest = right;
+        }
+        if (largest == i) {
+            return;
+        }
+        HeapItem temp = heap[i];
+        heap[i] = heap[largest];
+        heap[largest] = temp;
+        i = largest;
+    }
+}
+
+static void heap_sift_up(HeapItem* heap, int i, const HeapOrder* order) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (compare_heap_items(&heap[i], &heap[parent], order) <= 0) {
+            return;
+        }
+        HeapItem temp = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = temp;
+        i = parent;
+    }
+}
+
+// ORDER BY ... LIMIT k: 用大小为k的大顶堆流式扫描，O(n log k)时间、O(k)内存
+// rows为NULL时表示行号0..count-1，结果按排序顺序写入out
+int top_n_row_ids(const Table* table, const SortColumn* keys, int key_count,
+                  const int* rows, int count, int limit, int* out, int* out_count) {
+    if (table == NULL || keys == NULL || key_count < 1 || out == NULL || out_count == NULL) {
+        return -1;
+    }
+    for (int k = 0; k < key_count; k++) {
+        if (keys[k].col_index < 0 || keys[k].col_index >= table->col_count) {
+            return -1;
+        }
+    }
+    HeapOrder order = { table, keys, key_count };
+
+    *out_count = 0;
+    if (limit <= 0 || count <= 0) {
+        return 0;
+    }
+    if (limit > count) {
+        limit = count;
+    }
+
+    HeapItem* heap = malloc(limit * sizeof(HeapItem));
+    if (heap == NULL) {
+        return -1;
+    }
+
+    int batch_rows[TOP_N_BATCH];
+    SortEntry batch[TOP_N_BATCH];
+    int size = 0;
+
+    for (int start = 0; start < count; start += TOP_N_BATCH) {
+        int n = (count - start < TOP_N_BATCH) ? count - start : TOP_N_BATCH;
+        for (int i = 0; i < n; i++) {
+            batch_rows[i] = (rows != NULL) ? rows[start + i] : start + i;
+        }
+        if (build_sort_entries(table, keys[0].col_index, keys[0].direction, batch_rows, n, batch) != 0) {
+            free(heap);
+            return -1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            HeapItem item;
+            item.entry = batch[i];
+            item.position = start + i;
+
+            if (size < limit) {
+                heap[size] = item;
+                heap_sift_up(heap, size, &order);
+                size++;
+            } else if (compare_heap_items(&item, &heap[0], &order) < 0) {
+                // 比堆中最差的元素更好，替换堆顶
+                heap[0] = item;
+                heap_sift_down(heap, size, 0, &order);
+            }
+        }
+    }
+
+    // 依次弹出堆顶，从后往前填充得到升序结果
+    for (int i = size - 1; i >= 0; i--) {
+        out[i] = heap[0].entry.row;
+        heap[0] = heap[i];
+        heap_sift_down(heap, i, 0, &order);
+    }
+
+    *out_count = size;
+    free(heap);
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <stdint.h>
+#include "table.h"
+
+// 排序键: 数值列为保序的64位整数，字符串列为前8字节的大端前缀
+typedef struct {
+    uint64_t key;
+    const char* str;   // 字符串列的完整值，数值列为NULL
+    int row;
+} SortEntry;
+
+// 多列排序中的一列: 前面的列相同时才比较后面的列
+typedef struct {
+    int col_index;
+    SortDirection direction;
+} SortColumn;
+
+// 排序函数
+int sort_row_ids(const Table* table, int col_index, SortDirection direction, int* rows, int count);
+int sort_row_ids_by(const Table* table, const SortColumn* keys, int key_count, int* rows, int count);
+int build_sort_entries(const Table* table, int col_index, SortDirection direction,
+                       const int* rows, int count, SortEntry* entries);
+int compare_sort_entries(const SortEntry* a, const SortEntry* b, SortDirection direction);
+int top_n_row_ids(const Table* table, const SortColumn* keys, int key_count,
+                  const int* rows, int count, int limit, int* out, int* out_count);
+
+// 数值的保序键: 无符号比较的结果与数值比较一致 (-0.0与0.0相同)
+uint64_t sort_key_int(long long value);
+uint64_t sort_key_double(double value);
+
+#endif // SORT_H
@@ -0,0 +1,279 @@
+#include "stats.h"
+#include "column_store.h"
+#include "hash.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// HyperLogLog: 哈希的高HLL_BITS位选寄存器，寄存器记录其余位中第一个1出现的最远位置
+static void hll_add(unsigned char* registers, uint64_t hash) {
+    int index = (int)(hash >> (64 - HLL_BITS));
+    uint64_t rest = hash << HLL_BITS;
+    int rank = 1;
+    while (rank <= 64 - HLL_BITS && (rest & (1ULL << 63)) == 0) {
+        rest <<= 1;
+        rank++;
+    }
+    if (rank > registers[index]) {
+        registers[index] = (unsigned char)rank;
+    }
+}
+
+// 调和平均估计；基数小时空寄存器还多，改用线性计数
+static double hll_estimate(const unsigned char* registers) {
+    double m = HLL_REGISTERS;
+    double sum = 0.0;
+    int zeros = 0;
+    for (int i = 0; i < HLL_REGISTERS; i++) {
+        sum += ldexp(1.0, -registers[i]);
+        if (registers[i] == 0) {
+            zeros++;
+        }
+    }
+    double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log(m / zeros);
+    }
+    return estimate;
+}
+
+// 与哈希索引一致: 类型化数值列按数值取哈希 (-0.0与0.0相同)，其余列按单元格文本
+static uint64_t cell_hash(const Table* table, const ColumnVector* column, int col, int row) {
+    if (column != NULL && column->type == TYPE_INT) {
+        return hash_u64((uint64_t)column->ints[row]);
+    }
+    if (column != NULL && column->type == TYPE_FLOAT) {
+        double value = column->floats[row];
+        if (value == 0.0) {
+            value = 0.0;
+        }
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return hash_u64(bits);
+    }
+    return hash_string(table->data[row][col]);
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// 数值列: 非空值排序后每隔 n/STATS_BUCKETS 个取一个边界
+static int build_histogram(ColumnStats* stats, const ColumnVector* column, int row_count) {
+    double* values = malloc((row_count > 0 ? row_count : 1) * sizeof(double));
+    if (values == NULL) {
+        return -1;
+    }
+    int count = 0;
+    for (int row = 0; row < row_count; row++) {
+        if (!column->nulls[row]) {
+            double value = column_get_double(column, row);
+            if (!isnan(value)) {
+                values[count++] = value;
+            }
+        }
+    }
+
+    if (count > 0) {
+        qsort(values, count, sizeof(double), compare_doubles);
+        stats->min = values[0];
+        stats->max = values[count - 1];
+        stats->bucket_count = STATS_BUCKETS;
+        for (int i = 0; i <= STATS_BUCKETS; i++) {
+            stats->bounds[i] = values[(long long)i * (count - 1) / STATS_BUCKETS];
+        }
+    }
+    free(values);
+    return 0;
+}
+
+static void copy_text(char* out, const char* text) {
+    strncpy(out, text, MAX_CELL_LEN - 1);
+    out[MAX_CELL_LEN - 1] = '\0';
+}
+
+static int analyze_column(ColumnStats* stats, const Table* table, int col) {
+    const ColumnVector* column = (table->store != NULL) ? &table->store->columns[col] : NULL;
+    unsigned char registers[HLL_REGISTERS];
+    const char* min_text = NULL;
+    const char* max_text = NULL;
+
+    memset(registers, 0, sizeof(registers));
+    stats->numeric = (column != NULL && column_is_numeric(column));
+    for (int row = 0; row < table->row_count; row++) {
+        if ((column != NULL) ? column->nulls[row] : table->data[row][col] == NULL) {
+            stats->null_count++;
+            continue;
+        }
+        hll_add(registers, cell_hash(table, stats->numeric ? column : NULL, col, row));
+        if (!stats->numeric) {
+            const char* cell = table->data[row][col];
+            if (min_text == NULL || strcmp(cell, min_text) < 0) {
+                min_text = cell;
+            }
+            if (max_text == NULL || strcmp(cell, max_text) > 0) {
+                max_text = cell;
+            }
+        }
+    }
+
+    int non_null = table->row_count - stats->null_count;
+    stats->distinct = hll_estimate(registers);
+    if (stats->distinct > non_null) {
+        stats->distinct = non_null;
+    }
+    if (stats->distinct < 1.0 && non_null > 0) {
+        stats->distinct = 1.0;
+    }
+
+    if (min_text != NULL) {
+        copy_text(stats->min_text, min_text);
+        copy_text(stats->max_text, max_text);
+    }
+    return stats->numeric ? build_histogram(stats, column, table->row_count) : 0;
+}
+
+int analyze_table(Table* table) {
+    if (table == NULL) {
+        return -1;
+    }
+    TableStats* stats = calloc(1, sizeof(TableStats));
+    if (stats == NULL) {
+        return -1;
+    }
+    stats->row_count = table->row_count;
+    for (int col = 0; col < table->col_count; col++) {
+        if (analyze_column(&stats->columns[col], table, col) != 0) {
+            free(stats);
+            return -1;
+        }
+    }
+
+    free_table_stats(table);
+    table->stats = stats;
+    return 0;
+}
+
+void free_table_stats(Table* table) {
+    if (table != NULL) {
+        free(table->stats);
+        table->stats = NULL;
+    }
+}
+
+const ColumnStats* table_column_stats(const Table* table, int col_index) {
+    if (table == NULL || table->stats == NULL || table->stats->row_count != table->row_count ||
+        col_index < 0 || col_index >= table->col_count || table->row_count == 0) {
+        return NULL;
+    }
+    return &table->stats->columns[col_index];
+}
+
+// 非空数值中小于等于x的比例，桶内按线性插值
+static double histogram_fraction(const ColumnStats* stats, double x) {
+    const double* bounds = stats->bounds;
+    if (x < bounds[0]) {
+        return 0.0;
+    }
+    if (x >= bounds[stats->bucket_count]) {
+        return 1.0;
+    }
+    int bucket = stats->bucket_count - 1;
+    while (bounds[bucket] > x) {
+        bucket--;
+    }
+    double within = (x - bounds[bucket]) / (bounds[bucket + 1] - bounds[bucket]);
+    return (bucket + within) / stats->bucket_count;
+}
+
+static double clamp_fraction(double value) {
+    return (value < 0.0) ? 0.0 : (value > 1.0) ? 1.0 : value;
+}
+
+// 等值: 非空值平均分到各个不同值上；数值常量不在[min, max]内时没有行满足
+static double equal_fraction(const ColumnStats* stats, const CompiledPredicate* predicate, double non_null) {
+    if (stats->distinct < 1.0) {
+        return 0.0;
+    }
+    if (stats->numeric && stats->bucket_count > 0 && predicate->column != NULL &&
+        (predicate->float_value < stats->min || predicate->float_value > stats->max)) {
+        return 0.0;
+    }
+    return non_null / stats->distinct;
+}
+
+// 类型化数值列的范围比较: 直方图估计非空值部分，空值按0参与比较
+static double range_fraction(const ColumnStats* stats, const CompiledPredicate* predicate, double non_null,
+                             double null_fraction) {
+    double equal = equal_fraction(stats, predicate, 1.0);
+    double below = histogram_fraction(stats, predicate->float_value);
+    double fraction;
+    int zero_matches;
+
+    switch (predicate->op) {
+        case OP_GREATER:
+            fraction = 1.0 - below;
+            zero_matches = 0.0 > predicate->float_value;
+            break;
+        case OP_GREATER_EQUAL:
+            fraction = 1.0 - below + equal;
+            zero_matches = 0.0 >= predicate->float_value;
+            break;
+        case OP_LESS:
+            fraction = below - equal;
+            zero_matches = 0.0 < predicate->float_value;
+            break;
+        case OP_LESS_EQUAL:
+            fraction = below;
+            zero_matches = 0.0 <= predicate->float_value;
+            break;
+        default:   // OP_BETWEEN
+            fraction = histogram_fraction(stats, predicate->float_high) - below + equal;
+            zero_matches = 0.0 >= predicate->float_value && 0.0 <= predicate->float_high;
+            break;
+    }
+    return clamp_fraction(fraction) * non_null + (zero_matches ? null_fraction : 0.0);
+}
+
+double stats_predicate_selectivity(const Table* table, const CompiledPredicate* predicate) {
+    const ColumnStats* stats = table_column_stats(table, predicate->col_index);
+    if (stats == NULL) {
+        return -1.0;
+    }
+    double null_fraction = (double)stats->null_count / table->row_count;
+    double non_null = 1.0 - null_fraction;
+
+    switch (predicate->op) {
+        case OP_EQUAL:
+            return clamp_fraction(equal_fraction(stats, predicate, non_null));
+        case OP_NOT_EQUAL:
+            // 类型化数值列的不等比较中空值算作满足
+            return clamp_fraction((predicate->column != NULL && stats->numeric ? 1.0 : non_null) -
+                                  equal_fraction(stats, predicate, non_null));
+        case OP_IN: {
+            int count = (predicate->set != NULL) ? predicate->set->count : 1;
+            double each = (stats->distinct >= 1.0) ? non_null / stats->distinct : 0.0;
+            return clamp_fraction((count < stats->distinct ? count : stats->distinct) * each);
+        }
+        case OP_LIKE:
+            if (predicate->like != NULL && predicate->like->kind == LIKE_EXACT) {
+                return clamp_fraction(equal_fraction(stats, predicate, non_null));
+            }
+            return -1.0;
+        default:
+            if (stats->bucket_count == 0 || predicate->column == NULL || !column_is_numeric(predicate->column)) {
+                return -1.0;
+            }
+            return clamp_fraction(range_fraction(stats, predicate, non_null, null_fraction));
+    }
+}
+
+int stats_key_rows(const Table* table, int col_index) {
+    const ColumnStats* stats = table_column_stats(table, col_index);
+    if (stats == NULL) {
+        return (table != NULL) ? table->row_count : 0;
+    }
+    return table->row_count - stats->null_count;
+}
@@ -0,0 +1,43 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "table.h"
+#include "predicate.h"
+
+#define STATS_BUCKETS 32                // 等深直方图的桶数
+#define HLL_BITS 12                     // HyperLogLog用哈希的高12位选寄存器
+#define HLL_REGISTERS (1 << HLL_BITS)   // 4096个寄存器，标准误差约1.6%
+
+// ANALYZE收集的单列统计信息 (行数见TableStats)
+typedef struct {
+    int null_count;
+    int numeric;                        // 类型化数值列: 最小/最大值和直方图按数值
+    double min;                         // 数值列非空值的范围 (NaN不计入)
+    double max;
+    char min_text[MAX_CELL_LEN];        // 字符串列非空值按strcmp的最小/最大值
+    char max_text[MAX_CELL_LEN];
+    double bounds[STATS_BUCKETS + 1];   // 等深直方图的桶边界: 每桶约有相同数量的非空值
+    int bucket_count;                   // 0表示没有直方图 (字符串列或没有非空数值)
+    double distinct;                    // HyperLogLog估计的非空不同值个数
+} ColumnStats;
+
+// 表的统计信息，挂在 Table.stats 上
+typedef struct TableStats {
+    int row_count;                      // ANALYZE时的行数，之后表又追加了行则统计信息不再使用
+    ColumnStats columns[MAX_COLUMNS];
+} TableStats;
+
+// 收集表的统计信息 (替换原有的)，成功返回0
+int analyze_table(Table* table);
+void free_table_stats(Table* table);
+
+// 某列可用的统计信息，没有收集或已过期时返回NULL
+const ColumnStats* table_column_stats(const Table* table, int col_index);
+
+// 按统计信息估计谓词的满足比例，没有可用的统计信息时返回-1
+double stats_predicate_selectivity(const Table* table, const CompiledPredicate* predicate);
+
+// 某列非空值的行数 (连接时建哈希表的行数)，没有统计信息时返回表的行数
+int stats_key_rows(const Table* table, int col_index);
+
+#endif // STATS_H
@@ -4,11 +4,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "arena.h"
 
 #define MAX_COLUMNS 50
 #define MAX_COLUMN_NAME_LEN 50
 #define MAX_CELL_LEN 100
 #define INITIAL_CAPACITY 100
+#define ZONE_ROWS 65536   // 区域映射每块的行数 (按批过滤的批大小的整数倍)
 
 // 列数据类型枚举
 typedef enum {
@@ -24,14 +26,51 @@ typedef struct {
     DataType type;
 } Column;
 
+// 列式存储中的单列: 按类型保存在一段连续数组中
+typedef struct {
+    DataType type;          // 实际存储类型 (INT/FLOAT/STRING)
+    long long* ints;        // TYPE_INT 的值
+    double* floats;         // TYPE_FLOAT 的值
+    size_t* offsets;        // TYPE_STRING: 每行字符串在heap中的偏移
+    char* heap;             // TYPE_STRING: 连续的字符串堆
+    size_t heap_size;
+    size_t heap_capacity;
+    unsigned char* nulls;   // 1 表示空值
+} ColumnVector;
+
+// 区域映射: 数值列每ZONE_ROWS行一块的最小/最大值和空值数，过滤时跳过不可能有行满足条件的整块
+// 空值按数组中存的0计入最小/最大值 (范围比较也按0处理)，NaN不计入
+typedef struct {
+    double* mins;
+    double* maxs;
+    int* null_counts;
+    int count;      // 块数，字符串列为0
+    int capacity;
+} ZoneMap;
+
+// 列式存储: 每列一个类型化向量
+typedef struct {
+    ColumnVector columns[MAX_COLUMNS];
+    ZoneMap zones[MAX_COLUMNS];   // 总是在堆上，快照打开时重新计算
+    int row_count;
+    int capacity;
+    int mapped;   // 1 表示数组指向快照文件的映射，不能realloc/free
+} ColumnStore;
+
 // 表格结构
 typedef struct {
     char name[100];
     Column columns[MAX_COLUMNS];
     int col_count;
-    char*** data;  // 三维数组: data[row][col][cell]
+    char*** data;  // 三维数组: data[row][col][cell]，列式存储的行视图
     int row_count;
     int capacity;
+    ColumnStore* store;  // 类型化列存储 (NULL表示尚未建立)
+    Arena* arena;        // 行数组和单元格字符串的内存
+    void* mapping;       // 从快照打开时的文件映射 (NULL表示无)
+    size_t mapping_size;
+    struct TableIndex* indexes;  // CREATE INDEX建立的索引链表 (见index.h)
+    struct TableStats* stats;    // ANALYZE收集的统计信息 (见stats.h)，NULL表示尚未收集
 } Table;
 
 // 查询类型枚举
@@ -39,9 +78,18 @@ typedef enum {
     QUERY_SELECT,
     QUERY_FILTER,
     QUERY_AGGREGATE,
-    QUERY_SORT
+    QUERY_SORT,
+    QUERY_CREATE_INDEX,
+    QUERY_ANALYZE
 } QueryType;
 
+// EXPLAIN前缀
+typedef enum {
+    EXPLAIN_NONE,
+    EXPLAIN_PLAN,       // EXPLAIN: 只输出执行计划和估计值
+    EXPLAIN_ANALYZE     // EXPLAIN ANALYZE: 执行查询并记录每个算子的实测
+} ExplainMode;
+
 // 聚合函数类型
 typedef enum {
     AGG_NONE,
@@ -58,6 +106,12 @@ typedef enum {
     SORT_DESC
 } SortDirection;
 
+// ORDER BY中的一个排序列
+typedef struct {
+    char column[MAX_COLUMN_NAME_LEN];
+    SortDirection direction;
+} OrderKey;
+
 // 条件操作符
 typedef enum {
     OP_EQUAL,
@@ -66,14 +120,30 @@ typedef enum {
     OP_LESS,
     OP_GREATER_EQUAL,
     OP_LESS_EQUAL,
-    OP_LIKE
+    OP_LIKE,
+    OP_BETWEEN,      // value <= x <= value2
+    OP_IN            // x 属于 in_values
 } Operator;
 
-// 条件结构
+// 条件节点类型: 比较叶子或布尔运算
+typedef enum {
+    COND_COMPARE,
+    COND_AND,
+    COND_OR,
+    COND_NOT
+} ConditionKind;
+
+// 条件结构 (表达式树)
 typedef struct Condition {
+    ConditionKind kind;
     char column[MAX_COLUMN_NAME_LEN];
     Operator op;
     char value[MAX_CELL_LEN];
+    char value2[MAX_CELL_LEN];  // BETWEEN的上界
+    char** in_values;           // IN列表
+    int in_count;
+    struct Condition* left;   // AND/OR的左子树，NOT的操作数
+    struct Condition* right;  // AND/OR的右子树
     struct Condition* next;  // 用于AND条件链
 } Condition;
 
@@ -81,15 +151,24 @@ typedef struct Condition {
 typedef struct {
     QueryType type;
     char table_name[100];
+    char table_alias[MAX_COLUMN_NAME_LEN];
+    char join_table[100];                      // INNER JOIN的右表，空表示没有连接
+    char join_alias[MAX_COLUMN_NAME_LEN];
+    char join_left[MAX_COLUMN_NAME_LEN];       // ON join_left = join_right
+    char join_right[MAX_COLUMN_NAME_LEN];
     char columns[MAX_COLUMNS][MAX_COLUMN_NAME_LEN];
     int column_count;
     Condition* where_conditions;
-    char group_by[MAX_COLUMN_NAME_LEN];
-    AggregateType aggregate;
-    char aggregate_column[MAX_COLUMN_NAME_LEN];
-    char order_by[MAX_COLUMN_NAME_LEN];
-    SortDirection sort_dir;
+    AggregateType aggregates[MAX_COLUMNS];  // 与columns对应，AGG_NONE表示普通列；COUNT(*)的列名为"*"
+    int aggregate_count;
+    char group_by[MAX_COLUMNS][MAX_COLUMN_NAME_LEN];
+    int group_by_count;
+    OrderKey order_by[MAX_COLUMNS];        // ORDER BY的各列，前面的列优先
+    int order_by_count;
     int limit;
+    char index_name[MAX_COLUMN_NAME_LEN];  // CREATE INDEX的索引名，索引列在columns[0]
+    char index_method[16];                 // USING后的索引方法 (大写)，空表示默认的HASH
+    ExplainMode explain;
 } Query;
 
 // 查询结果结构
@@ -104,6 +183,7 @@ typedef struct {
 Table* create_table(const char* name, int col_count, const char** col_names);
 void free_table(Table* table);
 int add_row(Table* table, const char** row_data);
+int add_row_len(Table* table, const char** row_data, const int* lengths);
 void print_table(const Table* table);
 int get_column_index(const Table* table, const char* column_name);
 
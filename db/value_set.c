@@ -0,0 +1,146 @@
+#include "value_set.h"
+#include "hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_SET_CAPACITY 8
+
+static int allocate_slots(ValueSet* set, int capacity) {
+    set->keys = calloc(capacity, sizeof(uint64_t));
+    set->used = calloc(capacity, sizeof(unsigned char));
+    set->strings = (set->type == TYPE_STRING) ? calloc(capacity, sizeof(const char*)) : NULL;
+    set->capacity = capacity;
+    set->count = 0;
+    if (set->keys == NULL || set->used == NULL || (set->type == TYPE_STRING && set->strings == NULL)) {
+        free(set->keys);
+        free(set->used);
+        free(set->strings);
+        return -1;
+    }
+    return 0;
+}
+
+ValueSet* create_value_set(DataType type, int expected) {
+    ValueSet* set = calloc(1, sizeof(ValueSet));
+    if (set == NULL) {
+        return NULL;
+    }
+    set->type = (type == TYPE_INT || type == TYPE_FLOAT) ? type : TYPE_STRING;
+
+    // 装载因子不超过1/2
+    int capacity = MIN_SET_CAPACITY;
+    while (capacity < expected * 2) {
+        capacity *= 2;
+    }
+    if (allocate_slots(set, capacity) != 0) {
+        free(set);
+        return NULL;
+    }
+    return set;
+}
+
+void free_value_set(ValueSet* set) {
+    if (set == NULL) {
+        return;
+    }
+    free(set->keys);
+    free(set->used);
+    free(set->strings);
+    free(set);
+}
+
+// 返回key所在的槽位，不存在时返回应插入的空槽位
+static int find_slot(const ValueSet* set, uint64_t key, uint64_t hash, const char* str) {
+    int mask = set->capacity - 1;
+    int slot = (int)(hash & mask);
+    while (set->used[slot]) {
+        if (set->keys[slot] == key && (str == NULL || strcmp(set->strings[slot], str) == 0)) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int insert_key(ValueSet* set, uint64_t key, uint64_t hash, const char* str);
+
+static int grow_set(ValueSet* set) {
+    ValueSet old = *set;
+    if (allocate_slots(set, old.capacity * 2) != 0) {
+        *set = old;
+        return -1;
+    }
+
+    for (int i = 0; i < old.capacity; i++) {
+        if (old.used[i]) {
+            const char* str = (old.strings != NULL) ? old.strings[i] : NULL;
+            uint64_t hash = (str != NULL) ? old.keys[i] : hash_u64(old.keys[i]);
+            insert_key(set, old.keys[i], hash, str);
+        }
+    }
+    free(old.keys);
+    free(old.used);
+    free(old.strings);
+    return 0;
+}
+
+static int insert_key(ValueSet* set, uint64_t key, uint64_t hash, const char* str) {
+    if ((set->count + 1) * 2 > set->capacity && grow_set(set) != 0) {
+        return -1;
+    }
+
+    int slot = find_slot(set, key, hash, str);
+    if (!set->used[slot]) {
+        set->used[slot] = 1;
+        set->keys[slot] = key;
+        if (str != NULL) {
+            set->strings[slot] = str;
+        }
+        set->count++;
+    }
+    return 0;
+}
+
+// double按位比较前把-0.0统一成0.0
+static uint64_t float_key(double value) {
+    uint64_t bits;
+    if (value == 0.0) {
+        value = 0.0;
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+int value_set_add_int(ValueSet* set, long long value) {
+    uint64_t key = (uint64_t)value;
+    return insert_key(set, key, hash_u64(key), NULL);
+}
+
+int value_set_add_float(ValueSet* set, double value) {
+    if (value != value) {
+        return 0;   // NaN不等于任何值
+    }
+    uint64_t key = float_key(value);
+    return insert_key(set, key, hash_u64(key), NULL);
+}
+
+int value_set_add_string(ValueSet* set, const char* value) {
+    uint64_t hash = hash_string(value);
+    return insert_key(set, hash, hash, value);
+}
+
+int value_set_contains_int(const ValueSet* set, long long value) {
+    uint64_t key = (uint64_t)value;
+    return set->used[find_slot(set, key, hash_u64(key), NULL)];
+}
+
+int value_set_contains_float(const ValueSet* set, double value) {
+    uint64_t key = float_key(value);
+    return set->used[find_slot(set, key, hash_u64(key), NULL)];
+}
+
+int value_set_contains_string(const ValueSet* set, const char* value) {
+    uint64_t hash = hash_string(value);
+    return set->used[find_slot(set, hash, hash, value)];
+}
@@ -0,0 +1,27 @@
+#ifndef VALUE_SET_H
+#define VALUE_SET_H
+
+#include <stdint.h>
+#include "table.h"
+
+// IN列表的哈希集合: 开放寻址 + 线性探测，每行查找O(1)
+typedef struct {
+    DataType type;           // TYPE_INT/TYPE_FLOAT 按数值比较，TYPE_STRING 按字符串比较
+    uint64_t* keys;          // 数值的位模式，字符串为哈希值
+    const char** strings;    // TYPE_STRING: 原始字符串 (不复制，由调用者保证生命周期)
+    unsigned char* used;
+    int capacity;            // 2的幂
+    int count;
+} ValueSet;
+
+// 集合操作函数
+ValueSet* create_value_set(DataType type, int expected);
+void free_value_set(ValueSet* set);
+int value_set_add_int(ValueSet* set, long long value);
+int value_set_add_float(ValueSet* set, double value);
+int value_set_add_string(ValueSet* set, const char* value);
+int value_set_contains_int(const ValueSet* set, long long value);
+int value_set_contains_float(const ValueSet* set, double value);
+int value_set_contains_string(const ValueSet* set, const char* value);
+
+#endif // VALUE_SET_H
@@ -0,0 +1,115 @@
+#include "view.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+TableView* create_table_view(const Table* base) {
+    if (base == NULL) {
+        return NULL;
+    }
+
+    TableView* view = malloc(sizeof(TableView));
+    if (view == NULL) {
+        return NULL;
+    }
+
+    view->base = base;
+    view->rows = NULL;
+    view->row_count = base->row_count;
+    view->col_count = base->col_count;
+    for (int i = 0; i < base->col_count; i++) {
+        view->col_map[i] = i;
+        strcpy(view->col_names[i], base->columns[i].name);
+    }
+
+    return view;
+}
+
+void free_table_view(TableView* view) {
+    if (view == NULL) {
+        return;
+    }
+
+    free(view->rows);
+    free(view);
+}
+
+// 视图中第index行对应的基表行号
+int view_row_id(const TableView* view, int index) {
+    return (view->rows != NULL) ? view->rows[index] : index;
+}
+
+// 把隐式的"全部行"展开成显式的选择向量 (排序等需要重排行号的算子使用)
+int view_select_all_rows(TableView* view) {
+    if (view == NULL) {
+        return -1;
+    }
+    if (view->rows != NULL) {
+        return 0;
+    }
+
+    int* rows = malloc((view->row_count > 0 ? view->row_count : 1) * sizeof(int));
+    if (rows == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < view->row_count; i++) {
+        rows[i] = i;
+    }
+    view->rows = rows;
+    return 0;
+}
+
+const char* view_cell(const TableView* view, int index, int col) {
+    int base_col = view->col_map[col];
+    if (base_col < 0) {
+        return NULL;
+    }
+    return view->base->data[view_row_id(view, index)][base_col];
+}
+
+// 只在最后一步把视图复制成结果表
+Table* materialize_view(const TableView* view, const char* name) {
+    if (view == NULL) {
+        return NULL;
+    }
+
+    const char* col_names[MAX_COLUMNS];
+    for (int col = 0; col < view->col_count; col++) {
+        col_names[col] = view->col_names[col];
+    }
+
+    Table* result_table = create_table(name, view->col_count, col_names);
+    if (result_table == NULL) {
+        return NULL;
+    }
+
+    for (int col = 0; col < view->col_count; col++) {
+        int base_col = view->col_map[col];
+        result_table->columns[col].type = (base_col >= 0) ? view->base->columns[base_col].type : TYPE_STRING;
+    }
+
+    // 结果行数已知，行指针数组一次分配
+    if (view->row_count > 0) {
+        result_table->data = malloc(view->row_count * sizeof(char**));
+        if (result_table->data == NULL) {
+            free_table(result_table);
+            return NULL;
+        }
+        result_table->capacity = view->row_count;
+    }
+
+    const char* row_data[MAX_COLUMNS];
+    for (int i = 0; i < view->row_count; i++) {
+        for (int col = 0; col < view->col_count; col++) {
+            const char* cell = view_cell(view, i, col);
+            row_data[col] = (cell != NULL) ? cell : "";
+        }
+
+        if (add_row(result_table, row_data) != 0) {
+            free_table(result_table);
+            return NULL;
+        }
+    }
+
+    return result_table;
+}
@@ -0,0 +1,24 @@
+#ifndef VIEW_H
+#define VIEW_H
+
+#include "table.h"
+
+// 表视图: 基表 + 行号选择向量 + 列映射，算子之间只传递视图，不复制单元格
+typedef struct {
+    const Table* base;
+    int* rows;                  // 选中的基表行号，NULL表示基表全部行
+    int row_count;
+    int col_map[MAX_COLUMNS];   // 输出列 -> 基表列，-1表示基表中不存在的列
+    char col_names[MAX_COLUMNS][MAX_COLUMN_NAME_LEN];
+    int col_count;
+} TableView;
+
+// 视图操作函数
+TableView* create_table_view(const Table* base);
+void free_table_view(TableView* view);
+int view_row_id(const TableView* view, int index);
+int view_select_all_rows(TableView* view);
+const char* view_cell(const TableView* view, int index, int col);
+Table* materialize_view(const TableView* view, const char* name);
+
+#endif // VIEW_H
@@ -17,12 +17,15 @@
 #include "db/parser.h"
 #include "db/executor.h"
 #include "db/csv_loader.h"
+#include "db/catalog.h"
 #include "test_framework/test_runner.h"
 #include "ai/ai_helper.h"
 #include "utils/string_utils.h"
+#include "utils/file_utils.h"
 
 /* 全局变量 */
-Table* cur_table = NULL;
+Catalog* catalog = NULL;   /* 已加载的全部表 */
+Table* cur_table = NULL;   /* 最近加载的表 (属于catalog) */
 
 /* Function prototypes */
 void process_csv_import(void);
@@ -407,19 +410,20 @@ void process_csv_import() {
     char path[150];
     snprintf(path, sizeof(path), "data/%s", filename);
     
-    // Free previous table if exists
-    if (cur_table) 
+    if (catalog == NULL) 
     {
-        free_table(cur_table);
-        cur_table = NULL;
+        catalog = create_catalog();
     }
     
-    // Load CSV file
-    cur_table = load_csv(path);
-    if (cur_table) 
+    // Load CSV file into the catalog (a table already loaded is reused, otherwise
+    // a snapshot in $MINIDB_SNAPSHOT_DIR is used when it is set and up to date)
+    Table* table = catalog_load_csv(catalog, path);
+    if (table) 
     {
+        cur_table = table;
         printf("Loaded table '%s' successfully\n", cur_table->name);
         printf("Rows: %d, Columns: %d\n", cur_table->row_count, cur_table->col_count);
+        printf("Tables available for queries: %d\n", catalog->count);
     } 
     else
      {
@@ -457,12 +461,45 @@ void execute_sql_statement()
     printf("4. SELECT with LIKE condition:\n");
     printf("   SELECT * FROM %s WHERE %s LIKE '%%J%%'\n", 
            cur_table->name, cur_table->columns[1].name);
+    printf("5. SELECT with combined conditions:\n");
+    printf("   SELECT * FROM %s WHERE %s > 30 AND (%s LIKE 'J%%' OR NOT %s < 10)\n", 
+           cur_table->name, cur_table->columns[2].name, cur_table->columns[1].name, cur_table->columns[2].name);
+    printf("6. SELECT with ORDER BY and LIMIT:\n");
+    printf("   SELECT * FROM %s ORDER BY %s DESC LIMIT 10\n", 
+           cur_table->name, cur_table->columns[2].name);
+    printf("7. SELECT with GROUP BY and aggregates:\n");
+    printf("   SELECT %s, COUNT(*), SUM(%s), AVG(%s) FROM %s GROUP BY %s\n", 
+           cur_table->columns[1].name, cur_table->columns[2].name, cur_table->columns[2].name,
+           cur_table->name, cur_table->columns[1].name);
+    printf("8. SELECT with INNER JOIN (load both tables first):\n");
+    printf("   SELECT * FROM %s a INNER JOIN other_table b ON a.%s = b.%s\n", 
+           cur_table->name, cur_table->columns[0].name, cur_table->columns[0].name);
+    printf("9. Create an index (hash for = / IN, sorted for ranges and ORDER BY, bitmap for low-cardinality columns, trigram for LIKE):\n");
+    printf("   CREATE INDEX idx_%s ON %s(%s)\n", 
+           cur_table->columns[0].name, cur_table->name, cur_table->columns[0].name);
+    printf("   CREATE INDEX idx_%s ON %s(%s) USING SORTED\n", 
+           cur_table->columns[2].name, cur_table->name, cur_table->columns[2].name);
+    printf("   CREATE INDEX idx_%s ON %s(%s) USING BITMAP\n", 
+           cur_table->columns[1].name, cur_table->name, cur_table->columns[1].name);
+    printf("   CREATE INDEX idx_%s_text ON %s(%s) USING TRIGRAM\n", 
+           cur_table->columns[1].name, cur_table->name, cur_table->columns[1].name);
+    printf("10. Collect column statistics for the planner (row estimates, filter order, index and join choices):\n");
+    printf("   ANALYZE %s\n", cur_table->name);
+    printf("11. Show the query plan (EXPLAIN) or run it and time each operator (EXPLAIN ANALYZE):\n");
+    printf("   EXPLAIN SELECT * FROM %s WHERE %s > 10\n", cur_table->name, cur_table->columns[2].name);
+    printf("   EXPLAIN ANALYZE SELECT %s, COUNT(*) FROM %s GROUP BY %s\n", 
+           cur_table->columns[1].name, cur_table->name, cur_table->columns[1].name);
     printf("\nImportant Notes:\n");
     printf("- Use single quotes for string values: 'John'\n");
-    printf("- Use LIKE with %% for pattern matching: '%%J%%'\n");
-    printf("- Supported operators: =, !=, >, <, >=, <=, LIKE\n");
-    printf("- Currently supports only single WHERE condition (no AND/OR)\n");
-    printf("- For multiple conditions, use separate queries\n");
+    printf("- LIKE patterns: %% matches any characters, _ matches one character: 'J%%', '%%J_n%%'\n");
+    printf("- Supported operators: =, !=, >, <, >=, <=, LIKE, BETWEEN a AND b, IN (a, b, ...)\n");
+    printf("- Combine conditions with AND, OR, NOT and parentheses\n");
+    printf("- Aggregates: COUNT(*), COUNT(col), SUM, AVG, MIN, MAX\n");
+    printf("\nLoaded tables: ");
+    for (int i = 0; i < catalog->count; i++)
+     {
+        printf("%s%s", catalog->tables[i]->name, (i < catalog->count - 1) ? ", " : "");
+    }
     printf("\nAvailable columns: ");
     for (int i = 0; i < cur_table->col_count; i++)
      {
@@ -474,23 +511,31 @@ void execute_sql_statement()
     }
     printf("\n\n");
     
-    char query[512];
+    /* 查询长度不限 (如很长的IN列表)，按行读入可增长的缓冲区 */
     printf("Please enter SQL query: ");
-    fgets(query, sizeof(query), stdin);
+    char* query = read_line(stdin);
+    if (query == NULL)
+     {
+        printf("Query cannot be empty\n");
+        return;
+    }
     trim_string(query);
     
     if (strlen(query) == 0)
      {
         printf("Query cannot be empty\n");
+        free(query);
         return;
     }
     Query* parsed_query = parse_query(query);
     if (parsed_query == NULL)
      {
         printf("SQL syntax error in query: %s\n", query);
+        free(query);
         return;
     }
-    QueryResult* result = execute_query(cur_table, parsed_query);
+    free(query);
+    QueryResult* result = execute_catalog_query(catalog, parsed_query);
     if (result != NULL) 
     {
         print_query_result(result);
@@ -601,10 +646,9 @@ void perform_automated_testing()
     while ((character = getchar()) != '\n' && character != EOF);
 }
 void release_resources() {
-    if (cur_table != NULL) {
-        free_table(cur_table);
-        cur_table = NULL;
-    }
+    free_catalog(catalog);
+    catalog = NULL;
+    cur_table = NULL;
 }
 
 
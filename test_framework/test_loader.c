@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "../utils/file_utils.h"
 
 
 //1
@@ -23,26 +24,26 @@ TestSuite* load_test_suite_from_file(const char* filename) {
         return NULL;
     }
 
-    char buffer[1000];
+    // 按行读入，长度不限 (用例里可能有很长的SQL)
+    char* buffer;
     int line_number = 0;
 
-    while (fgets(buffer, sizeof(buffer), file) != NULL) {
+    while ((buffer = read_line(file)) != NULL) {
         line_number++;
         
         // Skip empty lines and comment lines
-        if (buffer[0] == '#' || buffer[0] == '\n' || buffer[0] == '\r') {
+        if (buffer[0] == '#' || buffer[0] == '\0') {
+            free(buffer);
             continue;
         }
 
-        // Remove newline characters
-        buffer[strcspn(buffer, "\r\n")] = 0;
-
         TestCase* test_case = parse_test_case_line(buffer);
         if (test_case != NULL) {
             add_test_case(suite, test_case);
         } else {
             printf("Warning: Line %d parsing failed: %s\n", line_number, buffer);
         }
+        free(buffer);
     }
 
     fclose(file);
@@ -58,9 +59,11 @@ TestCase* parse_test_case_line(const char* line) {
         return NULL;
     }
 
-    char line_copy[1000];
-    strncpy(line_copy, line, sizeof(line_copy) - 1);
-    line_copy[sizeof(line_copy) - 1] = '\0';
+    char* line_copy = malloc(strlen(line) + 1);
+    if (line_copy == NULL) {
+        return NULL;
+    }
+    strcpy(line_copy, line);
 
     char* tokens[6];
     int token_count = 0;
@@ -73,11 +76,18 @@ TestCase* parse_test_case_line(const char* line) {
     }
 
     if (token_count < 6) {
+        free(line_copy);
+        return NULL;
+    }
+    // SQL放不下时拒绝该用例，不截断
+    if (strlen(tokens[2]) >= MAX_SQL_LEN) {
+        free(line_copy);
         return NULL;
     }
     // Create test case
     TestCase* test_case = create_test_case(tokens[0], tokens[5], parse_test_type(tokens[1]));
     if (test_case == NULL) {
+        free(line_copy);
         return NULL;
     }
 
@@ -94,6 +104,7 @@ TestCase* parse_test_case_line(const char* line) {
     // Set expected row count
     test_case->expected_row_count = atoi(tokens[4]);
 
+    free(line_copy);
     return test_case;
 }
 
@@ -4,6 +4,9 @@
 #include "../db/csv_loader.h"
 #include "../db/parser.h"
 #include "../db/executor.h"
+#include "../db/catalog.h"
+#include "../db/aggregate.h"
+#include "../db/view.h"
 
 // 函数声明
 int run_data_load_test(TestCase* test_case);
@@ -158,6 +161,52 @@ int run_data_load_test(TestCase* test_case) {
 
 
 //test4
+// 在引号外的第一个分号处截断语句，返回下一条语句的开头；后面没有语句时返回NULL
+static char* split_statement(char* text)
+{
+    char quote = '\0';
+    for (char* p = text; *p != '\0'; p++)
+    {
+        if (quote != '\0')
+        {
+            if (*p == quote) quote = '\0';
+        }
+        else if (*p == '\'' || *p == '"')
+        {
+            quote = *p;
+        }
+        else if (*p == ';')
+        {
+            *p = '\0';
+            char* next = p + 1;
+            while (*next == ' ') next++;
+            return (*next != '\0') ? next : NULL;
+        }
+    }
+    return NULL;
+}
+
+// 准备语句 (CREATE INDEX、ANALYZE等) 在数据表上执行，只检查是否成功
+static int run_setup_statement(TestCase* test_case, Table* data_table, const char* sql)
+{
+    Query* query = parse_query(sql);
+    if (query == NULL)
+    {
+        snprintf(test_case->error_message, sizeof(test_case->error_message), "SQL parsing failed: %s", sql);
+        return -1;
+    }
+
+    QueryResult* result = execute_query(data_table, query);
+    int status = (result != NULL && result->success) ? 0 : -1;
+    if (status != 0)
+    {
+        snprintf(test_case->error_message, sizeof(test_case->error_message), "Setup statement failed: %s", sql);
+    }
+    free_query_result(result);
+    free_query(query);
+    return status;
+}
+
 int run_sql_query_test(TestCase* test_case, Table* data_table) 
 {
     if (data_table == NULL) 
@@ -172,17 +221,43 @@ int run_sql_query_test(TestCase* test_case, Table* data_table)
         return -1;
     }
 
-    Query* query = parse_query(test_case->sql_query);
+    // 用分号分开的多条语句: 前面的准备语句依次执行，只校验最后一条的结果
+    char sql[MAX_SQL_LEN];
+    strcpy(sql, test_case->sql_query);
+    char* statement = sql;
+    char* next = split_statement(statement);
+    while (next != NULL)
+    {
+        if (run_setup_statement(test_case, data_table, statement) != 0)
+        {
+            return -1;
+        }
+        statement = next;
+        next = split_statement(statement);
+    }
+
+    Query* query = parse_query(statement);
     if (query == NULL) 
     {
         strcpy(test_case->error_message, "SQL parsing failed");
         return -1;
     }
 
-    QueryResult* result = execute_query(data_table, query);
+    // 连接查询 (如自连接) 通过只含数据表的目录执行；栈上的目录不接管数据表，不调用free_catalog
+    QueryResult* result;
+    if (query->join_table[0] != '\0')
+    {
+        Catalog catalog = { { data_table }, 1 };
+        result = execute_catalog_query(&catalog, query);
+    }
+    else
+    {
+        result = execute_query(data_table, query);
+    }
     if (result == NULL || !result->success) 
     {
         strcpy(test_case->error_message, "Query execution failed");
+        free_query_result(result);
         free_query(query);
         return -1;
     }
@@ -196,11 +271,86 @@ int run_sql_query_test(TestCase* test_case, Table* data_table)
 
 
 //test5
+// 并行聚合与单线程的结果逐个单元格比较 (整数聚合必须完全一致)
+// 视图的行号可以重复，数据表的行被重复到 FUNCTIONAL_MIN_ROWS 行以上，让每个线程都分到行
+#define FUNCTIONAL_MIN_ROWS (256 * 1024)
+#define FUNCTIONAL_THREADS 4
+
+static int compare_result_tables(TestCase* test_case, const Table* expected, const Table* actual)
+{
+    if (expected->row_count != actual->row_count || expected->col_count != actual->col_count)
+    {
+        sprintf(test_case->error_message, "Shape mismatch: %d x %d vs %d x %d",
+                expected->row_count, expected->col_count, actual->row_count, actual->col_count);
+        return -1;
+    }
+    for (int r = 0; r < expected->row_count; r++)
+    {
+        for (int c = 0; c < expected->col_count; c++)
+        {
+            const char* a = expected->data[r][c] ? expected->data[r][c] : "";
+            const char* b = actual->data[r][c] ? actual->data[r][c] : "";
+            if (strcmp(a, b) != 0)
+            {
+                snprintf(test_case->error_message, sizeof(test_case->error_message),
+                         "Row %d column %d differs: %s vs %s", r, c, a, b);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
 int run_functional_test(TestCase* test_case, Table* data_table) 
 {
-    // Simple implementation of functional test
-    strcpy(test_case->error_message, "Functional test not implemented");
-    return -1;
+    if (data_table == NULL || data_table->row_count == 0)
+    {
+        strcpy(test_case->error_message, "Data table not loaded");
+        return -1;
+    }
+
+    Query* query = parse_query(test_case->sql_query);
+    if (query == NULL || query->type != QUERY_AGGREGATE)
+    {
+        strcpy(test_case->error_message, "Functional test needs an aggregate query");
+        free_query(query);
+        return -1;
+    }
+
+    TableView* view = create_table_view(data_table);
+    int copies = (FUNCTIONAL_MIN_ROWS + data_table->row_count - 1) / data_table->row_count;
+    int* rows = (view != NULL) ? malloc((size_t)copies * data_table->row_count * sizeof(int)) : NULL;
+    if (rows == NULL)
+    {
+        strcpy(test_case->error_message, "Out of memory");
+        free_table_view(view);
+        free_query(query);
+        return -1;
+    }
+    for (int i = 0; i < copies * data_table->row_count; i++)
+    {
+        rows[i] = i % data_table->row_count;
+    }
+    view->rows = rows;
+    view->row_count = copies * data_table->row_count;
+
+    Table* serial = aggregate_view_threads(view, query, 1);
+    Table* parallel = aggregate_view_threads(view, query, FUNCTIONAL_THREADS);
+    int test_result = -1;
+    if (serial == NULL || parallel == NULL)
+    {
+        strcpy(test_case->error_message, "Aggregation failed");
+    }
+    else if (compare_result_tables(test_case, serial, parallel) == 0)
+    {
+        test_result = verify_test_result(test_case, parallel);
+    }
+
+    if (serial != NULL) free_table(serial);
+    if (parallel != NULL) free_table(parallel);
+    free_table_view(view);
+    free_query(query);
+    return test_result;
 }
 
 
@@ -7,7 +7,7 @@
 
 #define MAX_TEST_NAME_LEN 100
 #define MAX_TEST_DESC_LEN 256
-#define MAX_SQL_LEN 512
+#define MAX_SQL_LEN 4096
 #define MAX_EXPECTED_ROWS 1000
 
 // 测试用例类型
@@ -140,4 +140,40 @@ long get_file_size(const char* filename) {
     fclose(file);
 
     return size;
-}
\ No newline at end of file
+}
+// 读取一整行 (长度不限)，去掉行尾换行符；返回malloc的字符串，文件结束时返回NULL，由调用者free
+char* read_line(FILE* stream) {
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    size_t capacity = 256;
+    size_t length = 0;
+    char* line = malloc(capacity);
+    if (line == NULL) {
+        return NULL;
+    }
+
+    int c;
+    while ((c = fgetc(stream)) != EOF && c != '\n') {
+        if (length + 1 >= capacity) {
+            char* grown = realloc(line, capacity * 2);
+            if (grown == NULL) {
+                free(line);
+                return NULL;
+            }
+            line = grown;
+            capacity *= 2;
+        }
+        line[length++] = (char)c;
+    }
+    if (c == EOF && length == 0) {
+        free(line);
+        return NULL;
+    }
+    if (length > 0 && line[length - 1] == '\r') {
+        length--;
+    }
+    line[length] = '\0';
+    return line;
+}
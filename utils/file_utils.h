@@ -13,5 +13,7 @@ char* read_file_contents(const char* filename);
 int write_file_contents(const char* filename, const char* content);
 int append_to_file(const char* filename, const char* content);
 int create_directory(const char* path);
+// 读取一整行 (长度不限，不含换行符)，返回的字符串由调用者free，文件结束时返回NULL
+char* read_line(FILE* stream);
 
 #endif // FILE_UTILS_H